@@ -0,0 +1,157 @@
+#include <CLI/ArgumentParser.h>
+#include <Core/Bench.h>
+#include <Core/File.h>
+#include <Main/Main.h>
+#include <Ty/Defer.h>
+#include <Ty/Parse.h>
+#include <Ty/StringBuffer.h>
+#include <Ty/StringView.h>
+#include <Ty/System.h>
+#include <Ty/Vector.h>
+#include <Web/FileRouter.h>
+#include <fcntl.h>
+#include <stdlib.h>
+
+// Looks routes up in routers of 10 to 100k routes, in random
+// order, and reports the cycles one FileRouter::find() takes. Every
+// route leads to the same file, which routers share, so the routes
+// cost no file descriptors or mappings.
+
+// NOTE: "/assets/chunk-99999.js" with room to spare.
+static constexpr u32 max_route_size = 32;
+
+static ErrorOr<int> run(int argc, c_string argv[]);
+static ErrorOr<void> bench_find(Core::File& out, StringView file,
+    u32 route_count, u32 lookups);
+static ErrorOr<void> write_routes(StringBuffer& buffer,
+    Vector<StringView>& routes, u32 count);
+
+ErrorOr<int> Main::main(int argc, c_string argv[])
+{
+    // NOTE: Errors out of Main::main are retried, a benchmark that
+    //       failed half way through should not be.
+    auto result = run(argc, argv);
+    if (result.is_error()) {
+        Core::File::stderr()
+            .writeln("Error: "sv, result.error())
+            .ignore();
+        return 1;
+    }
+    return result.value();
+}
+
+static ErrorOr<int> run(int argc, c_string argv[])
+{
+    auto argument_parser = CLI::ArgumentParser();
+
+    c_string program_name = argv[0];
+    TRY(argument_parser.add_flag("--help"sv, "-h"sv,
+        "show help message"sv, [&] {
+            argument_parser.print_usage_and_exit(program_name, 0);
+        }));
+
+    auto lookups_or_error = ErrorOr<u32>(1000000);
+    TRY(argument_parser.add_option("--lookups"sv, "-n"sv,
+        "number"sv, "Lookups per router (default: 1000000)"sv,
+        [&](auto argument) {
+            auto count = StringView::from_c_string(argument);
+            lookups_or_error = Parse<u32>::from(count).or_throw([] {
+                return Error::from_string_literal(
+                    "invalid lookup count", "argument_parser");
+            });
+        }));
+
+    if (auto result = argument_parser.run(argc, argv);
+        result.is_error()) {
+        TRY(result.error().show());
+        return 1;
+    }
+    auto lookups = TRY(lookups_or_error);
+    if (lookups == 0)
+        lookups = 1;
+
+    char file[] = "/tmp/bench-file-router-XXXXXX";
+    auto fd = ::mkstemp(file);
+    if (fd < 0)
+        return Error::from_errno();
+    System::close(fd).ignore();
+    Defer remove_file = [&] {
+        System::unlink(file).ignore();
+    };
+
+    auto& out = Core::File::stdout();
+    u32 const route_counts[] = { 10, 100, 1000, 10000, 100000 };
+    for (auto route_count : route_counts) {
+        TRY(bench_find(out, StringView::from_c_string(file),
+            route_count, lookups));
+    }
+    TRY(out.flush());
+    return 0;
+}
+
+static ErrorOr<void> bench_find(Core::File& out, StringView file,
+    u32 route_count, u32 lookups)
+{
+    auto router = TRY(Web::FileRouter::create());
+    auto route_buffer
+        = TRY(StringBuffer::create(route_count * max_route_size));
+    auto routes = TRY(Vector<StringView>::create(route_count));
+    TRY(write_routes(route_buffer, routes, route_count));
+    for (auto route : routes)
+        TRY(router.add_route(route, file));
+
+    // NOTE: Looked up by copies, the way request slugs are, so no
+    //       key is found by its address.
+    auto slug_buffer
+        = TRY(StringBuffer::create(route_count * max_route_size));
+    auto slugs = TRY(Vector<StringView>::create(route_count));
+    TRY(write_routes(slug_buffer, slugs, route_count));
+
+    // NOTE: Picked ahead of time, so only the lookups are timed.
+    auto order = TRY(Vector<u32>::create(lookups));
+    u32 state = 2463534242;
+    for (u32 i = 0; i < lookups; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        order.unchecked_append(state % route_count);
+    }
+
+    u32 found = 0;
+    auto bench = Core::Bench(Core::BenchEnableAutoDisplay::No);
+    bench.start();
+    for (auto index : order) {
+        if (router.find(slugs[index]).has_value())
+            found++;
+    }
+    bench.stop();
+    if (found != lookups)
+        return Error::from_string_literal("route not found");
+    auto hit_cycles = (bench.stop_cycle() - bench.start_cycle())
+        / lookups;
+
+    bench.start();
+    for (u32 i = 0; i < lookups; i++) {
+        if (router.find("/assets/missing.js"sv).has_value())
+            found++;
+    }
+    bench.stop();
+    auto miss_cycles = (bench.stop_cycle() - bench.start_cycle())
+        / lookups;
+
+    TRY(out.writeln(route_count, " routes: "sv, hit_cycles,
+        " cycles per hit, "sv, miss_cycles,
+        " cycles per miss"sv));
+    return {};
+}
+
+static ErrorOr<void> write_routes(StringBuffer& buffer,
+    Vector<StringView>& routes, u32 count)
+{
+    for (u32 i = 0; i < count; i++) {
+        auto start = buffer.size();
+        TRY(buffer.write("/assets/chunk-"sv, i, ".js"sv));
+        TRY(routes.append(buffer.view().shrink_from_start(start)));
+    }
+    return {};
+}
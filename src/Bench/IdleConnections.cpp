@@ -0,0 +1,220 @@
+#include <CLI/ArgumentParser.h>
+#include <Core/File.h>
+#include <Main/Main.h>
+#include <Ty/Parse.h>
+#include <Ty/StringView.h>
+#include <Ty/System.h>
+#include <Ty/Vector.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+
+#ifndef IP_BIND_ADDRESS_NO_PORT
+#    define IP_BIND_ADDRESS_NO_PORT 24
+#endif
+
+// Opens idle keep-alive connections to a running server and
+// reports the resident memory they cost it. Every connection has
+// one request answered first, so it is idle the way a browser's
+// connection is between page loads.
+
+// NOTE: A source address runs out of ephemeral ports at about 28k
+//       connections, the rest go out from further along 127/8.
+static constexpr u32 connections_per_source = 25000;
+
+static ErrorOr<int> run(int argc, c_string argv[]);
+static ErrorOr<int> open_connection(u16 port, u32 index);
+static ErrorOr<void> request_and_drain(int socket);
+static ErrorOr<u64> resident_kib(StringView pid);
+
+ErrorOr<int> Main::main(int argc, c_string argv[])
+{
+    // NOTE: Errors out of Main::main are retried, a benchmark that
+    //       failed half way through should not be.
+    auto result = run(argc, argv);
+    if (result.is_error()) {
+        Core::File::stderr()
+            .writeln("Error: "sv, result.error())
+            .ignore();
+        return 1;
+    }
+    return result.value();
+}
+
+static ErrorOr<int> run(int argc, c_string argv[])
+{
+    auto argument_parser = CLI::ArgumentParser();
+
+    c_string program_name = argv[0];
+    TRY(argument_parser.add_flag("--help"sv, "-h"sv,
+        "show help message"sv, [&] {
+            argument_parser.print_usage_and_exit(program_name, 0);
+        }));
+
+    auto port_or_error = ErrorOr<u16>(8080);
+    TRY(argument_parser.add_option("--port"sv, "-p"sv, "number"sv,
+        "Port the server listens on (default: 8080)"sv,
+        [&](auto argument) {
+            auto port = StringView::from_c_string(argument);
+            port_or_error = Parse<u16>::from(port).or_throw([] {
+                return Error::from_string_literal(
+                    "invalid port number", "argument_parser");
+            });
+        }));
+
+    auto count_or_error = ErrorOr<u32>(100000);
+    TRY(argument_parser.add_option("--connections"sv, "-c"sv,
+        "number"sv, "Connections to open (default: 100000)"sv,
+        [&](auto argument) {
+            auto count = StringView::from_c_string(argument);
+            count_or_error = Parse<u32>::from(count).or_throw([] {
+                return Error::from_string_literal(
+                    "invalid connection count", "argument_parser");
+            });
+        }));
+
+    auto server_pid = StringView();
+    TRY(argument_parser.add_positional_argument("server-pid"sv,
+        [&](auto argument) {
+            server_pid = StringView::from_c_string(argument);
+        }));
+
+    if (auto result = argument_parser.run(argc, argv);
+        result.is_error()) {
+        TRY(result.error().show());
+        return 1;
+    }
+    auto port = TRY(port_or_error);
+    auto count = TRY(count_or_error);
+
+    auto limit = TRY(System::getrlimit(RLIMIT_NOFILE));
+    limit.rlim_cur = limit.rlim_max;
+    TRY(System::setrlimit(RLIMIT_NOFILE, limit));
+
+    auto& out = Core::File::stdout();
+    auto before = TRY(resident_kib(server_pid));
+
+    auto sockets = TRY(Vector<int>::create(count));
+    for (u32 i = 0; i < count; i++) {
+        auto socket = TRY(open_connection(port, i));
+        TRY(sockets.append(socket));
+        TRY(request_and_drain(socket));
+    }
+
+    // NOTE: Gives the server time to go idle on the last ones.
+    System::sleep(1);
+    auto after = TRY(resident_kib(server_pid));
+
+    auto grown = after > before ? after - before : 0;
+    TRY(out.writeln("connections: "sv, count));
+    TRY(out.writeln("server rss before: "sv, before, " KiB"sv));
+    TRY(out.writeln("server rss after: "sv, after, " KiB"sv));
+    if (count != 0) {
+        TRY(out.writeln("per connection: "sv,
+            grown * 1024 / count, " bytes"sv));
+    }
+    TRY(out.flush());
+
+    for (auto socket : sockets)
+        System::close(socket).ignore();
+    return 0;
+}
+
+static ErrorOr<int> open_connection(u16 port, u32 index)
+{
+    auto socket = TRY(System::socket(AF_INET, SOCK_STREAM, 0));
+
+    // NOTE: Leaves picking the port to connect(), which only needs
+    //       it to be unique for this destination.
+    TRY(System::setsockopt(socket, IPPROTO_IP,
+        IP_BIND_ADDRESS_NO_PORT, 1));
+    auto source = sockaddr_in {
+        .sin_family = AF_INET,
+        .sin_port = 0,
+        .sin_addr = {
+            .s_addr = htonl(INADDR_LOOPBACK + 1
+                + index / connections_per_source),
+        },
+    };
+    TRY(System::bind(socket, (struct sockaddr*)&source,
+        sizeof(source)));
+
+    auto destination = sockaddr_in {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr = { .s_addr = htonl(INADDR_LOOPBACK) },
+    };
+    TRY(System::connect(socket, (struct sockaddr*)&destination,
+        sizeof(destination)));
+    return socket;
+}
+
+static ErrorOr<void> request_and_drain(int socket)
+{
+    TRY(System::send(socket,
+        "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"sv));
+
+    char buffer[16 * 1024];
+    u32 size = 0;
+    while (true) {
+        if (size == sizeof(buffer)) {
+            return Error::from_string_literal(
+                "response head too large");
+        }
+        auto received = TRY(System::recv(socket, buffer + size,
+            sizeof(buffer) - size, 0));
+        if (received == 0)
+            return Error::from_string_literal("server closed");
+        size += received;
+
+        auto response = StringView(buffer, size);
+        auto head_size = response.find_first("\r\n\r\n"sv);
+        if (!head_size.has_value())
+            continue;
+        auto head = response.part(0, head_size.value());
+        auto length_start = head.find_first("Content-Length: "sv);
+        if (!length_start.has_value())
+            return Error::from_string_literal("no content length");
+        auto length = head.shrink_from_start(length_start.value()
+            + "Content-Length: "sv.size);
+        auto length_end = length.find_first('\r');
+        if (length_end.has_value())
+            length = length.part(0, length_end.value());
+        auto body_size = TRY(Parse<u32>::from(length).or_throw([] {
+            return Error::from_string_literal("bad content length");
+        }));
+
+        auto received_body = size - head_size.value() - 4;
+        while (received_body < body_size) {
+            received = TRY(System::recv(socket, buffer,
+                sizeof(buffer), 0));
+            if (received == 0)
+                return Error::from_string_literal("server closed");
+            received_body += received;
+        }
+        return {};
+    }
+}
+
+static ErrorOr<u64> resident_kib(StringView pid)
+{
+    auto path = TRY(StringBuffer::create_fill("/proc/"sv, pid,
+        "/status"sv, "\0"sv));
+    auto fd = TRY(System::open(path.data(), O_RDONLY));
+    char buffer[4096];
+    auto size = System::read(fd, buffer, sizeof(buffer));
+    System::close(fd).ignore();
+    auto status = StringView(buffer, (u32)TRY(size));
+
+    auto start = status.find_first("VmRSS:"sv);
+    if (!start.has_value())
+        return Error::from_string_literal("no VmRSS in status");
+    auto rss = status.shrink_from_start(start.value() + 6);
+    while (!rss.is_empty() && (rss[0] == ' ' || rss[0] == '\t'))
+        rss = rss.shrink_from_start(1);
+    auto end = rss.find_first(' ');
+    if (end.has_value())
+        rss = rss.part(0, end.value());
+    return TRY(Parse<u64>::from(rss).or_throw([] {
+        return Error::from_string_literal("bad VmRSS");
+    }));
+}
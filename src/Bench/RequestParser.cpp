@@ -0,0 +1,136 @@
+#include <CLI/ArgumentParser.h>
+#include <Core/Bench.h>
+#include <Core/File.h>
+#include <HTTP/Request.h>
+#include <Main/Main.h>
+#include <Ty/Parse.h>
+#include <Ty/StringBuffer.h>
+#include <Ty/StringView.h>
+
+// Parses the same request head over and over and reports the
+// cycles one parse takes, for heads from a bare request line to
+// one with dozens of fields the server does not act on.
+
+static ErrorOr<int> run(int argc, c_string argv[]);
+static ErrorOr<void> bench_parse(Core::File& out, StringView name,
+    StringView head, u32 iterations);
+
+ErrorOr<int> Main::main(int argc, c_string argv[])
+{
+    // NOTE: Errors out of Main::main are retried, a benchmark that
+    //       failed half way through should not be.
+    auto result = run(argc, argv);
+    if (result.is_error()) {
+        Core::File::stderr()
+            .writeln("Error: "sv, result.error())
+            .ignore();
+        return 1;
+    }
+    return result.value();
+}
+
+static ErrorOr<int> run(int argc, c_string argv[])
+{
+    auto argument_parser = CLI::ArgumentParser();
+
+    c_string program_name = argv[0];
+    TRY(argument_parser.add_flag("--help"sv, "-h"sv,
+        "show help message"sv, [&] {
+            argument_parser.print_usage_and_exit(program_name, 0);
+        }));
+
+    auto iterations_or_error = ErrorOr<u32>(1000000);
+    TRY(argument_parser.add_option("--iterations"sv, "-n"sv,
+        "number"sv, "Parses per request head (default: 1000000)"sv,
+        [&](auto argument) {
+            auto count = StringView::from_c_string(argument);
+            iterations_or_error = Parse<u32>::from(count).or_throw(
+                [] {
+                    return Error::from_string_literal(
+                        "invalid iteration count",
+                        "argument_parser");
+                });
+        }));
+
+    if (auto result = argument_parser.run(argc, argv);
+        result.is_error()) {
+        TRY(result.error().show());
+        return 1;
+    }
+    auto iterations = TRY(iterations_or_error);
+    if (iterations == 0)
+        iterations = 1;
+
+    auto& out = Core::File::stdout();
+
+    TRY(bench_parse(out, "minimal"sv,
+        "GET / HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "\r\n"sv,
+        iterations));
+
+    TRY(bench_parse(out, "browser"sv,
+        "GET /assets/style.css HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) "
+        "Gecko/20100101 Firefox/128.0\r\n"
+        "Accept: text/css,*/*;q=0.1\r\n"
+        "Accept-Language: en-US,en;q=0.5\r\n"
+        "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+        "Connection: keep-alive\r\n"
+        "Referer: https://www.example.com/\r\n"
+        "Cookie: session=0123456789abcdef0123456789abcdef\r\n"
+        "Sec-Fetch-Dest: style\r\n"
+        "Sec-Fetch-Mode: no-cors\r\n"
+        "Sec-Fetch-Site: same-origin\r\n"
+        "If-None-Match: \"1fb-edc4db9bc6649a5e\"\r\n"
+        "If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+        "Priority: u=2\r\n"
+        "\r\n"sv,
+        iterations));
+
+    // NOTE: Fields outside of HTTP::Header are only skipped, this
+    //       is most of what the parser spends on them.
+    auto many_fields = TRY(StringBuffer::create_fill(
+        "GET /index.html HTTP/1.1\r\nHost: localhost\r\n"sv));
+    for (u32 i = 0; i < 40; i++) {
+        TRY(many_fields.write("X-Forwarded-Field-"sv, i,
+            ": some value that is not looked at\r\n"sv));
+    }
+    TRY(many_fields.write("\r\n"sv));
+    TRY(bench_parse(out, "many fields"sv, many_fields.view(),
+        iterations));
+
+    TRY(bench_parse(out, "with body"sv,
+        "POST /api/echo HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: 27\r\n"
+        "\r\n"
+        "{\"message\": \"hello world\"}\n"sv,
+        iterations));
+
+    TRY(out.flush());
+    return 0;
+}
+
+static ErrorOr<void> bench_parse(Core::File& out, StringView name,
+    StringView head, u32 iterations)
+{
+    // NOTE: Summed up and printed, so the parses can not be left
+    //       out as unused.
+    u64 parsed_bytes = 0;
+    auto bench = Core::Bench(Core::BenchEnableAutoDisplay::No);
+    bench.start();
+    for (u32 i = 0; i < iterations; i++) {
+        auto request = TRY(HTTP::Request::parse(head));
+        parsed_bytes += request.message_size();
+    }
+    bench.stop();
+
+    auto cycles = bench.stop_cycle() - bench.start_cycle();
+    TRY(out.writeln(name, ": "sv, head.size, " bytes, "sv,
+        cycles / iterations, " cycles per parse, "sv,
+        parsed_bytes / iterations, " bytes parsed"sv));
+    return {};
+}
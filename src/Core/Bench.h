@@ -2,6 +2,8 @@
 #include <Core/File.h>
 #include <Ty/Base.h>
 #include <Ty/Defer.h>
+#include <Ty/StringBuffer.h>
+#include <x86intrin.h>
 
 namespace Core {
 
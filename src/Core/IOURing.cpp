@@ -0,0 +1,212 @@
+#include "IOURing.h"
+#include <Ty/System.h>
+#include <Ty/Verify.h>
+
+namespace Core {
+
+ErrorOr<IOURing> IOURing::create(u32 entries)
+{
+    struct io_uring_params params {};
+    params.flags
+        = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    auto fd = System::io_uring_setup(entries, &params);
+    if (fd.is_error()) {
+        // NOTE: Kernels before 6.0 reject the setup flags, they are
+        //       only hints so retry without them.
+        params = {};
+        fd = TRY(System::io_uring_setup(entries, &params));
+    }
+
+    auto ring = IOURing(fd.release_value());
+    TRY(ring.map_queues(params));
+    return ring;
+}
+
+ErrorOr<void> IOURing::map_queues(
+    struct io_uring_params const& params)
+{
+    m_entries = params.sq_entries;
+
+    auto submission_size
+        = params.sq_off.array + params.sq_entries * sizeof(u32);
+    auto completion_size = params.cq_off.cqes
+        + params.cq_entries * sizeof(CompletionEntry);
+    auto single_mmap
+        = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && completion_size > submission_size)
+        submission_size = completion_size;
+
+    m_ring_memory_size = submission_size;
+    m_ring_memory = TRY(System::mmap(submission_size,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+        IORING_OFF_SQ_RING));
+
+    auto* completion_memory = m_ring_memory;
+    if (!single_mmap) {
+        m_completion_memory_size = completion_size;
+        m_completion_memory = TRY(System::mmap(completion_size,
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+            IORING_OFF_CQ_RING));
+        completion_memory = m_completion_memory;
+    }
+
+    auto* entries = TRY(System::mmap(
+        params.sq_entries * sizeof(SubmissionEntry),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+        IORING_OFF_SQES));
+
+    m_submission = {
+        .head = (u32*)(m_ring_memory + params.sq_off.head),
+        .tail = (u32*)(m_ring_memory + params.sq_off.tail),
+        .array = (u32*)(m_ring_memory + params.sq_off.array),
+        .entries = (SubmissionEntry*)entries,
+        .mask = *(u32*)(m_ring_memory + params.sq_off.ring_mask),
+        .local_tail = *(u32*)(m_ring_memory + params.sq_off.tail),
+    };
+    m_completion = {
+        .head = (u32*)(completion_memory + params.cq_off.head),
+        .tail = (u32*)(completion_memory + params.cq_off.tail),
+        .entries = (CompletionEntry*)(completion_memory
+            + params.cq_off.cqes),
+        .mask
+        = *(u32*)(completion_memory + params.cq_off.ring_mask),
+    };
+    return {};
+}
+
+void IOURing::destroy() const
+{
+    if (m_buffers.ring != nullptr) {
+        System::munmap(m_buffers.ring,
+            m_buffers.count * sizeof(struct io_uring_buf))
+            .ignore();
+        System::munmap(m_buffers.data,
+            (usize)m_buffers.count * m_buffers.buffer_size)
+            .ignore();
+    }
+    if (m_submission.entries != nullptr) {
+        System::munmap(m_submission.entries,
+            m_entries * sizeof(SubmissionEntry))
+            .ignore();
+    }
+    if (m_completion_memory != nullptr) {
+        System::munmap(m_completion_memory,
+            m_completion_memory_size)
+            .ignore();
+    }
+    if (m_ring_memory != nullptr)
+        System::munmap(m_ring_memory, m_ring_memory_size).ignore();
+    System::close(m_fd).ignore();
+}
+
+ErrorOr<IOURing::SubmissionEntry*> IOURing::submission_entry()
+{
+    auto& queue = m_submission;
+    auto head = __atomic_load_n(queue.head, __ATOMIC_ACQUIRE);
+    if (queue.local_tail - head >= m_entries) {
+        TRY(submit_and_wait(0));
+        head = __atomic_load_n(queue.head, __ATOMIC_ACQUIRE);
+        if (queue.local_tail - head >= m_entries)
+            return Error::from_errno(EBUSY);
+    }
+
+    auto index = queue.local_tail & queue.mask;
+    queue.array[index] = index;
+    queue.local_tail++;
+    __atomic_store_n(queue.tail, queue.local_tail,
+        __ATOMIC_RELEASE);
+
+    auto* entry = &queue.entries[index];
+    *entry = {};
+    return entry;
+}
+
+ErrorOr<void> IOURing::submit_and_wait(u32 completions)
+{
+    auto head
+        = __atomic_load_n(m_submission.head, __ATOMIC_ACQUIRE);
+    auto pending = m_submission.local_tail - head;
+    if (pending == 0 && completions == 0)
+        return {};
+    u32 flags = completions > 0 ? IORING_ENTER_GETEVENTS : 0;
+    TRY(System::io_uring_enter(m_fd, pending, completions, flags));
+    return {};
+}
+
+ErrorOr<void> IOURing::register_files(int const* fds, u32 count)
+{
+    TRY(System::io_uring_register(m_fd, IORING_REGISTER_FILES, fds,
+        count));
+    return {};
+}
+
+ErrorOr<void> IOURing::register_buffer_ring(u16 buffer_count,
+    u32 buffer_size)
+{
+    VERIFY(m_buffers.ring == nullptr);
+    // NOTE: The kernel indexes the ring with a mask.
+    VERIFY((buffer_count & (buffer_count - 1)) == 0);
+
+    auto ring_size = buffer_count * sizeof(struct io_uring_buf);
+    auto* ring = TRY(System::mmap(ring_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS));
+    auto data = System::mmap((usize)buffer_count * buffer_size,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS);
+    if (data.is_error()) {
+        System::munmap(ring, ring_size).ignore();
+        return data.release_error();
+    }
+    m_buffers = {
+        .ring = (struct io_uring_buf_ring*)ring,
+        .data = data.release_value(),
+        .buffer_size = buffer_size,
+        .count = buffer_count,
+    };
+
+    struct io_uring_buf_reg registration {};
+    registration.ring_addr = (u64)ring;
+    registration.ring_entries = buffer_count;
+    registration.bgid = buffer_group;
+    TRY(System::io_uring_register(m_fd, IORING_REGISTER_PBUF_RING,
+        &registration, 1));
+
+    for (u16 id = 0; id < buffer_count; id++)
+        give_buffer(id);
+    return {};
+}
+
+StringView IOURing::provided_buffer(
+    CompletionEntry const& entry) const
+{
+    VERIFY(entry.flags & IORING_CQE_F_BUFFER);
+    VERIFY(entry.res >= 0);
+    u16 id = entry.flags >> IORING_CQE_BUFFER_SHIFT;
+    auto* data = m_buffers.data + (usize)id * m_buffers.buffer_size;
+    return StringView((char const*)data, (u32)entry.res);
+}
+
+void IOURing::recycle_buffer(CompletionEntry const& entry)
+{
+    if (!(entry.flags & IORING_CQE_F_BUFFER))
+        return;
+    give_buffer(entry.flags >> IORING_CQE_BUFFER_SHIFT);
+}
+
+void IOURing::give_buffer(u16 id)
+{
+    auto* ring = m_buffers.ring;
+    auto tail = ring->tail;
+    // NOTE: The kernel header declares bufs with a C flexible
+    //       array idiom that lands at the wrong offset in C++, the
+    //       entries start at the beginning of the ring.
+    auto* buffers = (struct io_uring_buf*)ring;
+    auto& buffer = buffers[tail & (m_buffers.count - 1)];
+    auto offset = (usize)id * m_buffers.buffer_size;
+    buffer.addr = (u64)(m_buffers.data + offset);
+    buffer.len = m_buffers.buffer_size;
+    buffer.bid = id;
+    __atomic_store_n(&ring->tail, (u16)(tail + 1),
+        __ATOMIC_RELEASE);
+}
+
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <Ty/ErrorOr.h>
+#include <Ty/StringView.h>
+#include <linux/io_uring.h>
+
+namespace Core {
+
+// Minimal io_uring instance: a submission and a completion queue
+// shared with the kernel, plus an optional ring of provided buffers
+// the kernel picks receive buffers from.
+struct IOURing {
+    using SubmissionEntry = struct io_uring_sqe;
+    using CompletionEntry = struct io_uring_cqe;
+
+    static ErrorOr<IOURing> create(u32 entries);
+
+    IOURing(IOURing&& other)
+        : m_submission(other.m_submission)
+        , m_completion(other.m_completion)
+        , m_buffers(other.m_buffers)
+        , m_entries(other.m_entries)
+        , m_ring_memory(other.m_ring_memory)
+        , m_ring_memory_size(other.m_ring_memory_size)
+        , m_completion_memory(other.m_completion_memory)
+        , m_completion_memory_size(other.m_completion_memory_size)
+        , m_fd(other.m_fd)
+    {
+        other.invalidate();
+    }
+
+    ~IOURing()
+    {
+        if (is_valid()) {
+            destroy();
+            invalidate();
+        }
+    }
+
+    // NOTE: Returns a zeroed entry, submitting whatever is queued
+    //       to make room if the submission queue is full.
+    ErrorOr<SubmissionEntry*> submission_entry();
+
+    ErrorOr<void> submit_and_wait(u32 completions = 1);
+
+    template <typename Callback>
+    void for_each_completion(Callback callback)
+    {
+        auto head = *m_completion.head;
+        auto tail
+            = __atomic_load_n(m_completion.tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            auto index = head & m_completion.mask;
+            callback(m_completion.entries[index]);
+        }
+        __atomic_store_n(m_completion.head, head, __ATOMIC_RELEASE);
+    }
+
+    ErrorOr<void> register_files(int const* fds, u32 count);
+
+    // NOTE: Buffers are handed out through completions flagged with
+    //       IORING_CQE_F_BUFFER, and have to be given back with
+    //       recycle_buffer() once their contents are consumed.
+    ErrorOr<void> register_buffer_ring(u16 buffer_count,
+        u32 buffer_size);
+    static constexpr u16 buffer_group = 0;
+    StringView provided_buffer(CompletionEntry const&) const;
+    void recycle_buffer(CompletionEntry const&);
+
+private:
+    struct SubmissionQueue {
+        u32* head { nullptr };
+        u32* tail { nullptr };
+        u32* array { nullptr };
+        SubmissionEntry* entries { nullptr };
+        u32 mask { 0 };
+        u32 local_tail { 0 };
+    };
+
+    struct CompletionQueue {
+        u32* head { nullptr };
+        u32* tail { nullptr };
+        CompletionEntry* entries { nullptr };
+        u32 mask { 0 };
+    };
+
+    struct BufferRing {
+        struct io_uring_buf_ring* ring { nullptr };
+        u8* data { nullptr };
+        u32 buffer_size { 0 };
+        u16 count { 0 };
+    };
+
+    IOURing(int fd)
+        : m_fd(fd)
+    {
+    }
+
+    ErrorOr<void> map_queues(struct io_uring_params const&);
+    void give_buffer(u16 id);
+
+    void destroy() const;
+    bool is_valid() const { return m_fd != -1; }
+    void invalidate() { m_fd = -1; }
+
+    SubmissionQueue m_submission {};
+    CompletionQueue m_completion {};
+    BufferRing m_buffers {};
+    u32 m_entries { 0 };
+    u8* m_ring_memory { nullptr };
+    usize m_ring_memory_size { 0 };
+    u8* m_completion_memory { nullptr };
+    usize m_completion_memory_size { 0 };
+    int m_fd { -1 };
+};
+
+}
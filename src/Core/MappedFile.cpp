@@ -12,7 +12,11 @@ ErrorOr<MappedFile> MappedFile::open(StringView path)
 
 ErrorOr<MappedFile> MappedFile::open(c_string path)
 {
-    auto fd = TRY(System::open(path, O_RDONLY));
+    return TRY(map(TRY(System::open(path, O_RDONLY))));
+}
+
+ErrorOr<MappedFile> MappedFile::map(int fd)
+{
     auto should_close_file = true;
     Defer close_file = [&] {
         if (should_close_file)
@@ -23,6 +27,11 @@ ErrorOr<MappedFile> MappedFile::open(c_string path)
         return Error::from_string_literal(
             "file is not a regular file");
     u32 size = file_stat.size();
+    // NOTE: Empty files can not be mapped.
+    if (size == 0) {
+        should_close_file = false;
+        return MappedFile("", 0, fd);
+    }
     auto* data = TRY(System::mmap(size, PROT_READ | PROT_WRITE,
         MAP_PRIVATE, fd));
     should_close_file = false;
@@ -31,7 +40,8 @@ ErrorOr<MappedFile> MappedFile::open(c_string path)
 
 void MappedFile::destroy() const
 {
-    System::munmap((void*)m_data, m_size).ignore();
+    if (m_size != 0)
+        System::munmap((void*)m_data, m_size).ignore();
     System::close(m_fd).ignore();
 }
 
@@ -6,9 +6,13 @@
 namespace Core {
 
 struct MappedFile {
-    char const* m_data;
-    u32 m_size;
-    int m_fd;
+    char const* m_data { nullptr };
+    u32 m_size { 0 };
+    int m_fd { -1 };
+
+    // NOTE: An empty mapping, which is not valid until another one
+    //       is moved into it.
+    constexpr MappedFile() = default;
 
     MappedFile(MappedFile&& other)
         : m_data(other.m_data)
@@ -22,7 +26,8 @@ struct MappedFile {
 
     constexpr MappedFile& operator=(MappedFile&& other)
     {
-        destroy();
+        if (is_valid())
+            destroy();
         m_data = other.m_data;
         m_size = other.m_size;
         m_fd = other.m_fd;
@@ -33,7 +38,11 @@ struct MappedFile {
     static ErrorOr<MappedFile> open(StringView path);
     static ErrorOr<MappedFile> open(c_string path);
 
+    // NOTE: Takes over fd, which is closed even if mapping fails.
+    static ErrorOr<MappedFile> map(int fd);
+
     StringView view() const { return StringView(m_data, m_size); }
+    int fd() const { return m_fd; }
     bool is_valid() const { return m_data != nullptr; }
     void invalidate() { m_data = nullptr; }
 
@@ -46,8 +55,6 @@ private:
     }
 
     void destroy() const;
-
-    constexpr MappedFile() = default;
 };
 
 }
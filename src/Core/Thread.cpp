@@ -0,0 +1,57 @@
+#include "Thread.h"
+#include <Ty/Memory.h>
+#include <Ty/New.h>
+#include <Ty/System.h>
+
+namespace Core {
+
+ErrorOr<Thread> Thread::spawn(Entry&& entry)
+{
+    // NOTE: The entry has to outlive this stack frame, so it is
+    //       moved to the heap and freed by the new thread.
+    auto* memory = TRY(allocate_memory(sizeof(Entry)));
+    auto* heap_entry = new (memory) Entry(entry);
+
+    auto thread = System::pthread_create(
+        [](void* argument) -> void* {
+            auto* entry = (Entry*)argument;
+            (*entry)();
+            entry->~Entry();
+            free_memory(entry);
+            return nullptr;
+        },
+        heap_entry);
+    if (thread.is_error()) {
+        heap_entry->~Entry();
+        free_memory(heap_entry);
+        return thread.release_error();
+    }
+
+    return Thread(thread.release_value());
+}
+
+ErrorOr<void> Thread::join()
+{
+    TRY(System::pthread_join(m_thread));
+    invalidate();
+    return {};
+}
+
+ErrorOr<void> Thread::detach()
+{
+    TRY(System::pthread_detach(m_thread));
+    invalidate();
+    return {};
+}
+
+ErrorOr<void> Thread::pin_to_cpu(u32 cpu) const
+{
+#ifdef __linux__
+    TRY(System::pthread_setaffinity(m_thread, cpu));
+#else
+    (void)cpu;
+#endif
+    return {};
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <Ty/ErrorOr.h>
+#include <Ty/SmallCapture.h>
+#include <pthread.h>
+
+namespace Core {
+
+struct Thread {
+    using Entry = SmallCapture<void()>;
+
+    static ErrorOr<Thread> spawn(Entry&& entry);
+
+    constexpr Thread(Thread&& other)
+        : m_thread(other.m_thread)
+        , m_is_valid(other.m_is_valid)
+    {
+        other.invalidate();
+    }
+
+    ~Thread()
+    {
+        if (is_valid()) {
+            join().ignore();
+            invalidate();
+        }
+    }
+
+    ErrorOr<void> join();
+
+    // NOTE: For threads that run until the process exits.
+    ErrorOr<void> detach();
+    ErrorOr<void> pin_to_cpu(u32 cpu) const;
+
+private:
+    constexpr Thread(pthread_t thread)
+        : m_thread(thread)
+        , m_is_valid(true)
+    {
+    }
+
+    bool is_valid() const { return m_is_valid; }
+    void invalidate() { m_is_valid = false; }
+
+    pthread_t m_thread {};
+    bool m_is_valid { false };
+};
+
+}
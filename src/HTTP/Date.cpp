@@ -0,0 +1,160 @@
+#include "Date.h"
+
+namespace HTTP {
+
+namespace {
+
+constexpr char const day_names[7][4] = {
+    "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat",
+};
+
+constexpr char const month_names[12][4] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec",
+};
+
+struct Civil {
+    i64 year;
+    u32 month;
+    u32 day;
+};
+
+// NOTE: Days since the epoch to a proleptic Gregorian date, counted
+//       in 400 year eras that start on the 1st of March.
+constexpr Civil civil_from_days(i64 days)
+{
+    days += 719468;
+    i64 era = (days >= 0 ? days : days - 146096) / 146097;
+    auto day_of_era = (u32)(days - era * 146097);
+    auto leap_days = day_of_era / 1460 - day_of_era / 36524
+        + day_of_era / 146096;
+    auto year_of_era = (day_of_era - leap_days) / 365;
+    auto day_of_year = day_of_era
+        - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    auto shifted_month = (5 * day_of_year + 2) / 153;
+    auto day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    auto month = shifted_month < 10 ? shifted_month + 3
+                                    : shifted_month - 9;
+    auto year = (i64)year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+    return { year, month, day };
+}
+
+// NOTE: The inverse of civil_from_days.
+constexpr i64 days_from_civil(Civil date)
+{
+    auto year = date.year - (date.month <= 2 ? 1 : 0);
+    i64 era = (year >= 0 ? year : year - 399) / 400;
+    auto year_of_era = (u32)(year - era * 400);
+    auto shifted_month
+        = date.month > 2 ? date.month - 3 : date.month + 9;
+    auto day_of_year = (153 * shifted_month + 2) / 5 + date.day - 1;
+    auto day_of_era = year_of_era * 365 + year_of_era / 4
+        - year_of_era / 100 + day_of_year;
+    return era * 146097 + (i64)day_of_era - 719468;
+}
+
+Optional<u32> parse_digits(char const* from, u32 count)
+{
+    u32 value = 0;
+    for (u32 i = 0; i < count; i++) {
+        if (from[i] < '0' || from[i] > '9')
+            return {};
+        value = value * 10 + (u32)(from[i] - '0');
+    }
+    return value;
+}
+
+Optional<u32> parse_name(char const* from,
+    char const (*names)[4], u32 count)
+{
+    for (u32 i = 0; i < count; i++) {
+        if (__builtin_memcmp(from, names[i], 3) == 0)
+            return i;
+    }
+    return {};
+}
+
+char* write_digits(char* to, u32 value, u32 count)
+{
+    for (u32 i = count; i > 0; i--) {
+        to[i - 1] = (char)('0' + value % 10);
+        value /= 10;
+    }
+    return to + count;
+}
+
+char* write_name(char* to, char const (&name)[4])
+{
+    __builtin_memcpy(to, name, 3);
+    return to + 3;
+}
+
+}
+
+Optional<Date> Date::parse(StringView source)
+{
+    // NOTE: "Sun, 06 Nov 1994 08:49:37 GMT"
+    //        0    5  8   12   17 20 23 26
+    if (source.size != formatted_size)
+        return {};
+    auto const* from = source.data;
+    auto separators_match = from[3] == ',' && from[4] == ' '
+        && from[7] == ' ' && from[11] == ' ' && from[16] == ' '
+        && from[19] == ':' && from[22] == ':'
+        && __builtin_memcmp(from + 25, " GMT", 4) == 0;
+    if (!separators_match)
+        return {};
+    if (!parse_name(from, day_names, 7).has_value())
+        return {};
+
+    auto day = parse_digits(from + 5, 2);
+    auto month = parse_name(from + 8, month_names, 12);
+    auto year = parse_digits(from + 12, 4);
+    auto hour = parse_digits(from + 17, 2);
+    auto minute = parse_digits(from + 20, 2);
+    auto second = parse_digits(from + 23, 2);
+    if (!day.has_value() || !month.has_value() || !year.has_value()
+        || !hour.has_value() || !minute.has_value()
+        || !second.has_value())
+        return {};
+    if (day.value() < 1 || day.value() > 31 || hour.value() > 23
+        || minute.value() > 59 || second.value() > 60)
+        return {};
+
+    auto days = days_from_civil({
+        year.value(),
+        month.value() + 1,
+        day.value(),
+    });
+    return Date {
+        days * 86400 + hour.value() * 3600 + minute.value() * 60
+        + second.value(),
+    };
+}
+
+void Date::format(char* to) const
+{
+    auto clamped = seconds < 0 ? 0 : seconds;
+    auto days = clamped / 86400;
+    auto second_of_day = (u32)(clamped % 86400);
+    auto date = civil_from_days(days);
+
+    // NOTE: The epoch was on a Thursday.
+    to = write_name(to, day_names[(days + 4) % 7]);
+    *to++ = ',';
+    *to++ = ' ';
+    to = write_digits(to, date.day, 2);
+    *to++ = ' ';
+    to = write_name(to, month_names[date.month - 1]);
+    *to++ = ' ';
+    to = write_digits(to, (u32)date.year, 4);
+    *to++ = ' ';
+    to = write_digits(to, second_of_day / 3600, 2);
+    *to++ = ':';
+    to = write_digits(to, second_of_day / 60 % 60, 2);
+    *to++ = ':';
+    to = write_digits(to, second_of_day % 60, 2);
+    __builtin_memcpy(to, " GMT", 4);
+}
+
+}
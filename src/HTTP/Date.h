@@ -0,0 +1,39 @@
+#pragma once
+#include <Ty/Concepts.h>
+#include <Ty/ErrorOr.h>
+#include <Ty/Forward.h>
+#include <Ty/Optional.h>
+#include <Ty/StringView.h>
+
+namespace HTTP {
+
+// Seconds since the Unix epoch, written in the one date format
+// HTTP senders use, like "Sun, 06 Nov 1994 08:49:37 GMT".
+struct Date {
+    static constexpr u32 formatted_size = 29;
+
+    i64 seconds { 0 };
+
+    // NOTE: Only takes the format above. Senders have to use it,
+    //       and dates that do not parse are treated as absent.
+    static Optional<Date> parse(StringView);
+
+    // NOTE: Writes exactly formatted_size characters.
+    void format(char* to) const;
+
+    bool operator==(Date const&) const = default;
+};
+
+}
+
+template <>
+struct Ty::Formatter<HTTP::Date> {
+    template <typename U>
+        requires Writable<U>
+    static ErrorOr<u32> write(U& to, HTTP::Date date)
+    {
+        char buffer[HTTP::Date::formatted_size];
+        date.format(buffer);
+        return TRY(to.write(StringView(buffer, sizeof(buffer))));
+    }
+};
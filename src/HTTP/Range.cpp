@@ -0,0 +1,121 @@
+#include "Range.h"
+
+namespace HTTP {
+
+namespace {
+
+constexpr bool is_space(char character)
+{
+    return character == ' ' || character == '\t';
+}
+
+constexpr StringView trim(StringView view)
+{
+    while (!view.is_empty() && is_space(view[0]))
+        view = view.shrink_from_start(1);
+    while (!view.is_empty() && is_space(view[view.size - 1]))
+        view = view.shrink(1);
+    return view;
+}
+
+// NOTE: Saturates instead of overflowing, as positions past the end
+//       of the body are as good as any other past it.
+Optional<u64> parse_position(StringView digits)
+{
+    constexpr u64 limit = 0xFFFFFFFFFFULL;
+    if (digits.is_empty())
+        return {};
+    u64 value = 0;
+    for (u32 i = 0; i < digits.size; i++) {
+        if (digits[i] < '0' || digits[i] > '9')
+            return {};
+        value = value * 10 + (u64)(digits[i] - '0');
+        if (value > limit)
+            value = limit;
+    }
+    return value;
+}
+
+enum class Spec : u8 {
+    Malformed,
+    Unsatisfiable,
+    Satisfiable,
+};
+
+// NOTE: One of "first-last", "first-" or "-suffix_length".
+Spec parse_spec(StringView spec, u32 body_size,
+    ByteRange& range)
+{
+    auto dash = spec.find_first('-');
+    if (!dash.has_value())
+        return Spec::Malformed;
+    auto first_digits = spec.sub_view(0, dash.value());
+    auto last_digits = spec.shrink_from_start(dash.value() + 1);
+
+    if (first_digits.is_empty()) {
+        auto suffix = parse_position(last_digits);
+        if (!suffix.has_value())
+            return Spec::Malformed;
+        if (suffix.value() == 0 || body_size == 0)
+            return Spec::Unsatisfiable;
+        auto size = suffix.value() < body_size ? (u32)suffix.value()
+                                               : body_size;
+        range = { body_size - size, body_size };
+        return Spec::Satisfiable;
+    }
+
+    auto first = parse_position(first_digits);
+    if (!first.has_value())
+        return Spec::Malformed;
+    u64 end = body_size;
+    if (!last_digits.is_empty()) {
+        auto last = parse_position(last_digits);
+        if (!last.has_value() || last.value() < first.value())
+            return Spec::Malformed;
+        if (last.value() + 1 < end)
+            end = last.value() + 1;
+    }
+    if (first.value() >= body_size)
+        return Spec::Unsatisfiable;
+    range = { (u32)first.value(), (u32)end };
+    return Spec::Satisfiable;
+}
+
+}
+
+ByteRanges ByteRanges::parse(StringView field, u32 body_size)
+{
+    auto result = ByteRanges();
+    auto unit = "bytes="sv;
+    if (!field.starts_with(unit))
+        return result;
+
+    auto has_unsatisfiable = false;
+    auto specs = field.shrink_from_start(unit.size);
+    for (auto spec : specs.split(',')) {
+        spec = trim(spec);
+        if (spec.is_empty())
+            continue;
+        auto range = ByteRange();
+        switch (parse_spec(spec, body_size, range)) {
+        case Spec::Malformed:
+            return ByteRanges();
+        case Spec::Unsatisfiable:
+            has_unsatisfiable = true;
+            continue;
+        case Spec::Satisfiable:
+            break;
+        }
+        if (result.count == max_count)
+            return ByteRanges();
+        result.ranges[result.count++] = range;
+    }
+
+    if (result.count != 0)
+        result.status = Status::Partial;
+    else if (has_unsatisfiable)
+        result.status = Status::Unsatisfiable;
+    return result;
+}
+
+}
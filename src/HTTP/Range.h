@@ -0,0 +1,41 @@
+#pragma once
+#include <Ty/Base.h>
+#include <Ty/StringView.h>
+#include <Ty/View.h>
+
+namespace HTTP {
+
+// Part of a body, from start up to but not including end.
+struct ByteRange {
+    u32 start;
+    u32 end;
+
+    u32 size() const { return end - start; }
+};
+
+// The ranges a "Range: bytes=..." field asks for, resolved against
+// the size of the body they are asked of.
+struct ByteRanges {
+    // NOTE: Asking for more than this gets the whole body instead,
+    //       so lots of tiny or overlapping ranges can not turn into
+    //       far more work than sending everything.
+    static constexpr u32 max_count = 16;
+
+    enum class Status : u8 {
+        // NOTE: The field was malformed or asked for too much, it
+        //       is ignored and the whole body sent.
+        Whole,
+        Partial,
+        Unsatisfiable,
+    };
+
+    static ByteRanges parse(StringView field, u32 body_size);
+
+    View<ByteRange const> view() const { return { ranges, count }; }
+
+    ByteRange ranges[max_count];
+    u32 count { 0 };
+    Status status { Status::Whole };
+};
+
+}
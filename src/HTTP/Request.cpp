@@ -2,12 +2,387 @@
 
 namespace HTTP {
 
+namespace {
+
+constexpr char to_lower(char character)
+{
+    if (character >= 'A' && character <= 'Z')
+        return (char)(character - 'A' + 'a');
+    return character;
+}
+
+// NOTE: b has to be lower case already.
+constexpr bool equals_ignoring_case(StringView a, StringView b)
+{
+    if (a.size != b.size)
+        return false;
+    for (u32 i = 0; i < a.size; i++) {
+        if (to_lower(a[i]) != b[i])
+            return false;
+    }
+    return true;
+}
+
+constexpr StringView trim(StringView view)
+{
+    auto is_space = [](char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    };
+    while (!view.is_empty() && is_space(view[0]))
+        view = view.shrink_from_start(1);
+    while (!view.is_empty() && is_space(view[view.size - 1]))
+        view = view.shrink(1);
+    return view;
+}
+
+// NOTE: Returns source.size if there is no such character.
+u32 find(StringView source, char character, u32 from = 0)
+{
+    if (from >= source.size)
+        return source.size;
+    return from
+        + StringSearch::find_byte(source.data + from,
+            source.size - from, character);
+}
+
+// NOTE: Returns header_count for fields outside of Header.
+constexpr u32 header_index(StringView name)
+{
+    auto matches = [&](StringView lower_case_name) {
+        return equals_ignoring_case(name, lower_case_name);
+    };
+    switch (name.size) {
+    case 4:
+        if (matches("host"sv))
+            return (u32)Header::Host;
+        break;
+    case 5:
+        if (matches("range"sv))
+            return (u32)Header::Range;
+        break;
+    case 8:
+        if (matches("if-range"sv))
+            return (u32)Header::IfRange;
+        break;
+    case 10:
+        if (matches("connection"sv))
+            return (u32)Header::Connection;
+        break;
+    case 13:
+        if (matches("if-none-match"sv))
+            return (u32)Header::IfNoneMatch;
+        break;
+    case 14:
+        if (matches("content-length"sv))
+            return (u32)Header::ContentLength;
+        break;
+    case 15:
+        if (matches("accept-encoding"sv))
+            return (u32)Header::AcceptEncoding;
+        break;
+    case 17:
+        if (matches("transfer-encoding"sv))
+            return (u32)Header::TransferEncoding;
+        if (matches("if-modified-since"sv))
+            return (u32)Header::IfModifiedSince;
+        break;
+    }
+    return header_count;
+}
+
+// NOTE: Fields holding a comma separated list, which clients may
+//       split over several lines.
+constexpr bool is_list_field(u32 index)
+{
+    switch ((Header)index) {
+    case Header::Connection:
+    case Header::AcceptEncoding:
+    case Header::IfNoneMatch:
+        return true;
+    default:
+        return false;
+    }
+}
+
+ErrorOr<Version> parse_version(StringView version)
+{
+    if (version == "HTTP/1.1"sv)
+        return Version::Http11;
+    if (version == "HTTP/1.0"sv)
+        return Version::Http10;
+    return Error::from_string_literal("unsupported HTTP version");
+}
+
+ErrorOr<u32> parse_content_length(StringView digits)
+{
+    if (digits.is_empty() || digits.size > 9)
+        return Error::from_string_literal("invalid Content-Length");
+    u32 length = 0;
+    for (u32 i = 0; i < digits.size; i++) {
+        if (digits[i] < '0' || digits[i] > '9')
+            return Error::from_string_literal(
+                "invalid Content-Length");
+        length = length * 10 + (u32)(digits[i] - '0');
+    }
+    return length;
+}
+
+// NOTE: If-None-Match compares weakly, so W/ prefixes are ignored
+//       on both sides.
+bool etag_list_contains(StringView list, StringView etag)
+{
+    auto weak_prefix = "W/"sv;
+    if (etag.starts_with(weak_prefix))
+        etag = etag.shrink_from_start(weak_prefix.size);
+
+    u32 position = 0;
+    while (position < list.size) {
+        auto character = list[position];
+        if (character == ' ' || character == '\t'
+            || character == ',') {
+            position++;
+            continue;
+        }
+        auto rest = list.shrink_from_start(position);
+        if (rest.starts_with(weak_prefix))
+            position += weak_prefix.size;
+        if (position >= list.size || list[position] != '"')
+            return false;
+        auto end = find(list, '"', position + 1);
+        if (end == list.size)
+            return false;
+        if (list.part(position, end + 1) == etag)
+            return true;
+        position = end + 1;
+    }
+    return false;
+}
+
+// NOTE: Quality values go up to three decimals, "0.5" is 500.
+//       Anything malformed counts as 0.
+u32 parse_quality(StringView value)
+{
+    if (value.is_empty() || (value[0] != '0' && value[0] != '1'))
+        return 0;
+    u32 quality = value[0] == '1' ? 1000 : 0;
+    if (value.size == 1)
+        return quality;
+    if (value[1] != '.' || value.size > 5)
+        return 0;
+    u32 scale = 100;
+    for (u32 i = 2; i < value.size; i++, scale /= 10) {
+        if (value[i] < '0' || value[i] > '9')
+            return 0;
+        quality += (u32)(value[i] - '0') * scale;
+    }
+    return quality > 1000 ? 0 : quality;
+}
+
+}
+
+ErrorOr<Method> Method::from_name(StringView name)
+{
+    if (name == "GET"sv)
+        return Method(Get);
+    if (name == "HEAD"sv)
+        return Method(Head);
+    if (name == "POST"sv)
+        return Method(Post);
+    if (name == "PUT"sv)
+        return Method(Put);
+    if (name == "DELETE"sv)
+        return Method(Delete);
+    if (name == "OPTIONS"sv)
+        return Method(Options);
+    return Error::from_string_literal("unknown request method");
+}
+
 StringView Method::name() const
 {
     switch(m_type) {
         case Get: return "GET"sv;
+        case Head: return "HEAD"sv;
         case Post: return "POST"sv;
+        case Put: return "PUT"sv;
+        case Delete: return "DELETE"sv;
+        case Options: return "OPTIONS"sv;
+    }
+}
+
+ErrorOr<Request> Request::parse(StringView source)
+{
+    auto line_end = find(source, '\n');
+    if (line_end == source.size)
+        return Error::from_string_literal("incomplete request");
+    auto request_line = trim(source.sub_view(0, line_end));
+
+    auto method_end = find(request_line, ' ');
+    auto slug_end = find(request_line, ' ', method_end + 1);
+    if (slug_end >= request_line.size)
+        return Error::from_string_literal("malformed request line");
+    auto request = Request(TRY(Method::from_name(
+        request_line.sub_view(0, method_end))));
+    request.slug = request_line.part(method_end + 1, slug_end);
+    if (request.slug.is_empty())
+        return Error::from_string_literal("malformed request line");
+    request.version = TRY(parse_version(
+        request_line.shrink_from_start(slug_end + 1)));
+
+    auto position = line_end + 1;
+    while (true) {
+        line_end = find(source, '\n', position);
+        if (line_end == source.size)
+            return Error::from_string_literal("incomplete request");
+        auto line = source.part(position, line_end);
+        position = line_end + 1;
+        if (!line.is_empty() && line[line.size - 1] == '\r')
+            line = line.shrink(1);
+        if (line.is_empty())
+            break;
+
+        auto colon = find(line, ':');
+        if (colon == line.size)
+            continue;
+        auto index = header_index(line.sub_view(0, colon));
+        if (index == header_count)
+            continue;
+        // NOTE: A second Content-Length or Host could be read by
+        //       something along the way instead of the first, so
+        //       the request means different things to the two.
+        //       Lists only keep their first line, parsing has no
+        //       room to join them.
+        if ((request.m_present_headers & (1U << index)) != 0) {
+            if (is_list_field(index))
+                continue;
+            return Error::from_string_literal(
+                "repeated header field");
+        }
+        request.m_headers[index]
+            = trim(line.shrink_from_start(colon + 1));
+        request.m_present_headers |= 1U << index;
+    }
+    request.m_head_size = position;
+
+    if (request.has_header(Header::TransferEncoding))
+        return Error::from_string_literal(
+            "chunked request bodies are not supported");
+    if (request.has_header(Header::ContentLength)) {
+        request.m_content_length = TRY(parse_content_length(
+            request.header(Header::ContentLength)));
+    }
+
+    auto message_end = request.message_size();
+    if (message_end > source.size)
+        message_end = source.size;
+    request.source = source.sub_view(0, message_end);
+    request.body = source.part(position, message_end);
+    return request;
+}
+
+Optional<StringView> Request::header(StringView name) const
+{
+    auto head = source.sub_view(0, m_head_size);
+    // NOTE: Skip the request line.
+    auto position = find(head, '\n') + 1;
+    while (position < head.size) {
+        auto line_end = find(head, '\n', position);
+        auto line = head.part(position, line_end);
+        position = line_end + 1;
+
+        auto colon = find(line, ':');
+        if (colon == line.size)
+            continue;
+        auto field = line.sub_view(0, colon);
+        if (field.size != name.size)
+            continue;
+        auto matches = true;
+        for (u32 i = 0; i < name.size && matches; i++)
+            matches = to_lower(field[i]) == to_lower(name[i]);
+        if (matches)
+            return trim(line.shrink_from_start(colon + 1));
+    }
+    return {};
+}
+
+bool Request::wants_keep_alive() const
+{
+    auto keep_alive = version != Version::Http10;
+
+    // NOTE: The field is a comma separated list of options.
+    for (auto option : header(Header::Connection).split(',')) {
+        option = trim(option);
+        if (equals_ignoring_case(option, "close"sv))
+            return false;
+        if (equals_ignoring_case(option, "keep-alive"sv))
+            keep_alive = true;
+    }
+    return keep_alive;
+}
+
+bool Request::has_current_copy(StringView etag,
+    Date last_modified) const
+{
+    auto type = method.type();
+    if (type != Method::Get && type != Method::Head)
+        return false;
+
+    if (has_header(Header::IfNoneMatch)) {
+        auto list = header(Header::IfNoneMatch);
+        if (list == "*"sv)
+            return true;
+        return etag_list_contains(list, etag);
+    }
+
+    if (has_header(Header::IfModifiedSince)) {
+        auto since = Date::parse(header(Header::IfModifiedSince));
+        if (!since.has_value())
+            return false;
+        return last_modified.seconds <= since.value().seconds;
+    }
+    return false;
+}
+
+bool Request::wants_range(StringView etag,
+    Date last_modified) const
+{
+    if (method.type() != Method::Get || !has_header(Header::Range))
+        return false;
+    if (!has_header(Header::IfRange))
+        return true;
+
+    // NOTE: Entity tags are compared strongly here, weak ones never
+    //       match.
+    auto condition = header(Header::IfRange);
+    if (condition.starts_with("\""sv))
+        return condition == etag;
+    auto date = Date::parse(condition);
+    return date.has_value() && date.value() == last_modified;
+}
+
+u32 Request::encoding_quality(StringView coding) const
+{
+    // NOTE: A listed coding overrides *, wherever they are.
+    u32 wildcard = 0;
+    for (auto element : header(Header::AcceptEncoding).split(',')) {
+        element = trim(element);
+        auto end = find(element, ';');
+        auto name = trim(element.sub_view(0, end));
+        u32 quality = 1000;
+        if (end != element.size) {
+            auto parameter
+                = trim(element.shrink_from_start(end + 1));
+            if (parameter.starts_with("q="sv)
+                || parameter.starts_with("Q="sv)) {
+                quality = parse_quality(
+                    parameter.shrink_from_start(2));
+            }
+        }
+        if (equals_ignoring_case(name, coding))
+            return quality;
+        if (name == "*"sv)
+            wildcard = quality;
     }
+    return wildcard;
 }
 
 }
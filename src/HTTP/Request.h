@@ -1,21 +1,30 @@
 #pragma once
-#include "Ty/Forward.h"
-#include <Ty/StringView.h>
+#include "Date.h"
 #include <Ty/Concepts.h>
 #include <Ty/ErrorOr.h>
+#include <Ty/Forward.h>
+#include <Ty/Optional.h>
+#include <Ty/StringView.h>
 
 namespace HTTP {
 
 struct Method {
     enum Type : u8 {
         Get,
+        Head,
         Post,
+        Put,
+        Delete,
+        Options,
     };
     constexpr Method(Type type)
         : m_type(type)
     {
     }
 
+    // NOTE: Method names are case sensitive.
+    static ErrorOr<Method> from_name(StringView name);
+
     StringView name() const;
     Type type() const { return m_type; }
 
@@ -23,9 +32,94 @@ private:
     Type m_type;
 };
 
+enum class Version : u8 {
+    Http10,
+    Http11,
+};
+
+// Header fields the server acts on. They are picked out while
+// parsing, so looking them up afterwards is a table lookup.
+enum class Header : u8 {
+    Host,
+    Connection,
+    ContentLength,
+    TransferEncoding,
+    AcceptEncoding,
+    IfNoneMatch,
+    IfModifiedSince,
+    IfRange,
+    Range,
+};
+constexpr u32 header_count = (u32)Header::Range + 1;
+
 struct Request {
+    // NOTE: Parses the request line and headers in a single pass
+    //       without allocating, source has to hold the whole head.
+    //       The body is whatever part of it source holds as well.
+    //       Fields in Header may only appear once, but for lists,
+    //       which keep their first line.
+    static ErrorOr<Request> parse(StringView source);
+
+    StringView source;
     StringView slug;
+    StringView body;
     Method method;
+    Version version;
+
+    // NOTE: Field values are trimmed, and empty if they are not
+    //       present in the request.
+    StringView header(Header header) const
+    {
+        return m_headers[(u32)header];
+    }
+    bool has_header(Header header) const
+    {
+        return (m_present_headers & (1U << (u32)header)) != 0;
+    }
+
+    // NOTE: For fields outside of Header, these are matched case
+    //       insensitively by going through the head again.
+    Optional<StringView> header(StringView name) const;
+
+    u32 head_size() const { return m_head_size; }
+    u32 content_length() const { return m_content_length; }
+    u32 message_size() const
+    {
+        return m_head_size + m_content_length;
+    }
+    bool has_body() const { return body.size == m_content_length; }
+
+    // Whether the client asked for the connection to stay open,
+    // which is the default from HTTP/1.1 on.
+    bool wants_keep_alive() const;
+
+    // NOTE: Whether the client's cached copy of something with
+    //       these validators is current, going by If-None-Match,
+    //       or by If-Modified-Since without it.
+    bool has_current_copy(StringView etag,
+        Date last_modified) const;
+
+    // NOTE: Whether Range applies, which it only does for GET, and
+    //       with If-Range only while that still names the current
+    //       version.
+    bool wants_range(StringView etag, Date last_modified) const;
+
+    // NOTE: How much the client wants a content coding, from 0 for
+    //       not at all to 1000, going by Accept-Encoding. coding
+    //       has to be lower case.
+    u32 encoding_quality(StringView coding) const;
+
+private:
+    constexpr Request(Method method)
+        : method(method)
+        , version(Version::Http11)
+    {
+    }
+
+    StringView m_headers[header_count] {};
+    u32 m_head_size { 0 };
+    u32 m_content_length { 0 };
+    u16 m_present_headers { 0 };
 };
 
 }
@@ -44,8 +138,9 @@ template <>
 struct Ty::Formatter<HTTP::Request> {
     template <typename U>
     requires Writable<U>
-    static constexpr ErrorOr<u32> write(U& to, HTTP::Request request)
+    static constexpr ErrorOr<u32> write(U& to,
+        HTTP::Request const& request)
     {
-        return TRY(to.write(request.method, " "sv, request.slug, "\r\n\r\n"sv));
+        return TRY(to.write(request.method, " "sv, request.slug));
     }
 };
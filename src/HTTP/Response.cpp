@@ -7,9 +7,31 @@ StringView response_code_string(ResponseCode code)
     switch(code) {
     case ResponseCode::Continue: return "Continue"sv;
     case ResponseCode::Ok: return "OK"sv;
+    case ResponseCode::PartialContent: return "Partial Content"sv;
+    case ResponseCode::NotModified: return "Not Modified"sv;
     case ResponseCode::NotFound: return "Not Found"sv;
+    case ResponseCode::MethodNotAllowed: return "Method Not Allowed"sv;
+    case ResponseCode::ContentTooLarge: return "Content Too Large"sv;
+    case ResponseCode::RangeNotSatisfiable: return "Range Not Satisfiable"sv;
+    case ResponseCode::RequestHeaderFieldsTooLarge: return "Request Header Fields Too Large"sv;
     case ResponseCode::InternalServerError: return "Internal Server Error"sv;
     }
 }
 
+StringView status_line(ResponseCode code)
+{
+    switch(code) {
+    case ResponseCode::Continue: return "HTTP/1.1 100 Continue\r\n"sv;
+    case ResponseCode::Ok: return "HTTP/1.1 200 OK\r\n"sv;
+    case ResponseCode::PartialContent: return "HTTP/1.1 206 Partial Content\r\n"sv;
+    case ResponseCode::NotModified: return "HTTP/1.1 304 Not Modified\r\n"sv;
+    case ResponseCode::NotFound: return "HTTP/1.1 404 Not Found\r\n"sv;
+    case ResponseCode::MethodNotAllowed: return "HTTP/1.1 405 Method Not Allowed\r\n"sv;
+    case ResponseCode::ContentTooLarge: return "HTTP/1.1 413 Content Too Large\r\n"sv;
+    case ResponseCode::RangeNotSatisfiable: return "HTTP/1.1 416 Range Not Satisfiable\r\n"sv;
+    case ResponseCode::RequestHeaderFieldsTooLarge: return "HTTP/1.1 431 Request Header Fields Too Large\r\n"sv;
+    case ResponseCode::InternalServerError: return "HTTP/1.1 500 Internal Server Error\r\n"sv;
+    }
+}
+
 }
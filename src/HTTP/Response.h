@@ -10,18 +10,48 @@ namespace HTTP {
 enum class ResponseCode : u16 {
     Continue = 100,
     Ok = 200,
+    PartialContent = 206,
+    NotModified = 304,
     NotFound = 404,
+    MethodNotAllowed = 405,
+    ContentTooLarge = 413,
+    RangeNotSatisfiable = 416,
+    RequestHeaderFieldsTooLarge = 431,
     InternalServerError = 500,
 };
 StringView response_code_string(ResponseCode);
 
+// NOTE: Like "HTTP/1.1 200 OK\r\n", without formatting anything.
+StringView status_line(ResponseCode);
+
+// NOTE: 304 responses only confirm the client's copy, so they go
+//       out with neither a body nor the headers describing one.
+constexpr bool may_have_body(ResponseCode code)
+{
+    return code != ResponseCode::NotModified;
+}
+
 struct Response {
     StringView body { ""sv };
     StringView charset { "utf-8"sv };
     StringView extra_headers { ""sv };
-    Web::MimeType mime_type { Web::MimeType::TextPlain };
+    Web::MimeType mime_type { Web::MimeType::text_plain() };
     ResponseCode code { ResponseCode::Ok };
     bool keep_alive { false };
+
+    // NOTE: Responses to HEAD announce the body without sending it.
+    bool omit_body { false };
+
+    // NOTE: When set, body is the contents of this file, and
+    //       writers that can will send it straight from the file.
+    int body_fd { -1 };
+
+    // NOTE: Where body starts in body_fd, for parts of files.
+    u32 body_offset { 0 };
+
+    // NOTE: When set, pre-rendered headers sent in place of the ones
+    //       made from mime_type, charset and the size of body.
+    StringView head { ""sv };
 };
 
 }
@@ -47,22 +77,40 @@ struct Ty::Formatter<HTTP::Response> {
     {
         u32 size = 0;
 
-        size += TRY(
-            to.write("HTTP/1.1 "sv, response.code, "\r\n"sv));
-
-        size += TRY(
-            to.write("Content-Type: "sv, response.mime_type));
-        if (!response.charset.is_empty())
-            size += TRY(to.write("; charset="sv, response.charset));
-        size += TRY(to.write("\r\n"sv));
+        size += TRY(to.write(HTTP::status_line(response.code)));
+        if (!response.head.is_empty()) {
+            size += TRY(to.write(response.head));
+        } else if (HTTP::may_have_body(response.code)) {
+            size += TRY(
+                to.write("Content-Type: "sv, response.mime_type));
+            if (!response.charset.is_empty()) {
+                size += TRY(
+                    to.write("; charset="sv, response.charset));
+            }
+            size += TRY(to.write("\r\n"sv));
 
-        size += TRY(to.write("Content-Length: "sv,
-            response.body.size, "\r\n"sv));
-        size += TRY(to.write("Server: Dory\r\n"sv));
+            size += TRY(to.write("Content-Length: "sv,
+                response.body.size, "\r\n"sv));
+            size += TRY(to.write("Server: Dory\r\n"sv));
+        } else {
+            size += TRY(to.write("Server: Dory\r\n"sv));
+        }
         size += TRY(to.write("Connection: "sv,
-            response.keep_alive ? "keep-alive"sv : "closed"sv, "\r\n"sv));
+            response.keep_alive ? "keep-alive"sv : "close"sv,
+            "\r\n"sv));
         size += TRY(to.write(response.extra_headers));
-        size += TRY(to.write("\r\n"sv, response.body));
+        size += TRY(to.write("\r\n"sv));
+
+        if (response.omit_body
+            || !HTTP::may_have_body(response.code))
+            return size;
+        auto body = response.body;
+        auto fd = response.body_fd;
+        auto offset = response.body_offset;
+        if constexpr (requires { to.write_body(body, fd, offset); })
+            size += TRY(to.write_body(body, fd, offset));
+        else
+            size += TRY(to.write(body));
 
         return size;
     }
@@ -8,7 +8,8 @@ namespace Mem::Internal {
 ErrorOr<void> init(uptr base, uptr size)
 {
     auto page_size = TRY(System::page_size());
-    auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT;
+    auto flags
+        = MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT | MAP_NORESERVE;
 #if __linux__
     flags |= MAP_FIXED_NOREPLACE;
 #endif
@@ -22,16 +22,40 @@ struct AddressSpace {
     static ErrorOr<void> init()
     {
         TRY(Internal::init(base, size));
+        s_is_initialized = true;
         return {};
     }
 
     static ErrorOr<void> deinit()
     {
         TRY(Internal::deinit(base, size));
+        s_is_initialized = false;
         return {};
     }
 
+    // NOTE: Regions are handed out without a lock, so every thread
+    //       can allocate out of a region of its own. They are never
+    //       given back.
+    static ErrorOr<uptr> claim(usize region_size)
+    {
+        if (!s_is_initialized)
+            return Error::from_string_literal(
+                "address space not initialized");
+        auto offset = __atomic_fetch_add(&s_claimed, region_size,
+            __ATOMIC_RELAXED);
+        if (offset + region_size > size - guard_size)
+            return Error::from_string_literal(
+                "address space exhausted");
+        return base + offset;
+    }
+
 private:
+    // NOTE: Covers the guard page on every page size in use, null
+    //       points into it.
+    static constexpr auto guard_size = 64 * KiB;
+
+    static inline bool s_is_initialized = false;
+    static inline usize s_claimed = 0;
 };
 
 using LoRam = AddressSpace<64 * MiB, 4 * GiB>;
@@ -15,7 +15,8 @@ struct NullablePtr {
 
     static constexpr NullablePtr from_raw(T* raw)
     {
-        return { ((uptr)(raw)-address_space::base) };
+        auto offset = (uptr)(raw)-address_space::base;
+        return NullablePtr((u32)offset);
     }
 
     static constexpr NullablePtr from(u32 index)
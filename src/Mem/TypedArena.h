@@ -0,0 +1,100 @@
+#pragma once
+#include "AddressSpace.h"
+#include "NullablePtr.h"
+#include <Ty/ErrorOr.h>
+#include <Ty/Move.h>
+#include <Ty/New.h>
+#include <Ty/System.h>
+#include <Ty/Try.h>
+#include <Ty/Vector.h>
+
+namespace Mem {
+
+// Objects of one type addressed by 32-bit NullablePtrs. Memory is
+// claimed from the address space a chunk at a time, so arenas on
+// different threads never share a chunk and allocating takes no
+// lock. An arena belongs to the thread that uses it.
+template <typename T, typename AddressSpace,
+    usize chunk_size = 256 * KiB>
+struct TypedArena {
+    using Ptr = NullablePtr<T, AddressSpace>;
+
+    static_assert(chunk_size % (64 * KiB) == 0);
+    static_assert(alignof(T) <= 64 * KiB);
+
+    TypedArena() = default;
+
+    TypedArena(TypedArena&& other)
+        : m_chunks(move(other.m_chunks))
+        , m_free(other.m_free)
+        , m_next(other.m_next)
+        , m_end(other.m_end)
+    {
+        other.m_free = nullptr;
+        other.m_next = 0;
+        other.m_end = 0;
+    }
+
+    TypedArena(TypedArena const&) = delete;
+    TypedArena& operator=(TypedArena const&) = delete;
+
+    // NOTE: Objects still alive are not destroyed, their pages are
+    //       only handed back to the system.
+    ~TypedArena()
+    {
+        if (!is_valid())
+            return;
+        for (auto chunk : m_chunks) {
+            System::madvise((void*)chunk, chunk_size, MADV_DONTNEED)
+                .ignore();
+        }
+    }
+
+    template <typename... Args>
+    ErrorOr<Ptr> create(Args&&... args)
+    {
+        auto* slot = TRY(allocate());
+        return Ptr::from_raw(new (slot) T(forward<Args>(args)...));
+    }
+
+    void destroy(Ptr ptr)
+    {
+        ptr->~T();
+        new (ptr.raw()) Ptr(m_free);
+        m_free = ptr;
+    }
+
+private:
+    // NOTE: A freed slot holds the next free one.
+    static constexpr usize slot_size
+        = sizeof(T) > sizeof(Ptr) ? sizeof(T) : sizeof(Ptr);
+
+    ErrorOr<void*> allocate()
+    {
+        if (m_free) {
+            void* slot = m_free.raw();
+            m_free = *(Ptr*)slot;
+            return slot;
+        }
+        if (m_next + slot_size > m_end) {
+            auto chunk = TRY(AddressSpace::claim(chunk_size));
+            TRY(m_chunks.append(chunk));
+            m_next = chunk;
+            m_end = chunk + chunk_size;
+        }
+        auto* slot = (void*)m_next;
+        m_next += slot_size;
+        return slot;
+    }
+
+    // NOTE: Until the first chunk is claimed there is nothing to
+    //       give back, and a moved from arena looks the same.
+    bool is_valid() const { return m_end != 0; }
+
+    Vector<uptr> m_chunks {};
+    Ptr m_free { nullptr };
+    uptr m_next { 0 };
+    uptr m_end { 0 };
+};
+
+}
@@ -0,0 +1,36 @@
+#include "Address.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+namespace Net {
+
+Address Address::from(struct sockaddr_storage const& address)
+{
+    auto result = Address {};
+    if (address.ss_family == AF_INET6) {
+        auto const* in6 = (struct sockaddr_in6 const*)&address;
+        __builtin_memcpy(result.bytes, &in6->sin6_addr, 16);
+        result.port = ntohs(in6->sin6_port);
+        result.version = IPVersion::V6;
+        return result;
+    }
+    auto const* in = (struct sockaddr_in const*)&address;
+    __builtin_memcpy(result.bytes, &in->sin_addr, 4);
+    result.port = ntohs(in->sin_port);
+    result.version = IPVersion::V4;
+    return result;
+}
+
+ErrorOr<StringBuffer> Address::printable() const
+{
+    char buffer[INET6_ADDRSTRLEN + 1];
+    auto family = version == IPVersion::V4 ? AF_INET : AF_INET6;
+    auto const* printed
+        = ::inet_ntop(family, bytes, buffer, sizeof(buffer));
+    if (printed == nullptr)
+        return Error::from_errno();
+    return StringBuffer::create_fill(
+        StringView::from_c_string(buffer));
+}
+
+}
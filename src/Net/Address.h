@@ -0,0 +1,27 @@
+#pragma once
+#include <Ty/Base.h>
+#include <Ty/ErrorOr.h>
+#include <Ty/StringBuffer.h>
+#include <sys/socket.h>
+
+namespace Net {
+
+enum class IPVersion : u8 {
+    V4,
+    V6
+};
+
+// A peer address as the bytes that matter, sockaddr_storage spends
+// most of its 128 bytes on padding.
+struct Address {
+    static Address from(struct sockaddr_storage const& address);
+
+    ErrorOr<StringBuffer> printable() const;
+
+    // NOTE: IPv4 addresses take the first four bytes.
+    u8 bytes[16];
+    u16 port;
+    IPVersion version;
+};
+
+}
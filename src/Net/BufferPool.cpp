@@ -0,0 +1,115 @@
+#include "BufferPool.h"
+#include <Ty/BlockHeap.h>
+#include <Ty/Memory.h>
+#include <Ty/System.h>
+
+// NOTE: Buffers are blocks of a heap of 2 MiB slabs, one size per
+//       slab. give_back() tells them apart from overflows by their
+//       address.
+
+namespace Net::BufferPool {
+
+namespace {
+
+constexpr u32 size_index_of(u32 size)
+{
+    if (size <= min_size)
+        return 0;
+    return 32 - __builtin_clz(size - 1) - 12;
+}
+
+Limits s_limits {};
+
+struct Slabs {
+    static constexpr usize span_size = 2 * 1024 * 1024;
+    static constexpr usize reserve_size = 64LU * 1024 * 1024 * 1024;
+    static constexpr usize commit_size = span_size;
+    static constexpr u32 class_count = 5;
+
+    static constexpr usize class_size(u32 size_index)
+    {
+        return (usize)min_size << size_index;
+    }
+
+    static u32 batch_size(u32)
+    {
+        auto batch = s_limits.max_cached_per_thread / 2;
+        return batch == 0 ? 1 : batch;
+    }
+
+    // NOTE: Maps over the reserved range, a failed huge page
+    //       mapping may already have taken it down.
+    static bool commit(u8* slab, usize size)
+    {
+        auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED;
+        auto protection = PROT_READ | PROT_WRITE;
+        if (s_limits.use_huge_pages) {
+            auto huge = System::mmap(slab, size, protection,
+                flags | MAP_HUGETLB);
+            if (!huge.is_error())
+                return true;
+        }
+        if (System::mmap(slab, size, protection, flags).is_error())
+            return false;
+        if (s_limits.use_huge_pages)
+            System::madvise(slab, size, MADV_HUGEPAGE).ignore();
+        return true;
+    }
+};
+
+using Heap = BlockHeap<Slabs>;
+using Counters = Heap::Counters;
+
+static_assert(
+    Slabs::class_size(Slabs::class_count - 1) == max_size);
+static_assert(size_index_of(max_size) == Slabs::class_count - 1);
+static_assert(size_index_of(min_size + 1) == 1);
+
+}
+
+void configure(Limits limits)
+{
+    s_limits = limits;
+    Heap::set_limit(limits.max_mapped_bytes);
+}
+
+ErrorOr<Buffer> take(u32 size)
+{
+    Heap::count(&Counters::allocations, 1);
+    if (size <= max_size) {
+        auto size_index = size_index_of(size);
+        if (auto* chunk = Heap::allocate(size_index); chunk) {
+            auto capacity = (u32)Slabs::class_size(size_index);
+            return Buffer { (char*)chunk, capacity };
+        }
+    }
+    Heap::count(&Counters::overflow, 1);
+    return Buffer { (char*)TRY(allocate_memory(size)), size };
+}
+
+void give_back(char* data)
+{
+    if (!data)
+        return;
+    Heap::count(&Counters::frees, 1);
+    if (!Heap::contains(data)) {
+        free_memory(data);
+        return;
+    }
+    Heap::free(data, Heap::class_of(data));
+}
+
+Stats stats()
+{
+    auto stats = Heap::stats();
+    return Stats {
+        .taken = stats.counters.allocations,
+        .given_back = stats.counters.frees,
+        .bytes_in_use = stats.counters.bytes_in_use,
+        .cached_bytes = stats.counters.cached_bytes,
+        .mapped_bytes = stats.span_bytes,
+        .overflows = stats.counters.overflow,
+    };
+}
+
+}
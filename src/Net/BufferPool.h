@@ -0,0 +1,65 @@
+#pragma once
+#include <Ty/Base.h>
+#include <Ty/ErrorOr.h>
+
+// Page aligned buffers for socket I/O, shared by every connection.
+// Buffers come in a few fixed sizes, each thread keeps the ones
+// given back for its next take(), so steady traffic only moves
+// buffers between connections and never reaches the allocator.
+
+namespace Net::BufferPool {
+
+// NOTE: Sizes double from a page up to the largest, bigger buffers
+//       come from the general allocator.
+constexpr u32 min_size = 4 * 1024;
+constexpr u32 max_size = 64 * 1024;
+
+struct Limits {
+    // NOTE: The pool maps no more than this, buffers taken past it
+    //       come from the general allocator.
+    usize max_mapped_bytes { 1024LU * 1024 * 1024 };
+
+    // NOTE: Free buffers of each size a thread holds on to, past
+    //       this half of them are handed on to other threads.
+    u32 max_cached_per_thread { 64 };
+
+    // NOTE: Huge pages where the system has them reserved, and
+    //       transparent ones otherwise.
+    bool use_huge_pages { false };
+};
+
+struct Stats {
+    u64 taken;
+    u64 given_back;
+
+    // NOTE: Pooled buffers only, counted at their full size.
+    u64 bytes_in_use;
+    u64 cached_bytes;
+
+    // NOTE: Memory is never unmapped, so this is the high-water
+    //       mark of the pool as well.
+    u64 mapped_bytes;
+
+    // NOTE: Buffers that came from the general allocator, for being
+    //       too large or the pool being full.
+    u64 overflows;
+};
+
+struct Buffer {
+    char* data;
+    u32 capacity;
+};
+
+// NOTE: Limits apply to memory mapped from then on, so this is
+//       best done before the first take().
+void configure(Limits limits);
+
+// NOTE: The buffer holds at least size bytes, and goes back with
+//       give_back(), from whichever thread.
+ErrorOr<Buffer> take(u32 size);
+void give_back(char* data);
+
+// NOTE: Summed over all threads without stopping them.
+Stats stats();
+
+}
@@ -0,0 +1,816 @@
+#include "EventLoop.h"
+#include <HTTP/Response.h>
+#include <Ty/Defer.h>
+#include <Ty/System.h>
+#include <poll.h>
+#include <sys/epoll.h>
+
+namespace Net {
+
+namespace {
+
+constexpr u64 listener_token = 0xFFFFFFFFFFFFFFFF;
+constexpr auto max_events = 128;
+
+constexpr struct __kernel_timespec tick_interval {
+    .tv_sec = 0,
+    .tv_nsec = EventLoop::timer_tick_ms * 1000 * 1000,
+};
+
+// NOTE: A failed accept is most likely the process being out of
+//       descriptors, which closing clients frees up over time.
+constexpr u32 accept_backoff_ms = 100;
+constexpr struct __kernel_timespec accept_backoff {
+    .tv_sec = 0,
+    .tv_nsec = accept_backoff_ms * 1000 * 1000,
+};
+
+// NOTE: Pipelined requests are only answered while this little is
+//       queued, so a peer that does not read can not make the loop
+//       buffer responses, or hold files open, without bound.
+constexpr u32 max_pending_write_bytes = 64 * 1024;
+constexpr u32 max_pending_files = 8;
+
+bool is_backed_up(TCPConnection const& connection)
+{
+    auto bytes = connection.pending_write_bytes();
+    return bytes >= max_pending_write_bytes
+        || connection.pending_file_count() >= max_pending_files;
+}
+
+constexpr u32 ring_entries = 256;
+constexpr u16 receive_buffer_count = 256;
+constexpr u32 receive_buffer_size = 4096;
+
+// NOTE: The listener is the only registered file.
+constexpr int listener_file_index = 0;
+
+enum class Operation : u8 {
+    Accept,
+    Receive,
+    Send,
+    Writable,
+    Cancel,
+    Tick,
+    AcceptBackoff,
+};
+
+constexpr u32 generation_mask = 0xFFFFFF;
+
+constexpr u64 user_data(Operation operation, u32 slot,
+    u32 generation)
+{
+    return (u64)operation << 56
+        | (u64)(generation & generation_mask) << 32 | slot;
+}
+
+constexpr Operation operation_of(u64 user_data)
+{
+    return (Operation)(user_data >> 56);
+}
+
+}
+
+ErrorOr<EventLoop> EventLoop::create(TCPListener const& listener,
+    Core::File& log, Handler&& handler, Backend backend,
+    ConnectionLimits limits)
+{
+    TRY(listener.set_nonblocking());
+    auto event_loop
+        = EventLoop(listener, log, move(handler), limits);
+
+    if (backend == Backend::IOURing) {
+        auto result = event_loop.setup_io_uring();
+        if (!result.is_error())
+            return event_loop;
+        log.writeln("Could not set up io_uring ("sv, result.error(),
+               "), falling back to epoll"sv)
+            .ignore();
+    }
+
+    TRY(event_loop.setup_epoll());
+    return event_loop;
+}
+
+ErrorOr<void> EventLoop::setup_epoll()
+{
+    m_epoll_fd = TRY(System::epoll_create(EPOLL_CLOEXEC));
+
+    struct epoll_event event {
+        .events = EPOLLIN,
+        .data = { .u64 = listener_token },
+    };
+    TRY(System::epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD,
+        m_listener.socket(), &event));
+    return {};
+}
+
+ErrorOr<void> EventLoop::setup_io_uring()
+{
+    auto ring = TRY(Core::IOURing::create(ring_entries));
+    // NOTE: Provided buffer rings are from 5.19, same as multishot
+    //       accept, so this doubles as a feature check.
+    TRY(ring.register_buffer_ring(receive_buffer_count,
+        receive_buffer_size));
+    // NOTE: Clients stay plain descriptors, file segments go out
+    //       through sendfile(), which takes no direct descriptor.
+    //       No buffers are registered either. A plain SEND copies
+    //       out of the buffer, fixed buffers only spare pinning it,
+    //       which zero copy sends and O_DIRECT reads need. Files are
+    //       mapped when they are loaded, so there are no reads to
+    //       queue here either.
+    auto listener = m_listener.socket();
+    TRY(ring.register_files(&listener, 1));
+
+    m_ring = move(ring);
+    return {};
+}
+
+void EventLoop::destroy()
+{
+    for (u32 slot = 0; slot < m_clients.size(); slot++) {
+        if (m_clients[slot] != nullptr)
+            close_client(slot);
+    }
+    if (m_epoll_fd != -1)
+        System::close(m_epoll_fd).ignore();
+}
+
+ErrorOr<void> EventLoop::run()
+{
+    switch (backend()) {
+    case Backend::Epoll:
+        TRY(run_epoll());
+        return {};
+    case Backend::IOURing:
+        TRY(run_io_uring());
+        return {};
+    }
+}
+
+ErrorOr<void> EventLoop::run_epoll()
+{
+    struct epoll_event events[max_events];
+    while (true) {
+        // NOTE: Only ticks while there are timeouts to wait for.
+        auto timeout = -1;
+        if (!m_timers.is_empty())
+            timeout = timer_tick_ms;
+        if (m_accept_paused_until != 0)
+            timeout = accept_backoff_ms;
+        auto count = TRY(System::epoll_wait(m_epoll_fd, events,
+            max_events, timeout));
+        for (u32 i = 0; i < count; i++) {
+            auto const& event = events[i];
+            if (event.data.u64 == listener_token) {
+                accept_clients();
+                continue;
+            }
+
+            auto slot = (u32)event.data.u64;
+            if (m_clients[slot] == nullptr)
+                continue;
+            if (auto result = on_event(slot, event.events);
+                result.is_error()) {
+                m_log.writeln("Error: "sv, result.error()).ignore();
+                if (m_clients[slot] != nullptr)
+                    close_client(slot);
+            }
+            if (m_clients[slot] != nullptr)
+                update_timeout(slot);
+        }
+        close_timed_out_clients();
+        resume_accepting_if_due();
+    }
+}
+
+ErrorOr<void> EventLoop::on_event(u32 slot, u32 events)
+{
+    auto& client = *m_clients[slot];
+    switch (client.state) {
+    case State::Reading:
+        if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            TRY(on_readable(slot));
+        return {};
+    case State::Writing:
+        if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+            TRY(on_writable(slot));
+        return {};
+    }
+}
+
+// NOTE: Failing to accept only costs the connection in question,
+//       the clients already served are not affected.
+void EventLoop::accept_clients()
+{
+    while (true) {
+        auto maybe_client = m_listener.try_accept();
+        if (maybe_client.is_error()) {
+            m_log.writeln("Could not accept: "sv,
+                     maybe_client.error())
+                .ignore();
+            pause_accepting();
+            return;
+        }
+        auto client = maybe_client.release_value();
+        if (!client.has_value())
+            return;
+        if (auto result = watch_new_client(client.release_value());
+            result.is_error()) {
+            m_log.writeln("Could not add client: "sv,
+                     result.error())
+                .ignore();
+            return;
+        }
+    }
+}
+
+ErrorOr<void> EventLoop::watch_new_client(
+    TCPConnection&& connection)
+{
+    auto slot = TRY(add_client(move(connection)));
+    auto socket = m_clients[slot]->connection.socket;
+
+    struct epoll_event event {
+        .events = EPOLLIN | EPOLLRDHUP,
+        .data = { .u64 = slot },
+    };
+    if (auto result = System::epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD,
+            socket, &event);
+        result.is_error()) {
+        close_client(slot);
+        return result.release_error();
+    }
+    update_timeout(slot);
+    return {};
+}
+
+// NOTE: The listener is level triggered, so it is taken out of the
+//       epoll set, or it would be reported ready on every wait.
+void EventLoop::pause_accepting()
+{
+    if (m_accept_paused_until != 0)
+        return;
+    m_accept_paused_until
+        = System::monotonic_milliseconds() + accept_backoff_ms;
+    auto listener = m_listener.socket();
+    System::epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, listener, nullptr)
+        .ignore();
+}
+
+void EventLoop::resume_accepting_if_due()
+{
+    if (m_accept_paused_until == 0)
+        return;
+    if (System::monotonic_milliseconds() < m_accept_paused_until)
+        return;
+    struct epoll_event event {
+        .events = EPOLLIN,
+        .data = { .u64 = listener_token },
+    };
+    if (auto result = System::epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD,
+            m_listener.socket(), &event);
+        result.is_error()) {
+        m_log.writeln("Could not resume accepting: "sv,
+                 result.error())
+            .ignore();
+        m_accept_paused_until
+            = System::monotonic_milliseconds() + accept_backoff_ms;
+        return;
+    }
+    m_accept_paused_until = 0;
+}
+
+ErrorOr<u32> EventLoop::add_client(TCPConnection&& connection)
+{
+    auto client = TRY(m_client_arena.create(Client {
+        .connection = move(connection),
+        .generation = m_generation++ & generation_mask,
+    }));
+
+    u32 slot = m_clients.size();
+    if (!m_free_slots.is_empty()) {
+        slot = m_free_slots.take_last();
+        m_clients[slot] = client;
+    } else {
+        auto result = m_clients.append(client);
+        if (result.is_error()) {
+            m_client_arena.destroy(client);
+            return result.release_error();
+        }
+    }
+    client->timer.owner = slot;
+    return slot;
+}
+
+ErrorOr<void> EventLoop::on_readable(u32 slot)
+{
+    auto& client = *m_clients[slot];
+    auto progress = client.reader.receive(client.connection);
+    // NOTE: handle_requests() answers requests too large.
+    if (progress.is_error()) {
+        if (!client.reader.is_too_large())
+            return progress.release_error();
+    } else if (progress.value() == Progress::Closed) {
+        client.peer_closed = true;
+    }
+    TRY(handle_requests(slot));
+    TRY(on_writable(slot));
+    return {};
+}
+
+ErrorOr<void> EventLoop::on_writable(u32 slot)
+{
+    auto& client = *m_clients[slot];
+    while (true) {
+        auto progress = TRY(client.connection.try_flush_write());
+        if (progress == Progress::WouldBlock) {
+            if (client.state != State::Writing) {
+                client.state = State::Writing;
+                TRY(watch(slot, EPOLLOUT));
+            }
+            return {};
+        }
+        if (client.should_close) {
+            close_client(slot);
+            return {};
+        }
+        if (client.state == State::Writing) {
+            client.state = State::Reading;
+            TRY(watch(slot, EPOLLIN | EPOLLRDHUP));
+        }
+        // NOTE: Requests pipelined behind the ones just answered
+        //       may already be buffered, or have been held back
+        //       while the queue was full.
+        TRY(handle_requests(slot));
+        if (!client.connection.has_pending_write()
+            && !client.should_close)
+            return {};
+    }
+}
+
+ErrorOr<void> EventLoop::watch(u32 slot, u32 events)
+{
+    struct epoll_event event {
+        .events = events,
+        .data = { .u64 = slot },
+    };
+    TRY(System::epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD,
+        m_clients[slot]->connection.socket, &event));
+    return {};
+}
+
+ErrorOr<void> EventLoop::run_io_uring()
+{
+    auto& ring = m_ring.value();
+    TRY(submit_accept());
+    while (true) {
+        // NOTE: Only ticks while there are timeouts to wait for.
+        if (!m_is_ticking && !m_timers.is_empty())
+            TRY(submit_tick());
+        TRY(ring.submit_and_wait(1));
+        ring.for_each_completion([&](auto const& completion) {
+            if (auto result = on_completion(completion);
+                result.is_error())
+                m_log.writeln("Error: "sv, result.error()).ignore();
+        });
+    }
+}
+
+ErrorOr<void> EventLoop::on_completion(
+    Core::IOURing::CompletionEntry const& completion)
+{
+    auto more = (completion.flags & IORING_CQE_F_MORE) != 0;
+    switch (operation_of(completion.user_data)) {
+    case Operation::Accept:
+        // NOTE: Re-arming right away after a failure would only
+        //       fail again while descriptors are short.
+        if (completion.res < 0) {
+            if (!more)
+                TRY(submit_accept_backoff());
+            return Error::from_errno(-completion.res);
+        }
+        if (!more)
+            TRY(submit_accept());
+        TRY(on_accepted(completion.res));
+        return {};
+
+    case Operation::AcceptBackoff:
+        TRY(submit_accept());
+        return {};
+
+    case Operation::Receive: {
+        Defer recycle_buffer = [&] {
+            m_ring->recycle_buffer(completion);
+        };
+        auto* client = client_for(completion.user_data);
+        if (client == nullptr)
+            return {};
+        auto slot = (u32)completion.user_data;
+        if (!more)
+            client->is_receiving = false;
+
+        auto result = completion.res;
+        if (result == -ENOBUFS
+            || (result == -EINVAL && m_multishot_receive)) {
+            // NOTE: Multishot receive is from 6.0, fall back to
+            //       one receive per completion before that.
+            if (result == -EINVAL)
+                m_multishot_receive = false;
+            if (!client->is_receiving)
+                TRY(submit_receive(slot));
+            return {};
+        }
+        if (result == -ECANCELED || client->is_closing)
+            return {};
+        if (result < 0) {
+            close_client_after_send(slot);
+            return Error::from_errno(-result);
+        }
+
+        auto data = result > 0 ? m_ring->provided_buffer(completion)
+                               : StringView();
+        if (auto received = on_received(slot, data);
+            received.is_error()) {
+            if (m_clients[slot].raw() == client)
+                close_client_after_send(slot);
+            return received.release_error();
+        }
+        if (m_clients[slot].raw() != client)
+            return {};
+        update_timeout(slot);
+        if (!client->is_receiving && !client->peer_closed
+            && !client->should_close && !client->is_closing)
+            TRY(submit_receive(slot));
+        return {};
+    }
+
+    case Operation::Send: {
+        auto* client = client_for(completion.user_data);
+        if (client == nullptr)
+            return {};
+        auto slot = (u32)completion.user_data;
+        client->is_sending = false;
+        if (completion.res == -ECANCELED || client->is_closing) {
+            close_client(slot);
+            return {};
+        }
+        if (completion.res < 0) {
+            close_client(slot);
+            return Error::from_errno(-completion.res);
+        }
+        if (auto result = on_sent(slot, completion.res);
+            result.is_error()) {
+            if (m_clients[slot].raw() == client)
+                close_client_after_send(slot);
+            return result.release_error();
+        }
+        if (m_clients[slot].raw() == client)
+            update_timeout(slot);
+        return {};
+    }
+
+    case Operation::Writable: {
+        auto* client = client_for(completion.user_data);
+        if (client == nullptr)
+            return {};
+        auto slot = (u32)completion.user_data;
+        client->is_sending = false;
+        if (completion.res == -ECANCELED || client->is_closing) {
+            close_client(slot);
+            return {};
+        }
+        if (completion.res < 0) {
+            close_client(slot);
+            return Error::from_errno(-completion.res);
+        }
+        if (auto result = send_or_close(slot); result.is_error()) {
+            if (m_clients[slot].raw() == client)
+                close_client_after_send(slot);
+            return result.release_error();
+        }
+        if (m_clients[slot].raw() == client)
+            update_timeout(slot);
+        return {};
+    }
+
+    case Operation::Cancel:
+        return {};
+
+    case Operation::Tick:
+        m_is_ticking = false;
+        close_timed_out_clients();
+        return {};
+    }
+}
+
+EventLoop::Client* EventLoop::client_for(u64 user_data) const
+{
+    auto slot = (u32)user_data;
+    if (slot >= m_clients.size())
+        return nullptr;
+    auto client = m_clients[slot];
+    if (client == nullptr)
+        return nullptr;
+    if (client->generation != ((user_data >> 32) & generation_mask))
+        return nullptr;
+    return client.raw();
+}
+
+ErrorOr<void> EventLoop::on_accepted(int socket)
+{
+    auto connection
+        = TCPConnection::create(socket, {}, Blocking::No);
+    if (connection.is_error()) {
+        System::close(socket).ignore();
+        return connection.release_error();
+    }
+    auto slot = TRY(add_client(connection.release_value()));
+    if (auto result = submit_receive(slot); result.is_error()) {
+        close_client(slot);
+        return result.release_error();
+    }
+    update_timeout(slot);
+    return {};
+}
+
+ErrorOr<void> EventLoop::on_received(u32 slot, StringView data)
+{
+    auto& client = *m_clients[slot];
+    if (data.is_empty()) {
+        client.peer_closed = true;
+    } else {
+        // NOTE: handle_requests() answers requests too large.
+        auto result = client.reader.write(data);
+        if (result.is_error() && !client.reader.is_too_large())
+            return result.release_error();
+    }
+
+    // NOTE: Requests arriving during a send wait for it to finish,
+    //       so responses stay in order.
+    if (client.state == State::Writing)
+        return {};
+    TRY(handle_requests(slot));
+    TRY(send_or_close(slot));
+    return {};
+}
+
+ErrorOr<void> EventLoop::on_sent(u32 slot, u32 bytes)
+{
+    auto& client = *m_clients[slot];
+    auto progress = client.connection.did_flush(bytes);
+    if (progress == Progress::Complete) {
+        client.state = State::Reading;
+        TRY(handle_requests(slot));
+    }
+    TRY(send_or_close(slot));
+    return {};
+}
+
+ErrorOr<void> EventLoop::send_or_close(u32 slot)
+{
+    auto& client = *m_clients[slot];
+    auto& connection = client.connection;
+    while (connection.has_pending_write()) {
+        client.state = State::Writing;
+        if (!connection.unflushed_write().is_empty()) {
+            TRY(submit_send(slot));
+            return {};
+        }
+
+        // NOTE: io_uring has no sendfile, file segments are sent
+        //       right away and the ring only waits for room.
+        auto progress = TRY(connection.try_flush_write());
+        if (progress == Progress::WouldBlock) {
+            TRY(submit_poll_writable(slot));
+            return {};
+        }
+        client.state = State::Reading;
+        TRY(handle_requests(slot));
+    }
+    if (client.should_close)
+        close_client(slot);
+    return {};
+}
+
+ErrorOr<void> EventLoop::submit_accept()
+{
+    auto* entry = TRY(m_ring->submission_entry());
+    entry->opcode = IORING_OP_ACCEPT;
+    entry->fd = listener_file_index;
+    entry->flags = IOSQE_FIXED_FILE;
+    entry->ioprio = IORING_ACCEPT_MULTISHOT;
+    entry->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    entry->user_data = user_data(Operation::Accept, 0, 0);
+    return {};
+}
+
+ErrorOr<void> EventLoop::submit_receive(u32 slot)
+{
+    auto& client = *m_clients[slot];
+    auto* entry = TRY(m_ring->submission_entry());
+    entry->opcode = IORING_OP_RECV;
+    entry->fd = client.connection.socket;
+    entry->flags = IOSQE_BUFFER_SELECT;
+    entry->buf_group = Core::IOURing::buffer_group;
+    if (m_multishot_receive)
+        entry->ioprio = IORING_RECV_MULTISHOT;
+    entry->user_data
+        = user_data(Operation::Receive, slot, client.generation);
+    client.is_receiving = true;
+    return {};
+}
+
+ErrorOr<void> EventLoop::submit_send(u32 slot)
+{
+    auto& client = *m_clients[slot];
+    auto data = client.connection.unflushed_write();
+    auto* entry = TRY(m_ring->submission_entry());
+    entry->opcode = IORING_OP_SEND;
+    entry->fd = client.connection.socket;
+    entry->addr = (u64)data.data;
+    entry->len = data.size;
+    entry->msg_flags = client.connection.send_flags();
+    entry->user_data
+        = user_data(Operation::Send, slot, client.generation);
+    client.is_sending = true;
+    return {};
+}
+
+ErrorOr<void> EventLoop::submit_poll_writable(u32 slot)
+{
+    auto& client = *m_clients[slot];
+    auto* entry = TRY(m_ring->submission_entry());
+    entry->opcode = IORING_OP_POLL_ADD;
+    entry->fd = client.connection.socket;
+    entry->poll32_events = POLLOUT;
+    entry->user_data
+        = user_data(Operation::Writable, slot, client.generation);
+    client.is_sending = true;
+    return {};
+}
+
+ErrorOr<void> EventLoop::submit_cancel(u64 target)
+{
+    auto* entry = TRY(m_ring->submission_entry());
+    entry->opcode = IORING_OP_ASYNC_CANCEL;
+    entry->fd = -1;
+    entry->addr = target;
+    entry->user_data = user_data(Operation::Cancel, 0, 0);
+    return {};
+}
+
+ErrorOr<void> EventLoop::submit_tick()
+{
+    auto* entry = TRY(m_ring->submission_entry());
+    entry->opcode = IORING_OP_TIMEOUT;
+    entry->fd = -1;
+    entry->addr = (u64)&tick_interval;
+    entry->len = 1;
+    entry->user_data = user_data(Operation::Tick, 0, 0);
+    m_is_ticking = true;
+    return {};
+}
+
+ErrorOr<void> EventLoop::submit_accept_backoff()
+{
+    auto* entry = TRY(m_ring->submission_entry());
+    entry->opcode = IORING_OP_TIMEOUT;
+    entry->fd = -1;
+    entry->addr = (u64)&accept_backoff;
+    entry->len = 1;
+    entry->user_data = user_data(Operation::AcceptBackoff, 0, 0);
+    return {};
+}
+
+ErrorOr<void> EventLoop::handle_requests(u32 slot)
+{
+    auto& client = *m_clients[slot];
+    auto is_drained = false;
+    while (!client.should_close) {
+        // NOTE: Picked up again once the queue has been flushed.
+        if (is_backed_up(client.connection))
+            break;
+        auto request = TRY(client.reader.next_request());
+        if (!request.has_value()) {
+            is_drained = true;
+            break;
+        }
+
+        auto may_keep_alive = KeepAlive::No;
+        if (client.requests_served + 1 < m_limits.max_requests)
+            may_keep_alive = KeepAlive::Yes;
+        auto keep_alive = TRY(m_handler(client.connection,
+            request.value(), may_keep_alive));
+        client.requests_served++;
+        // NOTE: A head behind this one gets a deadline of its own.
+        m_timers.cancel(client.timer);
+        if (keep_alive == KeepAlive::No)
+            client.should_close = true;
+    }
+
+    // NOTE: The peer is told why before the connection is closed,
+    //       once the requests that did fit have been answered.
+    if (is_drained && client.reader.is_too_large()) {
+        auto code = HTTP::ResponseCode::RequestHeaderFieldsTooLarge;
+        if (client.reader.phase() == ReadPhase::Body)
+            code = HTTP::ResponseCode::ContentTooLarge;
+        TRY(client.connection.write(HTTP::Response {
+            .body = HTTP::response_code_string(code),
+            .code = code,
+        }));
+        client.should_close = true;
+    }
+
+    // NOTE: Whatever is left once the peer has closed can never
+    //       become a complete request.
+    if (client.peer_closed && is_drained)
+        client.should_close = true;
+    client.reader.release_if_idle();
+    return {};
+}
+
+// NOTE: A head has to be in by its deadline however slowly it
+//       trickles in, the other timeouts start over on progress.
+void EventLoop::update_timeout(u32 slot)
+{
+    auto& client = *m_clients[slot];
+    if (client.is_closing)
+        return;
+    auto timeout = Timeout::Write;
+    auto seconds = m_limits.write_timeout_seconds;
+    if (client.state == State::Reading) {
+        switch (client.reader.phase()) {
+        case ReadPhase::Idle:
+            timeout = Timeout::Idle;
+            seconds = m_limits.idle_timeout_seconds;
+            break;
+        case ReadPhase::Head:
+            timeout = Timeout::Header;
+            seconds = m_limits.header_timeout_seconds;
+            break;
+        case ReadPhase::Body:
+            timeout = Timeout::Body;
+            seconds = m_limits.body_timeout_seconds;
+            break;
+        }
+    }
+    if (timeout == Timeout::Header && client.timeout == timeout
+        && client.timer.is_scheduled())
+        return;
+    client.timeout = timeout;
+    if (seconds == 0) {
+        m_timers.cancel(client.timer);
+        return;
+    }
+    m_timers.schedule(client.timer,
+        System::monotonic_milliseconds() + seconds * 1000ull);
+}
+
+void EventLoop::close_timed_out_clients()
+{
+    auto now = System::monotonic_milliseconds();
+    m_timers.advance(now, [&](auto& timer) {
+        close_client_after_send(timer.owner);
+    });
+}
+
+// NOTE: A send in flight is cancelled, and the client closed once
+//       its completion comes in.
+void EventLoop::close_client_after_send(u32 slot)
+{
+    auto& client = *m_clients[slot];
+    if (!client.is_sending) {
+        close_client(slot);
+        return;
+    }
+    if (client.is_closing)
+        return;
+    client.is_closing = true;
+    m_timers.cancel(client.timer);
+    submit_cancel(
+        user_data(Operation::Send, slot, client.generation))
+        .ignore();
+    submit_cancel(
+        user_data(Operation::Writable, slot, client.generation))
+        .ignore();
+}
+
+void EventLoop::close_client(u32 slot)
+{
+    auto client = m_clients[slot];
+    // NOTE: A pending receive holds a reference to the socket,
+    //       which would keep it open past the close below.
+    if (m_ring.has_value() && client->is_receiving) {
+        submit_cancel(user_data(Operation::Receive, slot,
+                          client->generation))
+            .ignore();
+    }
+    m_timers.cancel(client->timer);
+    // NOTE: Closing the socket removes it from the epoll set.
+    m_client_arena.destroy(client);
+    m_clients[slot] = nullptr;
+    m_free_slots.append(slot).ignore();
+}
+
+}
@@ -0,0 +1,226 @@
+#pragma once
+#include "RequestReader.h"
+#include "TCPConnection.h"
+#include "TCPListener.h"
+#include <Core/File.h>
+#include <Core/IOURing.h>
+#include <Mem/TypedArena.h>
+#include <Ty/ErrorOr.h>
+#include <Ty/Optional.h>
+#include <Ty/SmallCapture.h>
+#include <Ty/StringBuffer.h>
+#include <Ty/System.h>
+#include <Ty/TimerWheel.h>
+#include <Ty/Vector.h>
+
+namespace Net {
+
+enum class Backend : u8 {
+    Epoll,
+    IOURing,
+};
+
+enum class KeepAlive : bool {
+    No = false,
+    Yes = true,
+};
+
+// NOTE: Timeouts are in seconds, zero for none.
+struct ConnectionLimits {
+    // NOTE: Between requests on a kept alive connection.
+    u32 idle_timeout_seconds { 5 };
+
+    // NOTE: For the whole head, however slowly it trickles in.
+    u32 header_timeout_seconds { 10 };
+
+    // NOTE: Between reads of a body, and between sends.
+    u32 body_timeout_seconds { 10 };
+    u32 write_timeout_seconds { 10 };
+
+    u32 max_requests { 1000 };
+};
+
+// Single threaded reactor. Multiplexes a listener and all of its
+// clients, each client is driven through a small state machine:
+//
+//     Reading -> (handler)* -> Writing -> Reading ... -> closed
+//
+// Pipelined requests are handled in order as soon as they are
+// complete, their responses queue up in the client's write buffer.
+// Once a few are queued, the rest wait for them to be sent.
+//
+// The epoll backend waits for readiness and does the I/O itself,
+// the io_uring backend queues accepts, receives and sends up front
+// and reacts to their completions, needing one syscall per batch.
+//
+// Each client has one timeout running at a time, for what it is
+// waiting on, kept in a timer wheel that the loop advances a tick
+// at a time while any are running.
+struct EventLoop {
+    // NOTE: Gets one request at a time, and whether the connection
+    //       may stay open after it. Returns whether the response it
+    //       wrote keeps the connection open.
+    using Handler = SmallCapture<ErrorOr<KeepAlive>(TCPConnection&,
+        HTTP::Request const&, KeepAlive)>;
+
+    // NOTE: Timeouts are seconds, so are checked for this often and
+    //       met up to this much late.
+    static constexpr u32 timer_tick_ms = 100;
+
+    // NOTE: Falls back to epoll if io_uring is unavailable, check
+    //       backend() for the one actually in use.
+    static ErrorOr<EventLoop> create(TCPListener const& listener,
+        Core::File& log, Handler&& handler,
+        Backend backend = Backend::Epoll,
+        ConnectionLimits limits = {});
+
+    EventLoop(EventLoop&& other)
+        : m_client_arena(move(other.m_client_arena))
+        , m_clients(move(other.m_clients))
+        , m_free_slots(move(other.m_free_slots))
+        , m_handler(other.m_handler)
+        , m_listener(other.m_listener)
+        , m_log(other.m_log)
+        , m_ring(move(other.m_ring))
+        , m_limits(other.m_limits)
+        , m_timers(move(other.m_timers))
+        , m_generation(other.m_generation)
+        , m_multishot_receive(other.m_multishot_receive)
+        , m_is_ticking(other.m_is_ticking)
+        , m_accept_paused_until(other.m_accept_paused_until)
+        , m_epoll_fd(other.m_epoll_fd)
+    {
+        other.invalidate();
+    }
+
+    ~EventLoop()
+    {
+        if (is_valid()) {
+            destroy();
+            invalidate();
+        }
+    }
+
+    ErrorOr<void> run();
+
+    Backend backend() const
+    {
+        if (m_ring.has_value())
+            return Backend::IOURing;
+        return Backend::Epoll;
+    }
+
+private:
+    enum class State : u8 {
+        Reading,
+        Writing,
+    };
+
+    enum class Timeout : u8 {
+        Idle,
+        Header,
+        Body,
+        Write,
+    };
+
+    struct Client {
+        TCPConnection connection;
+        RequestReader reader {};
+
+        // NOTE: Owned by the slot, so it can be found on expiry.
+        TimerWheel::Timer timer {};
+        u32 requests_served { 0 };
+        State state { State::Reading };
+        Timeout timeout { Timeout::Idle };
+        bool peer_closed { false };
+        bool should_close { false };
+
+        // NOTE: Completions may arrive after the slot has been
+        //       reused, they carry the generation to tell apart.
+        u32 generation { 0 };
+        bool is_receiving { false };
+
+        // NOTE: While a send or a poll for room is in flight, the
+        //       kernel may be reading from the write buffer, so it
+        //       has to complete before the client can be closed.
+        bool is_sending { false };
+        bool is_closing { false };
+    };
+
+    EventLoop(TCPListener const& listener, Core::File& log,
+        Handler&& handler, ConnectionLimits limits)
+        : m_handler(handler)
+        , m_listener(listener)
+        , m_log(log)
+        , m_limits(limits)
+        , m_timers(timer_tick_ms,
+              System::monotonic_milliseconds())
+    {
+    }
+
+    ErrorOr<void> setup_epoll();
+    ErrorOr<void> setup_io_uring();
+
+    ErrorOr<void> run_epoll();
+    void accept_clients();
+    ErrorOr<void> watch_new_client(TCPConnection&& connection);
+    void pause_accepting();
+    void resume_accepting_if_due();
+    ErrorOr<void> on_event(u32 slot, u32 events);
+    ErrorOr<void> on_readable(u32 slot);
+    ErrorOr<void> on_writable(u32 slot);
+    ErrorOr<void> watch(u32 slot, u32 events);
+
+    ErrorOr<void> run_io_uring();
+    ErrorOr<void> on_completion(
+        Core::IOURing::CompletionEntry const& completion);
+    Client* client_for(u64 user_data) const;
+    ErrorOr<void> on_accepted(int socket);
+    ErrorOr<void> on_received(u32 slot, StringView data);
+    ErrorOr<void> on_sent(u32 slot, u32 bytes);
+    ErrorOr<void> send_or_close(u32 slot);
+    ErrorOr<void> submit_accept();
+    ErrorOr<void> submit_receive(u32 slot);
+    ErrorOr<void> submit_send(u32 slot);
+    ErrorOr<void> submit_poll_writable(u32 slot);
+    ErrorOr<void> submit_cancel(u64 target);
+    ErrorOr<void> submit_tick();
+    ErrorOr<void> submit_accept_backoff();
+
+    ErrorOr<u32> add_client(TCPConnection&& connection);
+    ErrorOr<void> handle_requests(u32 slot);
+    void update_timeout(u32 slot);
+    void close_timed_out_clients();
+    void close_client(u32 slot);
+    void close_client_after_send(u32 slot);
+
+    void destroy();
+    bool is_valid() const
+    {
+        return m_epoll_fd != -1 || m_ring.has_value();
+    }
+    // NOTE: Moving out of m_ring already leaves it empty.
+    void invalidate() { m_epoll_fd = -1; }
+
+    // NOTE: Slots take four bytes rather than eight, the records
+    //       live in Mem::LoRam, which has to be initialized.
+    Mem::TypedArena<Client, Mem::LoRam> m_client_arena {};
+    Vector<Mem::NullableLoPtr<Client>> m_clients {};
+    Vector<u32> m_free_slots {};
+    Handler m_handler;
+    TCPListener const& m_listener;
+    Core::File& m_log;
+    Optional<Core::IOURing> m_ring {};
+    ConnectionLimits m_limits {};
+    TimerWheel m_timers;
+    u32 m_generation { 0 };
+    bool m_multishot_receive { true };
+    bool m_is_ticking { false };
+
+    // NOTE: Zero unless accepting failed for want of descriptors or
+    //       memory, it is tried again once this time has come.
+    u64 m_accept_paused_until { 0 };
+    int m_epoll_fd { -1 };
+};
+
+}
@@ -0,0 +1,133 @@
+#include "RequestReader.h"
+#include "BufferPool.h"
+#include <errno.h>
+#include <sys/socket.h>
+
+namespace Net {
+
+namespace {
+
+// NOTE: Receiving into less than this is not worth the syscall,
+//       the pending bytes are moved or the buffer grown instead.
+constexpr u32 min_receive_size = 1024;
+
+Optional<u32> find_end_of_head(StringView source, u32 from)
+{
+    auto terminator = "\r\n\r\n"sv;
+    auto index
+        = source.shrink_from_start(from).find_first(terminator);
+    if (!index.has_value())
+        return {};
+    return from + index.value() + terminator.size;
+}
+
+}
+
+void RequestReader::destroy() const
+{
+    BufferPool::give_back(m_data);
+}
+
+void RequestReader::release_if_idle()
+{
+    if (m_start != m_end || !is_valid())
+        return;
+    destroy();
+    invalidate();
+    m_capacity = 0;
+    m_start = 0;
+    m_end = 0;
+    m_searched = 0;
+}
+
+ErrorOr<Progress> RequestReader::receive(
+    TCPConnection const& connection)
+{
+    TRY(reserve(min_receive_size));
+    while (true) {
+        auto bytes_read = ::recv(connection.socket, m_data + m_end,
+            m_capacity - m_end, 0);
+        if (bytes_read < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return Progress::WouldBlock;
+            if (errno == EINTR)
+                continue;
+            return Error::from_errno();
+        }
+        if (bytes_read == 0)
+            return Progress::Closed;
+        m_end += (u32)bytes_read;
+        return Progress::Complete;
+    }
+}
+
+ErrorOr<void> RequestReader::write(StringView data)
+{
+    TRY(reserve(data.size));
+    m_end += data.unchecked_copy_to(m_data + m_end);
+    return {};
+}
+
+ErrorOr<Optional<HTTP::Request>> RequestReader::next_request()
+{
+    auto pending = this->pending();
+    if (m_message_size == 0) {
+        auto end_of_head = find_end_of_head(pending, m_searched);
+        if (!end_of_head.has_value()) {
+            // NOTE: The terminator may straddle the next receive.
+            m_searched = pending.size < 3 ? 0 : pending.size - 3;
+            return Optional<HTTP::Request> {};
+        }
+    } else if (pending.size < m_message_size) {
+        return Optional<HTTP::Request> {};
+    }
+
+    // NOTE: The body usually arrives along with the head, so this
+    //       is the only parse. Otherwise the head is parsed again
+    //       once the rest of the body is in.
+    auto request = TRY(HTTP::Request::parse(pending));
+    if (!request.has_body()) {
+        m_message_size = request.message_size();
+        return Optional<HTTP::Request> {};
+    }
+    m_start += request.message_size();
+    m_searched = 0;
+    m_message_size = 0;
+    return Optional<HTTP::Request>(request);
+}
+
+ErrorOr<void> RequestReader::reserve(u32 size)
+{
+    if (m_start == m_end) {
+        m_start = 0;
+        m_end = 0;
+    }
+    if (m_capacity - m_end >= size)
+        return {};
+
+    if (m_start != 0) {
+        __builtin_memmove(m_data, m_data + m_start,
+            m_end - m_start);
+        m_end -= m_start;
+        m_start = 0;
+        if (m_capacity - m_end >= size)
+            return {};
+    }
+
+    auto capacity = m_capacity == 0 ? initial_capacity : m_capacity;
+    while (capacity - m_end < size)
+        capacity *= 2;
+    if (capacity > max_capacity) {
+        m_is_too_large = true;
+        return Error::from_string_literal("request is too large");
+    }
+    auto buffer = TRY(BufferPool::take(capacity));
+    if (m_end != 0)
+        __builtin_memcpy(buffer.data, m_data, m_end);
+    BufferPool::give_back(m_data);
+    m_data = buffer.data;
+    m_capacity = buffer.capacity;
+    return {};
+}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "TCPConnection.h"
+#include <HTTP/Request.h>
+#include <Ty/ErrorOr.h>
+#include <Ty/Optional.h>
+#include <Ty/StringView.h>
+
+namespace Net {
+
+enum class ReadPhase : u8 {
+    Idle,
+    Head,
+    Body,
+};
+
+// Reads requests into a buffer that is reused for every request on
+// a connection. Bytes are received straight into the free space
+// after the pending ones, and complete requests are handed out as
+// views into the buffer. Consumed bytes are reclaimed by moving the
+// pending ones to the front once the free space runs low.
+struct RequestReader {
+    static constexpr u32 initial_capacity = 4 * 1024;
+    static constexpr u32 max_capacity = 64 * 1024;
+
+    constexpr RequestReader() = default;
+
+    RequestReader(RequestReader&& other)
+        : m_data(other.m_data)
+        , m_capacity(other.m_capacity)
+        , m_start(other.m_start)
+        , m_end(other.m_end)
+        , m_searched(other.m_searched)
+        , m_message_size(other.m_message_size)
+        , m_is_too_large(other.m_is_too_large)
+    {
+        other.invalidate();
+    }
+
+    ~RequestReader()
+    {
+        if (is_valid()) {
+            destroy();
+            invalidate();
+        }
+    }
+
+    // NOTE: Does a single receive, WouldBlock means the socket has
+    //       nothing more, or the receive timed out.
+    ErrorOr<Progress> receive(TCPConnection const& connection);
+
+    // NOTE: For bytes received by someone else.
+    ErrorOr<void> write(StringView data);
+
+    // NOTE: The next complete request, headers and body. It points
+    //       into the buffer, so it is only valid until the next
+    //       receive() or write().
+    ErrorOr<Optional<HTTP::Request>> next_request();
+
+    StringView pending() const
+    {
+        return StringView(m_data + m_start, m_end - m_start);
+    }
+
+    // NOTE: What is pending once next_request() has no more, the
+    //       start of a head, or a head waiting for its body.
+    ReadPhase phase() const
+    {
+        if (m_message_size != 0)
+            return ReadPhase::Body;
+        if (m_start != m_end)
+            return ReadPhase::Head;
+        return ReadPhase::Idle;
+    }
+
+    // NOTE: Set once a request outgrew max_capacity. What did not
+    //       fit is dropped, so nothing after it can be read.
+    bool is_too_large() const { return m_is_too_large; }
+
+    // NOTE: The buffer is taken on the next receive() or write(),
+    //       so idle keep-alive connections hold none.
+    void release_if_idle();
+
+private:
+    ErrorOr<void> reserve(u32 size);
+
+    void destroy() const;
+    bool is_valid() const { return m_data != nullptr; }
+    void invalidate() { m_data = nullptr; }
+
+    char* m_data { nullptr };
+    u32 m_capacity { 0 };
+    u32 m_start { 0 };
+    u32 m_end { 0 };
+
+    // NOTE: Where the current request is at, relative to m_start,
+    //       so partial reads do not search it from the start again.
+    u32 m_searched { 0 };
+    u32 m_message_size { 0 };
+    bool m_is_too_large { false };
+};
+
+}
@@ -3,27 +3,36 @@
 #include <Ty/StringBuffer.h>
 #include <Ty/System.h>
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#    include <sys/sendfile.h>
+#endif
+
 namespace Net {
 
+namespace {
+
+// NOTE: Below this, copying a file is cheaper than the dup,
+//       sendfile and close it takes to send it directly.
+constexpr u32 sendfile_threshold = 16 * 1024;
+
+}
+
 ErrorOr<TCPConnection> TCPConnection::create(int socket,
-    struct sockaddr_storage address, socklen_t address_size)
+    Address address, Blocking blocking)
 {
-    return TCPConnection {
-        address,
-        address_size,
-        socket,
-        TRY(StringBuffer::create()),
-    };
+    return TCPConnection { address, socket, blocking };
 }
 
 void TCPConnection::destroy() const
 {
     flush_write().ignore();
+    clear_written();
     ::close(socket);
 }
 
@@ -43,54 +52,175 @@ ErrorOr<TCPConnection> TCPConnection::connect(StringView host,
 
     struct sockaddr_storage addr { };
     __builtin_memcpy(&addr, res->ai_addr, res->ai_addrlen);
-    return TRY(create(socket, addr, res->ai_addrlen));
+    return TRY(create(socket, Address::from(addr)));
+}
+
+ErrorOr<u32> TCPConnection::write(StringView message)
+{
+    // NOTE: Non-blocking connections buffer the whole response and
+    //       get flushed by the event loop when the socket is ready.
+    if (blocking == Blocking::Yes
+        && write_buffer.size_left() < message.size)
+        TRY(flush_write());
+    return TRY(write_buffer.write(message));
 }
 
-ErrorOr<StringBuffer> TCPConnection::read() const
+ErrorOr<u32> TCPConnection::write_body(StringView contents, int fd,
+    u32 offset)
 {
-    auto result = TRY(StringBuffer::create());
-
-    isize bytes_read = -1;
-    while (true) {
-        char buffer[1024];
-        isize buffer_size = sizeof(buffer);
-        bytes_read = TRY(System::recv(socket, buffer, buffer_size));
-        buffer[bytes_read] = '\0';
-        TRY(result.write(StringView::from_c_string(buffer)));
-        if (bytes_read == 0)
-            break; // NOTE: Client closed connection.
-        if (bytes_read < buffer_size)
-            break;
+#ifdef __linux__
+    if (fd != -1 && contents.size >= sendfile_threshold) {
+        // NOTE: The file may be reloaded, closing fd, before the
+        //       segment has been sent.
+        auto own_fd = TRY(System::fcntl(fd, F_DUPFD_CLOEXEC));
+        auto result = file_segments.append(FileSegment {
+            .buffer_offset = write_buffer.size(),
+            .offset = offset,
+            .end = offset + contents.size,
+            .fd = own_fd,
+        });
+        if (result.is_error()) {
+            System::close(own_fd).ignore();
+            return result.release_error();
+        }
+        return contents.size;
     }
+#endif
+    (void)fd;
+    (void)offset;
+    if (blocking == Blocking::No
+        || contents.size <= write_buffer.size_left())
+        return TRY(write(contents));
 
-    return result;
+    if (files_flushed < file_segments.size())
+        TRY(flush_write());
+    u32 body_flushed = 0;
+    while (body_flushed < contents.size) {
+        auto head = unflushed_write();
+        auto body = contents.shrink_from_start(body_flushed);
+        IOVec iovec[] = {
+            { head.data, head.size },
+            { body.data, body.size },
+        };
+        u32 bytes
+            = TRY(System::send(socket, iovec, 2, MSG_NOSIGNAL));
+        auto head_bytes = bytes < head.size ? bytes : head.size;
+        bytes_flushed += head_bytes;
+        body_flushed += bytes - head_bytes;
+    }
+    clear_written();
+    return contents.size;
 }
 
-ErrorOr<u32> TCPConnection::write(StringView message)
+StringView TCPConnection::unflushed_write() const
 {
-    if (write_buffer.size_left() < message.size)
-        TRY(flush_write());
-    return TRY(write_buffer.write(message));
+    u32 end = write_buffer.size();
+    if (files_flushed < file_segments.size())
+        end = file_segments[files_flushed].buffer_offset;
+    return write_buffer.view().part(bytes_flushed, end);
 }
 
-ErrorOr<void> TCPConnection::flush_write() const
+int TCPConnection::send_flags() const
 {
-    u32 bytes_written = 0;
+    if (files_flushed < file_segments.size())
+        return MSG_NOSIGNAL | MSG_MORE;
+    return MSG_NOSIGNAL;
+}
 
-    while (bytes_written < write_buffer.size()) {
-        auto view
-            = write_buffer.view().shrink_from_start(bytes_written);
-        bytes_written
-            += TRY(System::send(socket, view, MSG_NOSIGNAL));
+ErrorOr<Progress> TCPConnection::try_flush_write() const
+{
+    while (has_pending_write()) {
+        auto view = unflushed_write();
+        if (view.is_empty()) {
+            if (TRY(try_send_file()) == Progress::WouldBlock)
+                return Progress::WouldBlock;
+            continue;
+        }
+        auto rv
+            = ::send(socket, view.data, view.size, send_flags());
+        if (rv < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return Progress::WouldBlock;
+            if (errno == EINTR)
+                continue;
+            return Error::from_errno();
+        }
+        bytes_flushed += rv;
+    }
+    clear_written();
+    return Progress::Complete;
+}
+
+ErrorOr<Progress> TCPConnection::try_send_file() const
+{
+#ifdef __linux__
+    auto& segment = file_segments[files_flushed];
+    while (segment.offset < segment.end) {
+        off_t offset = segment.offset;
+        auto rv = ::sendfile(socket, segment.fd, &offset,
+            segment.end - segment.offset);
+        if (rv < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return Progress::WouldBlock;
+            if (errno == EINTR)
+                continue;
+            return Error::from_errno();
+        }
+        if (rv == 0)
+            return Error::from_string_literal(
+                "file was truncated while being sent");
+        segment.offset += rv;
+    }
+    System::close(segment.fd).ignore();
+    segment.fd = -1;
+    files_flushed++;
+    return Progress::Complete;
+#else
+    return Error::from_errno(ENOTSUP);
+#endif
+}
+
+Progress TCPConnection::did_flush(u32 bytes) const
+{
+    bytes_flushed += bytes;
+    if (has_pending_write())
+        return Progress::WouldBlock;
+    clear_written();
+    return Progress::Complete;
+}
+
+void TCPConnection::clear_written() const
+{
+    for (auto const& segment : file_segments) {
+        if (segment.fd != -1)
+            System::close(segment.fd).ignore();
+    }
+    file_segments.clear();
+    files_flushed = 0;
+    write_buffer.release();
+    bytes_flushed = 0;
+}
+
+ErrorOr<void> TCPConnection::flush_write() const
+{
+    while (has_pending_write()) {
+        auto view = unflushed_write();
+        if (view.is_empty()) {
+            if (TRY(try_send_file()) == Progress::WouldBlock)
+                return Error::from_errno(EAGAIN);
+            continue;
+        }
+        bytes_flushed
+            += TRY(System::send(socket, view, send_flags()));
     }
-    write_buffer.clear();
+    clear_written();
 
     return {};
 }
 
 ErrorOr<StringBuffer> TCPConnection::printable_address() const
 {
-    return TRY(System::inet_ntop(address));
+    return TRY(address.printable());
 }
 
 }
@@ -1,22 +1,52 @@
 #pragma once
+#include "Address.h"
+#include "WriteBuffer.h"
 #include <Ty/StringBuffer.h>
 #include <Ty/StringView.h>
+#include <Ty/Vector.h>
 #include <sys/socket.h>
 
 namespace Net {
 
+enum class Blocking : bool {
+    No = false,
+    Yes = true,
+};
+
+enum class Progress : u8 {
+    Complete,
+    WouldBlock,
+    Closed,
+};
+
+// A file queued to be sent straight from its descriptor, once the
+// write buffer has been flushed up to buffer_offset. The bytes from
+// offset up to end are what is left to send.
+struct FileSegment {
+    u32 buffer_offset;
+    u32 offset;
+    u32 end;
+    int fd;
+};
+
 struct TCPConnection {
-    struct sockaddr_storage address;
-    socklen_t address_size;
+    Address address;
 
     int socket;
-    mutable StringBuffer write_buffer;
+    mutable WriteBuffer write_buffer {};
+    mutable Vector<FileSegment> file_segments {};
+    mutable u32 bytes_flushed { 0 };
+    mutable u32 files_flushed { 0 };
+    Blocking blocking { Blocking::Yes };
 
     constexpr TCPConnection(TCPConnection&& other)
         : address(other.address)
-        , address_size(other.address_size)
         , socket(other.socket)
         , write_buffer(move(other.write_buffer))
+        , file_segments(move(other.file_segments))
+        , bytes_flushed(other.bytes_flushed)
+        , files_flushed(other.files_flushed)
+        , blocking(other.blocking)
     {
         other.invalidate();
     }
@@ -30,9 +60,50 @@ struct TCPConnection {
     }
 
     static ErrorOr<TCPConnection> connect(StringView host, u16 port);
-    static ErrorOr<TCPConnection> create(int socket, struct sockaddr_storage, socklen_t);
-    ErrorOr<StringBuffer> read() const;
+    static ErrorOr<TCPConnection> create(int socket, Address,
+        Blocking = Blocking::Yes);
     ErrorOr<void> flush_write() const;
+
+    // NOTE: Non-blocking variant, stops as soon as the socket would
+    //       block instead of waiting for it.
+    ErrorOr<Progress> try_flush_write() const;
+    bool has_pending_write() const
+    {
+        return bytes_flushed < write_buffer.size()
+            || files_flushed < file_segments.size();
+    }
+
+    // NOTE: Queued and not sent yet, each file holding a descriptor
+    //       until it is.
+    u32 pending_write_bytes() const
+    {
+        return write_buffer.size() - bytes_flushed;
+    }
+    u32 pending_file_count() const
+    {
+        return file_segments.size() - files_flushed;
+    }
+
+    // NOTE: For completion based I/O, where the send is issued by
+    //       someone else and only reported back here. Returns the
+    //       buffered bytes up to the next file, which is empty once
+    //       a file is next in line.
+    StringView unflushed_write() const;
+    Progress did_flush(u32 bytes) const;
+
+    // NOTE: Flags for sending unflushed_write(), these ask the
+    //       kernel to hold back partial segments if a file follows.
+    int send_flags() const;
+
+    // NOTE: Writes a body without copying it where possible. Large
+    //       files are sent straight from fd with sendfile(2) when
+    //       flushing, contents has to be the same file mapped into
+    //       memory, pass -1 for bodies that are not files. Parts of
+    //       a file pass where in it they start as offset. Blocking
+    //       connections send large bodies right away, together with
+    //       the buffered head, in a single call.
+    ErrorOr<u32> write_body(StringView contents, int fd = -1,
+        u32 offset = 0);
     ErrorOr<u32> write(StringView message);
 
     template <typename... Args>
@@ -72,21 +143,19 @@ struct TCPConnection {
     ErrorOr<StringBuffer> printable_address() const;
 
 private:
-    constexpr TCPConnection(
-        sockaddr_storage address,
-        socklen_t address_size,
-        int socket,
-        StringBuffer&& write_buffer
-    )
+    constexpr TCPConnection(Address address, int socket,
+        Blocking blocking)
         : address(address)
-        , address_size(address_size)
         , socket(socket)
-        , write_buffer(move(write_buffer))
+        , blocking(blocking)
     {
     }
 
     void destroy() const;
 
+    ErrorOr<Progress> try_send_file() const;
+    void clear_written() const;
+
     bool is_valid() const { return socket != -1; }
     void invalidate() { socket = -1; }
 
@@ -1,6 +1,10 @@
 #include "TCPListener.h"
 #include <Core/Print.h>
 #include <Ty/System.h>
+#include <fcntl.h>
+#if __linux__
+#    include <linux/filter.h>
+#endif
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -8,7 +12,8 @@
 namespace Net {
 
 ErrorOr<TCPListener> TCPListener::create(u16 port,
-    u16 queued_connections, IPVersion ip_version)
+    u16 queued_connections, IPVersion ip_version,
+    ReusePort reuse_port)
 {
     auto port_buffer = TRY(StringBuffer::create_fill(port, "\0"sv));
 
@@ -23,6 +28,9 @@ ErrorOr<TCPListener> TCPListener::create(u16 port,
     int socket = TRY(System::socket(res->ai_family,
         res->ai_socktype, res->ai_protocol));
     TRY(System::setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, true));
+    if (reuse_port == ReusePort::Yes)
+        TRY(System::setsockopt(socket, SOL_SOCKET, SO_REUSEPORT,
+            true));
     TRY(System::bind(socket, res->ai_addr, res->ai_addrlen));
     TRY(System::listen(socket, queued_connections));
 
@@ -45,14 +53,82 @@ ErrorOr<void> TCPListener::close() const
 ErrorOr<TCPConnection> TCPListener::accept() const
 {
     sockaddr_storage address;
-    socklen_t address_size;
+    socklen_t address_size = sizeof(address);
     int client_socket = ::accept(m_socket,
         (struct sockaddr*)&address, &address_size);
     if (client_socket < 0) {
         return Error::from_errno();
     }
-    return TRY(TCPConnection::create(client_socket, address,
-        address_size));
+    return TRY(TCPConnection::create(client_socket,
+        Address::from(address)));
+}
+
+ErrorOr<Optional<TCPConnection>> TCPListener::try_accept() const
+{
+    sockaddr_storage address;
+    socklen_t address_size = sizeof(address);
+    int client_socket = -1;
+    while (client_socket < 0) {
+        client_socket = ::accept4(m_socket,
+            (struct sockaddr*)&address, &address_size,
+            SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket >= 0)
+            break;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return Optional<TCPConnection> {};
+        // NOTE: The peer went away before it was accepted.
+        if (errno == ECONNABORTED || errno == EPROTO
+            || errno == EINTR)
+            continue;
+        return Error::from_errno();
+    }
+    return Optional<TCPConnection>(TRY(TCPConnection::create(
+        client_socket, Address::from(address), Blocking::No)));
+}
+
+ErrorOr<void> TCPListener::set_nonblocking() const
+{
+    auto flags = TRY(System::fcntl(m_socket, F_GETFL));
+    TRY(System::fcntl(m_socket, F_SETFL, flags | O_NONBLOCK));
+    return {};
+}
+
+ErrorOr<void> TCPListener::steer_connections_by_cpu(
+    View<u32 const> worker_cpus) const
+{
+#if __linux__
+    // A = current CPU
+    // if A == worker_cpus[0] return 0
+    // if A == worker_cpus[1] return 1 ...
+    // return an index past the last listener
+    auto instruction_count = 2 * worker_cpus.size() + 2;
+    if (instruction_count > BPF_MAXINSNS)
+        return Error::from_string_literal(
+            "too many workers to steer");
+    auto code = TRY(
+        Vector<struct sock_filter>::create(instruction_count));
+    auto add = [&](u16 opcode, u8 if_true, u8 if_false, u32 k) {
+        code.unchecked_append(
+            sock_filter { opcode, if_true, if_false, k });
+    };
+    add(BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU);
+    for (u32 i = 0; i < worker_cpus.size(); i++) {
+        add(BPF_JMP | BPF_JEQ | BPF_K, 0, 1, worker_cpus[i]);
+        add(BPF_RET | BPF_K, 0, 0, i);
+    }
+    add(BPF_RET | BPF_K, 0, 0, 0xFFFFFFFF);
+
+    struct sock_fprog program = {
+        .len = (u16)code.size(),
+        .filter = code.data(),
+    };
+    TRY(System::setsockopt(m_socket, SOL_SOCKET,
+        SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)));
+    return {};
+#else
+    return Error::from_string_literal(
+        "connection steering is only supported on linux");
+#endif
 }
 
 }
@@ -2,17 +2,19 @@
 #include "TCPConnection.h"
 #include <Ty/Base.h>
 #include <Ty/ErrorOr.h>
+#include <Ty/View.h>
 
 namespace Net {
 
-enum class IPVersion {
-    V4,
-    V6
+enum class ReusePort : bool {
+    No = false,
+    Yes = true,
 };
 
 struct TCPListener {
     static ErrorOr<TCPListener> create(u16 port,
-        u16 queued_connections = 8, IPVersion = IPVersion::V4);
+        u16 queued_connections = 8, IPVersion = IPVersion::V4,
+        ReusePort = ReusePort::No);
     constexpr TCPListener(TCPListener&& other)
         : m_socket(other.m_socket)
         , m_port(other.m_port)
@@ -22,6 +24,7 @@ struct TCPListener {
     ~TCPListener();
 
     u16 port() const { return m_port; }
+    int socket() const { return m_socket; }
 
     ErrorOr<void> destroy()
     {
@@ -34,6 +37,21 @@ struct TCPListener {
 
     ErrorOr<TCPConnection> accept() const;
 
+    // NOTE: Only valid after set_nonblocking(), returns an empty
+    //       optional when there are no more pending connections.
+    //       Accepted connections are non-blocking as well. Errors
+    //       that only concern the one connection are skipped, the
+    //       rest are about running out of descriptors or memory.
+    ErrorOr<Optional<TCPConnection>> try_accept() const;
+    ErrorOr<void> set_nonblocking() const;
+
+    // NOTE: Attaches a reuseport program to this listener's group
+    //       which hands each new connection to the n'th listener
+    //       bound to the port, where worker_cpus[n] is the CPU that
+    //       received it. Connections on other CPUs are hashed.
+    ErrorOr<void> steer_connections_by_cpu(
+        View<u32 const> worker_cpus) const;
+
 private:
     constexpr TCPListener(int socket, u16 port)
         : m_socket(socket)
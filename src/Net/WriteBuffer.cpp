@@ -0,0 +1,37 @@
+#include "WriteBuffer.h"
+#include <Ty/Try.h>
+
+namespace Net {
+
+ErrorOr<u32> WriteBuffer::write(StringView data)
+{
+    TRY(reserve(data.size));
+    m_size += data.unchecked_copy_to(m_data + m_size);
+    return data.size;
+}
+
+void WriteBuffer::release()
+{
+    BufferPool::give_back(m_data);
+    m_data = nullptr;
+    m_size = 0;
+    m_capacity = 0;
+}
+
+ErrorOr<void> WriteBuffer::reserve(u32 size)
+{
+    if (m_capacity - m_size >= size)
+        return {};
+    auto capacity = m_capacity == 0 ? initial_capacity : m_capacity;
+    while (capacity - m_size < size)
+        capacity *= 2;
+    auto buffer = TRY(BufferPool::take(capacity));
+    if (m_size != 0)
+        __builtin_memcpy(buffer.data, m_data, m_size);
+    BufferPool::give_back(m_data);
+    m_data = buffer.data;
+    m_capacity = buffer.capacity;
+    return {};
+}
+
+}
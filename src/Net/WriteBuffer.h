@@ -0,0 +1,47 @@
+#pragma once
+#include "BufferPool.h"
+#include <Ty/Base.h>
+#include <Ty/ErrorOr.h>
+#include <Ty/StringView.h>
+
+namespace Net {
+
+// Bytes waiting to be sent. A buffer from the pool is only held
+// while there is something to send, release() gives it back once
+// it is flushed, so idle connections pay for the pointer alone.
+struct WriteBuffer {
+    static constexpr u32 initial_capacity = BufferPool::min_size;
+
+    constexpr WriteBuffer() = default;
+
+    constexpr WriteBuffer(WriteBuffer&& other)
+        : m_data(other.m_data)
+        , m_size(other.m_size)
+        , m_capacity(other.m_capacity)
+    {
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_capacity = 0;
+    }
+
+    WriteBuffer(WriteBuffer const&) = delete;
+    WriteBuffer& operator=(WriteBuffer const&) = delete;
+
+    ~WriteBuffer() { release(); }
+
+    ErrorOr<u32> write(StringView data);
+    void release();
+
+    StringView view() const { return { m_data, m_size }; }
+    u32 size() const { return m_size; }
+    u32 size_left() const { return m_capacity - m_size; }
+
+private:
+    ErrorOr<void> reserve(u32 size);
+
+    char* m_data { nullptr };
+    u32 m_size { 0 };
+    u32 m_capacity { 0 };
+};
+
+}
@@ -0,0 +1,507 @@
+#include <Core/File.h>
+#include <Ty/Deflate.h>
+#include <Ty/Vector.h>
+
+// Compresses inputs from empty to over a block and a window long,
+// and decodes them again with a small inflater of its own, which
+// takes nothing but complete codes of at most 15 bits. Skewed
+// enough input asks for longer codes than that, which the encoder
+// has to cut down to a code that is still complete.
+//
+// The gzip trailer has to hold the CRC-32 and size of the input.
+
+static constexpr u32 max_bits = 15;
+
+struct Huffman {
+    u16 counts[max_bits + 1];
+    u16 symbols[320];
+};
+
+struct Inflater {
+    StringView input;
+    Vector<char>& output;
+    u32 position { 0 };
+    u32 bit_buffer { 0 };
+    u32 bit_count { 0 };
+
+    // NOTE: The longest code the literal and length symbols of any
+    //       block would have had without the limit.
+    u32 longest_unlimited_code { 0 };
+
+    ErrorOr<u32> bits(u32 count)
+    {
+        while (bit_count < count) {
+            if (position == input.size)
+                return Error::from_string_literal(
+                    "stream cut short");
+            bit_buffer |= (u32)(u8)input[position++] << bit_count;
+            bit_count += 8;
+        }
+        auto value = bit_buffer & ((1U << count) - 1);
+        bit_buffer >>= count;
+        bit_count -= count;
+        return value;
+    }
+
+    ErrorOr<u32> decode(Huffman const& huffman)
+    {
+        i32 code = 0;
+        i32 first = 0;
+        i32 index = 0;
+        for (u32 length = 1; length <= max_bits; length++) {
+            code |= (i32)TRY(bits(1));
+            auto count = (i32)huffman.counts[length];
+            if (code - first < count)
+                return huffman.symbols[index + code - first];
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return Error::from_string_literal("invalid code");
+    }
+
+    ErrorOr<void> inflate();
+    ErrorOr<void> stored_block();
+    ErrorOr<void> dynamic_block();
+    ErrorOr<void> codes(Huffman const& litlen,
+        Huffman const& distance, bool is_dynamic);
+};
+
+// NOTE: Codes have to fill their tree, but for a lone distance
+//       code, which is how blocks without matches describe theirs.
+static ErrorOr<void> build(Huffman& huffman, u8 const* lengths,
+    u32 count)
+{
+    for (auto& length_count : huffman.counts)
+        length_count = 0;
+    for (u32 i = 0; i < count; i++)
+        huffman.counts[lengths[i]]++;
+    auto used = count - huffman.counts[0];
+
+    i32 left = 1;
+    for (u32 length = 1; length <= max_bits; length++) {
+        left <<= 1;
+        left -= huffman.counts[length];
+        if (left < 0)
+            return Error::from_string_literal(
+                "oversubscribed code");
+    }
+    if (left > 0 && used != 1)
+        return Error::from_string_literal("incomplete code");
+
+    u16 offsets[max_bits + 1];
+    offsets[1] = 0;
+    for (u32 length = 1; length < max_bits; length++) {
+        offsets[length + 1]
+            = offsets[length] + huffman.counts[length];
+    }
+    for (u32 i = 0; i < count; i++) {
+        if (lengths[i] != 0)
+            huffman.symbols[offsets[lengths[i]]++] = (u16)i;
+    }
+    return {};
+}
+
+// NOTE: Huffman's own lengths, built by merging the two lightest
+//       subtrees until one is left. Ties go to the shallower one,
+//       as they do in the encoder.
+static u32 longest_code(u32 const* frequencies, u32 count)
+{
+    u64 weights[288];
+    u32 depths[288];
+    u32 live = 0;
+    for (u32 i = 0; i < count; i++) {
+        if (frequencies[i] == 0)
+            continue;
+        weights[live] = frequencies[i];
+        depths[live] = 0;
+        live++;
+    }
+    auto is_lighter = [&](u32 a, u32 b) {
+        if (weights[a] != weights[b])
+            return weights[a] < weights[b];
+        return depths[a] < depths[b];
+    };
+    while (live > 1) {
+        u32 lightest = 0;
+        for (u32 i = 1; i < live; i++) {
+            if (is_lighter(i, lightest))
+                lightest = i;
+        }
+        auto weight = weights[lightest];
+        auto depth = depths[lightest];
+        weights[lightest] = weights[live - 1];
+        depths[lightest] = depths[live - 1];
+        live--;
+
+        u32 next = 0;
+        for (u32 i = 1; i < live; i++) {
+            if (is_lighter(i, next))
+                next = i;
+        }
+        weights[next] += weight;
+        depths[next] = (depths[next] > depth ? depths[next] : depth)
+            + 1;
+    }
+    return live == 1 ? depths[0] : 0;
+}
+
+ErrorOr<void> Inflater::inflate()
+{
+    auto is_final = false;
+    while (!is_final) {
+        is_final = TRY(bits(1)) == 1;
+        switch (TRY(bits(2))) {
+        case 0:
+            TRY(stored_block());
+            break;
+        case 1: {
+            // NOTE: The fixed distance code has two more codes than
+            //       there are distances, which fill it.
+            u8 lengths[288 + 32];
+            for (u32 i = 0; i < 288; i++) {
+                lengths[i] = i < 144 ? 8
+                    : i < 256        ? 9
+                    : i < 280        ? 7
+                                     : 8;
+            }
+            for (u32 i = 0; i < 32; i++)
+                lengths[288 + i] = 5;
+            Huffman litlen;
+            Huffman distance;
+            TRY(build(litlen, lengths, 288));
+            TRY(build(distance, lengths + 288, 32));
+            TRY(codes(litlen, distance, false));
+            break;
+        }
+        case 2:
+            TRY(dynamic_block());
+            break;
+        default:
+            return Error::from_string_literal("invalid block type");
+        }
+    }
+    return {};
+}
+
+ErrorOr<void> Inflater::stored_block()
+{
+    bit_buffer = 0;
+    bit_count = 0;
+    if (position + 4 > input.size)
+        return Error::from_string_literal("stream cut short");
+    auto length = (u32)(u8)input[position]
+        | (u32)(u8)input[position + 1] << 8;
+    auto complement = (u32)(u8)input[position + 2]
+        | (u32)(u8)input[position + 3] << 8;
+    position += 4;
+    if (length != (~complement & 0xFFFF))
+        return Error::from_string_literal("bad stored length");
+    if (position + length > input.size)
+        return Error::from_string_literal("stream cut short");
+    for (u32 i = 0; i < length; i++)
+        TRY(output.append(input[position + i]));
+    position += length;
+    return {};
+}
+
+ErrorOr<void> Inflater::dynamic_block()
+{
+    constexpr u8 order[19] = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5,
+        11, 4, 12, 3, 13, 2, 14, 1, 15,
+    };
+    auto litlen_count = TRY(bits(5)) + 257;
+    auto distance_count = TRY(bits(5)) + 1;
+    auto code_length_count = TRY(bits(4)) + 4;
+    if (litlen_count > 286 || distance_count > 30)
+        return Error::from_string_literal("too many codes");
+
+    u8 lengths[286 + 30] = {};
+    for (u32 i = 0; i < code_length_count; i++)
+        lengths[order[i]] = (u8)TRY(bits(3));
+    Huffman code_lengths;
+    TRY(build(code_lengths, lengths, 19));
+
+    auto total = litlen_count + distance_count;
+    for (u32 i = 0; i < total;) {
+        auto symbol = TRY(decode(code_lengths));
+        if (symbol < 16) {
+            lengths[i++] = (u8)symbol;
+            continue;
+        }
+        u8 length = 0;
+        u32 repeat = 0;
+        if (symbol == 16) {
+            if (i == 0)
+                return Error::from_string_literal(
+                    "nothing to repeat");
+            length = lengths[i - 1];
+            repeat = 3 + TRY(bits(2));
+        } else if (symbol == 17) {
+            repeat = 3 + TRY(bits(3));
+        } else {
+            repeat = 11 + TRY(bits(7));
+        }
+        if (i + repeat > total)
+            return Error::from_string_literal("too many lengths");
+        while (repeat-- != 0)
+            lengths[i++] = length;
+    }
+    if (lengths[256] == 0)
+        return Error::from_string_literal("no end of block code");
+
+    Huffman litlen;
+    Huffman distance;
+    TRY(build(litlen, lengths, litlen_count));
+    TRY(build(distance, lengths + litlen_count, distance_count));
+    TRY(codes(litlen, distance, true));
+    return {};
+}
+
+ErrorOr<void> Inflater::codes(Huffman const& litlen,
+    Huffman const& distance, bool is_dynamic)
+{
+    constexpr u16 length_base[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+    };
+    constexpr u8 length_extra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+        2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+    };
+    constexpr u16 distance_base[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+        8193, 12289, 16385, 24577,
+    };
+    constexpr u8 distance_extra[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+        6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+    };
+
+    u32 frequencies[286] = {};
+    while (true) {
+        auto symbol = TRY(decode(litlen));
+        if (symbol < 286)
+            frequencies[symbol]++;
+        if (symbol < 256) {
+            TRY(output.append((char)symbol));
+            continue;
+        }
+        if (symbol == 256)
+            break;
+        symbol -= 257;
+        if (symbol >= 29)
+            return Error::from_string_literal("invalid length");
+        auto length = length_base[symbol]
+            + TRY(bits(length_extra[symbol]));
+        auto distance_symbol = TRY(decode(distance));
+        if (distance_symbol >= 30)
+            return Error::from_string_literal("invalid distance");
+        auto match_distance = distance_base[distance_symbol]
+            + TRY(bits(distance_extra[distance_symbol]));
+        if (match_distance > output.size())
+            return Error::from_string_literal("distance too far");
+        for (u32 i = 0; i < length; i++) {
+            TRY(output.append(
+                output[output.size() - match_distance]));
+        }
+    }
+
+    if (is_dynamic) {
+        auto longest = longest_code(frequencies, 286);
+        if (longest > longest_unlimited_code)
+            longest_unlimited_code = longest;
+    }
+    return {};
+}
+
+static u32 read_u32(StringView bytes, u32 at)
+{
+    u32 value = 0;
+    for (u32 i = 0; i < 4; i++)
+        value |= (u32)(u8)bytes[at + i] << (8 * i);
+    return value;
+}
+
+static ErrorOr<void> expect_same(StringView decoded,
+    StringView input)
+{
+    if (decoded.size != input.size)
+        return Error::from_string_literal("size differs");
+    for (u32 i = 0; i < input.size; i++) {
+        if (decoded[i] != input[i])
+            return Error::from_string_literal("contents differ");
+    }
+    return {};
+}
+
+// NOTE: Returns the longest code the input would have needed.
+static ErrorOr<u32> round_trip(StringView input)
+{
+    auto compressed = TRY(Ty::Deflate::compress(input));
+    auto raw = StringView(compressed.data(), compressed.size());
+    auto raw_output = TRY(Vector<char>::create(input.size + 1));
+    auto raw_inflater = Inflater { raw, raw_output };
+    TRY(raw_inflater.inflate());
+    TRY(expect_same({ raw_output.data(), raw_output.size() },
+        input));
+
+    auto gzipped = TRY(Ty::Deflate::gzip(input));
+    auto member = StringView(gzipped.data(), gzipped.size());
+    if (member.size < 18 || (u8)member[0] != 0x1F
+        || (u8)member[1] != 0x8B || member[2] != 8
+        || member[3] != 0)
+        return Error::from_string_literal("bad gzip header");
+    auto output = TRY(Vector<char>::create(input.size + 1));
+    auto inflater = Inflater {
+        member.shrink_from_start(10).shrink(8),
+        output,
+    };
+    TRY(inflater.inflate());
+    TRY(expect_same({ output.data(), output.size() }, input));
+    auto trailer = member.size - 8;
+    if (read_u32(member, trailer) != Ty::Deflate::crc32(input))
+        return Error::from_string_literal("bad gzip CRC-32");
+    if (read_u32(member, trailer + 4) != input.size)
+        return Error::from_string_literal("bad gzip size");
+    return inflater.longest_unlimited_code;
+}
+
+static ErrorOr<void> test_crc32()
+{
+    // NOTE: The check value of CRC-32 as gzip uses it.
+    if (Ty::Deflate::crc32("123456789"sv) != 0xCBF43926)
+        return Error::from_string_literal("wrong CRC-32");
+    if (Ty::Deflate::crc32(""sv) != 0)
+        return Error::from_string_literal("wrong empty CRC-32");
+    auto whole = Ty::Deflate::crc32("hello world"sv);
+    auto split = Ty::Deflate::crc32(" world"sv,
+        Ty::Deflate::crc32("hello"sv));
+    if (whole != split)
+        return Error::from_string_literal("CRC-32 does not chain");
+    return {};
+}
+
+static ErrorOr<void> test()
+{
+    TRY(test_crc32());
+    TRY(round_trip(""sv));
+    TRY(round_trip("x"sv));
+    TRY(round_trip("hello hello hello hello"sv));
+
+    u32 state = 2463534242;
+    auto next = [&] {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+
+    // NOTE: Past a window, a stored block and many blocks of
+    //       symbols, with matches as long and as far as they go.
+    constexpr u32 size = 300 * 1024;
+    static_assert(size > 256 * 256);
+    auto input = TRY(Vector<char>::create(size));
+    for (u32 i = 0; i < size; i++)
+        input.unchecked_append("abcab"[i % 5]);
+    TRY(round_trip({ input.data(), input.size() }));
+
+    input.clear();
+    for (u32 i = 0; i < size; i++)
+        input.unchecked_append((char)next());
+    TRY(round_trip({ input.data(), input.size() }));
+
+    // NOTE: Words from a small vocabulary, like text.
+    StringView const words[] = {
+        "the "sv, "quick "sv, "brown "sv, "fox "sv, "jumps "sv,
+        "over "sv, "lazy "sv, "dog. "sv, "\n"sv, "a "sv,
+    };
+    input.clear();
+    while (input.size() + 8 < size) {
+        auto word = words[next() % 10];
+        for (u32 i = 0; i < word.size; i++)
+            input.unchecked_append(word[i]);
+    }
+    TRY(round_trip({ input.data(), input.size() }));
+
+    // NOTE: A block of literals alone, in which no pair of bytes
+    //       comes twice, then a block of matches alone, copied
+    //       out of it. Each copy starts with a pair of bytes that
+    //       never came before, so none can be matched any longer.
+    //       Their lengths are as rare as the Fibonacci numbers, to
+    //       make for the deepest tree, with codes of 18 bits.
+    static bool seen_pairs[256][256];
+    auto append = [&](char byte) {
+        if (!input.is_empty())
+            seen_pairs[(u8)input.last()][(u8)byte] = true;
+        input.unchecked_append(byte);
+    };
+    auto is_new_pair = [&](char byte) {
+        return !seen_pairs[(u8)input.last()][(u8)byte];
+    };
+    // NOTE: The encoder ends its blocks at this many symbols.
+    constexpr u32 block_symbols = 16 * 1024 - 1;
+    input.clear();
+    input.unchecked_append(0);
+    while (input.size() < block_symbols) {
+        auto byte = (char)next();
+        if (is_new_pair(byte))
+            append(byte);
+    }
+
+    // NOTE: The shortest length of each length code, from the
+    //       most common to the rarest.
+    constexpr u8 lengths[] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43,
+    };
+    constexpr u32 length_count = sizeof(lengths);
+    u32 copy_counts[length_count];
+    u32 copy_count = 0;
+    for (u32 i = length_count; i-- > 0;) {
+        copy_counts[i] = i + 2 >= length_count
+            ? length_count - i
+            : copy_counts[i + 1] + copy_counts[i + 2];
+        copy_count += copy_counts[i];
+    }
+    auto copies = TRY(Vector<u8>::create(copy_count));
+    for (u32 i = 0; i < length_count; i++) {
+        for (u32 j = 0; j < copy_counts[i]; j++)
+            copies.unchecked_append(lengths[i]);
+    }
+    for (u32 i = copy_count - 1; i > 0; i--) {
+        auto other = next() % (i + 1);
+        auto length = copies[i];
+        copies[i] = copies[other];
+        copies[other] = length;
+    }
+
+    for (auto length : copies) {
+        auto window = input.size() < 32 * 1024 ? input.size()
+                                                : 32 * 1024;
+        u32 source = 0;
+        do {
+            source = input.size() - window
+                + next() % (window - length);
+        } while (!is_new_pair(input[source]));
+        for (u32 i = 0; i < length; i++)
+            append(input[source + i]);
+    }
+    auto longest = TRY(round_trip({ input.data(), input.size() }));
+    if (longest <= max_bits)
+        return Error::from_string_literal("codes were never cut");
+    return {};
+}
+
+int main()
+{
+    auto& out = Core::File::stderr();
+    if (auto result = test(); result.is_error()) {
+        out.writeln("FAIL: "sv, result.error()).ignore();
+        return 1;
+    }
+    out.writeln("PASS"sv).ignore();
+    return 0;
+}
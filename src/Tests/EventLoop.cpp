@@ -0,0 +1,242 @@
+#include <Core/File.h>
+#include <Core/Thread.h>
+#include <Mem/AddressSpace.h>
+#include <Net/EventLoop.h>
+#include <Net/TCPListener.h>
+#include <Ty/System.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// A client that keeps sending while its response is still being
+// sent, until its request buffer overflows. The failed receive
+// closes the client, which must not happen while the kernel is
+// still sending from its write buffer: the buffer would go back to
+// the pool under the send, and the next response written into it
+// would go out on this socket.
+//
+// Another client is answered before the first reads its response,
+// and every byte the first gets has to be the one at its place.
+//
+// Clients sending a head or a body too large have to be told so
+// before they are closed on.
+
+// NOTE: Small enough for the pool, too large for the socket.
+static constexpr u32 body_size = 60 * 1024;
+static constexpr u32 flood_size = 128 * 1024;
+static char s_bodies[2][body_size];
+
+static char body_byte(u32 body, u32 index)
+{
+    return (char)(((index + body) * 2654435761U) >> 13);
+}
+
+static ErrorOr<void> run_server(Net::TCPListener const* listener,
+    Net::Backend backend)
+{
+    auto event_loop = TRY(Net::EventLoop::create(*listener,
+        Core::File::stderr(),
+        [](auto& client, auto const& request,
+            auto) -> ErrorOr<Net::KeepAlive> {
+            auto body = request.slug == "/second"sv ? 1 : 0;
+            TRY(client.write("HTTP/1.1 200 OK\r\n"sv,
+                "Content-Length: "sv, body_size, "\r\n\r\n"sv));
+            TRY(client.write_body(
+                StringView(s_bodies[body], body_size)));
+            return body == 1 ? Net::KeepAlive::No
+                             : Net::KeepAlive::Yes;
+        },
+        backend));
+    TRY(event_loop.run());
+    return {};
+}
+
+static ErrorOr<u16> port_of(Net::TCPListener const& listener)
+{
+    sockaddr_in address {};
+    socklen_t address_size = sizeof(address);
+    if (getsockname(listener.socket(), (sockaddr*)&address,
+            &address_size)
+        < 0)
+        return Error::from_errno();
+    return ntohs(address.sin_port);
+}
+
+static ErrorOr<int> connect_to(u16 port, int receive_buffer)
+{
+    auto socket = TRY(System::socket(AF_INET, SOCK_STREAM, 0));
+    if (receive_buffer != 0) {
+        TRY(System::setsockopt(socket, SOL_SOCKET, SO_RCVBUF,
+            receive_buffer));
+    }
+    auto timeout = timeval { .tv_sec = 5, .tv_usec = 0 };
+    TRY(System::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO,
+        &timeout, sizeof(timeout)));
+    TRY(System::setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO,
+        &timeout, sizeof(timeout)));
+    auto address = sockaddr_in {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr = { .s_addr = htonl(INADDR_LOOPBACK) },
+    };
+    TRY(System::connect(socket, (sockaddr*)&address,
+        sizeof(address)));
+    return socket;
+}
+
+// NOTE: Bytes after the body have to start like after, as far as
+//       they made it before the reset.
+static ErrorOr<void> check_response(int socket, u32 body,
+    StringView after = ""sv)
+{
+    char buffer[64 * 1024];
+    u32 head_left = 0;
+    u32 body_index = 0;
+    bool in_body = false;
+    while (true) {
+        auto size = ::recv(socket, buffer, sizeof(buffer), 0);
+        // NOTE: Closing with the flood unread resets the socket.
+        if (size < 0 && errno == ECONNRESET)
+            break;
+        if (size < 0)
+            return Error::from_errno();
+        if (size == 0)
+            break;
+        for (u32 i = 0; i < (u32)size; i++) {
+            if (!in_body) {
+                head_left = buffer[i] == "\r\n\r\n"[head_left]
+                    ? head_left + 1
+                    : (buffer[i] == '\r' ? 1 : 0);
+                in_body = head_left == 4;
+                continue;
+            }
+            if (body_index >= body_size) {
+                auto at = body_index++ - body_size;
+                if (at < after.size && buffer[i] != after[at])
+                    return Error::from_string_literal(
+                        "bytes after the response out of place");
+                if (after.is_empty())
+                    return Error::from_string_literal(
+                        "more bytes than the response");
+                continue;
+            }
+            if (buffer[i] != body_byte(body, body_index++))
+                return Error::from_string_literal(
+                    "response bytes out of place");
+        }
+    }
+    if (!in_body)
+        return Error::from_string_literal("no response head");
+    if (body_index > body_size)
+        body_index = body_size;
+    Core::File::stderr()
+        .writeln("  got "sv, body_index, " body bytes in place"sv)
+        .ignore();
+    return {};
+}
+
+static ErrorOr<void> check_rejected(u16 port, StringView head,
+    StringView status_line)
+{
+    auto socket = TRY(connect_to(port, 0));
+    TRY(System::send(socket, head));
+    char filler[70 * 1024];
+    for (u32 i = 0; i < sizeof(filler); i++)
+        filler[i] = 'A';
+    // NOTE: The server stops reading once its buffer is full.
+    ::send(socket, filler, sizeof(filler), MSG_NOSIGNAL);
+
+    char buffer[1024];
+    u32 size = 0;
+    while (size < sizeof(buffer)) {
+        auto received = ::recv(socket, buffer + size,
+            sizeof(buffer) - size, 0);
+        if (received <= 0)
+            break;
+        size += (u32)received;
+    }
+    System::close(socket).ignore();
+    if (!StringView(buffer, size).starts_with(status_line))
+        return Error::from_string_literal("request not rejected");
+    return {};
+}
+
+static ErrorOr<void> test(Net::TCPListener const& listener,
+    Net::Backend backend)
+{
+    auto port = TRY(port_of(listener));
+    // NOTE: Accepted sockets inherit it, so the response does not
+    //       fit in the kernel's buffers and the send stays pending.
+    TRY(System::setsockopt(listener.socket(), SOL_SOCKET, SO_SNDBUF,
+        4096));
+    auto thread = TRY(Core::Thread::spawn([&listener, backend] {
+        run_server(&listener, backend).or_else([](auto error) {
+            Core::File::stderr()
+                .writeln("Server: "sv, error)
+                .ignore();
+        });
+    }));
+    TRY(thread.detach());
+
+    auto first = TRY(connect_to(port, 1024));
+    TRY(System::send(first,
+        "GET /first HTTP/1.1\r\nHost: localhost\r\n\r\n"sv));
+    // NOTE: Gives the server time to fill the socket and be left
+    //       waiting on the send.
+    System::sleep(1);
+
+    char flood[flood_size];
+    for (u32 i = 0; i < flood_size; i++)
+        flood[i] = 'A';
+    // NOTE: The server may close before all of it is through.
+    ::send(first, flood, sizeof(flood), MSG_NOSIGNAL);
+    System::sleep(1);
+
+    auto second = TRY(connect_to(port, 0));
+    TRY(System::send(second,
+        "GET /second HTTP/1.1\r\nHost: localhost\r\n\r\n"sv));
+    TRY(check_response(second, 1));
+    System::close(second).ignore();
+
+    // NOTE: The flood never ends a head, so it is rejected.
+    TRY(check_response(first, 0, "HTTP/1.1 431 "sv));
+    System::close(first).ignore();
+
+    TRY(check_rejected(port, "GET / HTTP/1.1\r\nX-Filler: "sv,
+        "HTTP/1.1 431 "sv));
+    TRY(check_rejected(port,
+        "POST / HTTP/1.1\r\nContent-Length: 100000\r\n\r\n"sv,
+        "HTTP/1.1 413 "sv));
+    return {};
+}
+
+int main()
+{
+    MUST(Mem::LoRam::init());
+    for (u32 i = 0; i < body_size; i++) {
+        s_bodies[0][i] = body_byte(0, i);
+        s_bodies[1][i] = body_byte(1, i);
+    }
+
+    // NOTE: The server threads run until exit, so the listeners
+    //       have to outlive the tests.
+    auto& out = Core::File::stderr();
+    auto io_uring_listener = MUST(Net::TCPListener::create(0));
+    auto epoll_listener = MUST(Net::TCPListener::create(0));
+    struct Case {
+        Net::TCPListener const& listener;
+        Net::Backend backend;
+    };
+    Case const cases[] = {
+        { io_uring_listener, Net::Backend::IOURing },
+        { epoll_listener, Net::Backend::Epoll },
+    };
+    for (auto const& test_case : cases) {
+        auto result = test(test_case.listener, test_case.backend);
+        if (result.is_error()) {
+            out.writeln("FAIL: "sv, result.error()).ignore();
+            return 1;
+        }
+    }
+    out.writeln("PASS"sv).ignore();
+    return 0;
+}
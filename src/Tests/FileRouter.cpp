@@ -0,0 +1,196 @@
+#include <Core/File.h>
+#include <Ty/StringBuffer.h>
+#include <Ty/System.h>
+#include <Web/FileRouter.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A routed folder whose directories are removed or moved out of it
+// while it is watched. Their files have to stop being found, and
+// leave the router, while the rest are still found at their routes.
+// Directories made again in their place are picked up like new.
+// Changed files are mapped again by the time the changes have been
+// picked up, finding them only looks them up.
+
+static ErrorOr<void> make_directory(StringView root,
+    StringView name)
+{
+    auto path = TRY(StringBuffer::create_fill(root, name, "\0"sv));
+    if (::mkdir(path.data(), 0700) < 0)
+        return Error::from_errno();
+    return {};
+}
+
+static ErrorOr<void> remove_directory(StringView root,
+    StringView name)
+{
+    auto path = TRY(StringBuffer::create_fill(root, name, "\0"sv));
+    if (::rmdir(path.data()) < 0)
+        return Error::from_errno();
+    return {};
+}
+
+static ErrorOr<void> write_file(StringView root, StringView name,
+    StringView contents)
+{
+    auto path = TRY(StringBuffer::create_fill(root, name, "\0"sv));
+    auto fd = TRY(System::open(path.data(),
+        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600));
+    auto size = ::write(fd, contents.data, contents.size);
+    System::close(fd).ignore();
+    if (size != contents.size)
+        return Error::from_string_literal("could not write file");
+    return {};
+}
+
+static ErrorOr<void> make_file(StringView root, StringView name)
+{
+    TRY(write_file(root, name, name));
+    return {};
+}
+
+static ErrorOr<void> remove_file(StringView root, StringView name)
+{
+    auto path = TRY(StringBuffer::create_fill(root, name, "\0"sv));
+    TRY(System::unlink(path.data()));
+    return {};
+}
+
+static ErrorOr<void> expect_found(Web::FileRouter& router,
+    StringView route)
+{
+    auto id = router.find(route);
+    if (!id.has_value())
+        return Error::from_string_literal("file not found");
+    // NOTE: Ids move when files are removed, the routes have to
+    //       move with them.
+    if (!router[id.value()].path().ends_with(route))
+        return Error::from_string_literal("route leads elsewhere");
+    return {};
+}
+
+static ErrorOr<void> expect_not_found(Web::FileRouter& router,
+    StringView route)
+{
+    if (router.find(route).has_value())
+        return Error::from_string_literal("removed file found");
+    return {};
+}
+
+static ErrorOr<void> expect_file_count(Web::FileRouter& router,
+    u32 count)
+{
+    if (router.file_count() != count)
+        return Error::from_string_literal("removed files kept");
+    return {};
+}
+
+static ErrorOr<void> test(StringView root, StringView outside)
+{
+    auto& log = Core::File::stderr();
+    StringView const directories[] = {
+        "/sub"sv,
+        "/sub/deep"sv,
+        "/other"sv,
+        "/moved"sv,
+        "/last"sv,
+    };
+    for (auto directory : directories)
+        TRY(make_directory(root, directory));
+    StringView const files[] = {
+        "/keep.txt"sv,
+        "/sub/a.txt"sv,
+        "/sub/404.html"sv,
+        "/sub/deep/b.txt"sv,
+        "/other/c.txt"sv,
+        "/moved/d.txt"sv,
+        "/last/e.txt"sv,
+    };
+    for (auto file : files)
+        TRY(make_file(root, file));
+
+    auto router = TRY(Web::FileRouter::create());
+    TRY(router.add_folder(root));
+    auto not_found_page
+        = TRY(StringBuffer::create_fill(root, "/sub/404.html"sv));
+    TRY(router.set_not_found_page(not_found_page.view()));
+    for (auto file : files)
+        TRY(expect_found(router, file));
+    TRY(expect_file_count(router, 7));
+
+    TRY(remove_file(root, "/sub/deep/b.txt"sv));
+    TRY(remove_directory(root, "/sub/deep"sv));
+    TRY(remove_file(root, "/sub/a.txt"sv));
+    TRY(remove_file(root, "/sub/404.html"sv));
+    TRY(remove_directory(root, "/sub"sv));
+    TRY(router.reload_files_if_needed(log));
+    TRY(expect_not_found(router, "/sub/a.txt"sv));
+    TRY(expect_not_found(router, "/sub/deep/b.txt"sv));
+    // NOTE: The page is routed on its own, so it only goes away
+    //       until it is back.
+    if (router.not_found_page().has_value())
+        return Error::from_string_literal("removed page found");
+    TRY(expect_file_count(router, 5));
+
+    auto moved = TRY(StringBuffer::create_fill(root, "/moved\0"sv));
+    auto moved_out
+        = TRY(StringBuffer::create_fill(outside, "/moved\0"sv));
+    if (::rename(moved.data(), moved_out.data()) < 0)
+        return Error::from_errno();
+    TRY(router.reload_files_if_needed(log));
+    TRY(expect_not_found(router, "/moved/d.txt"sv));
+    TRY(expect_file_count(router, 4));
+    // NOTE: The moved directory is not watched any more.
+    TRY(make_file(outside, "/moved/new.txt"sv));
+    TRY(router.reload_files_if_needed(log));
+    TRY(expect_file_count(router, 4));
+
+    TRY(expect_found(router, "/keep.txt"sv));
+    TRY(expect_found(router, "/other/c.txt"sv));
+    TRY(expect_found(router, "/last/e.txt"sv));
+
+    TRY(write_file(root, "/keep.txt"sv, "changed"sv));
+    TRY(router.reload_files_if_needed(log));
+    auto id = router.find("/keep.txt"sv);
+    if (!id.has_value() || router[id.value()].view() != "changed"sv)
+        return Error::from_string_literal("change not picked up");
+
+    TRY(make_directory(root, "/sub"sv));
+    TRY(make_file(root, "/sub/a.txt"sv));
+    TRY(make_file(root, "/sub/404.html"sv));
+    TRY(router.reload_files_if_needed(log));
+    TRY(expect_found(router, "/sub/a.txt"sv));
+    if (!router.not_found_page().has_value())
+        return Error::from_string_literal("page not found again");
+    TRY(expect_file_count(router, 5));
+    return {};
+}
+
+int main()
+{
+    auto& out = Core::File::stderr();
+    char root[] = "/tmp/test-file-router-XXXXXX";
+    char outside[] = "/tmp/test-file-router-XXXXXX";
+    if (::mkdtemp(root) == nullptr
+        || ::mkdtemp(outside) == nullptr) {
+        out.writeln("FAIL: "sv, Error::from_errno()).ignore();
+        return 1;
+    }
+    auto result = test(StringView::from_c_string(root),
+        StringView::from_c_string(outside));
+
+    auto command = MUST(StringBuffer::create_fill("rm -rf "sv,
+        StringView::from_c_string(root), " "sv,
+        StringView::from_c_string(outside), "\0"sv));
+    (void)::system(command.data());
+
+    if (result.is_error()) {
+        out.writeln("FAIL: "sv, result.error()).ignore();
+        return 1;
+    }
+    out.writeln("PASS"sv).ignore();
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <Core/File.h>
+#include <Ty/StringSearch.h>
+
+// Every implementation the CPU runs has to find what the scalar one
+// finds. Buffers are random bytes out of a small alphabet, so most
+// searches hit somewhere, at every size up to a few blocks, which
+// leaves tails of every size after the last full block. Sequences
+// are searched for at every offset, so some straddle two blocks.
+
+using namespace Ty::StringSearch;
+
+static constexpr u32 max_size = 200;
+
+static u32 state = 2463534242;
+
+static u32 next()
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static void fill(char* data, u32 size, u32 alphabet)
+{
+    for (u32 i = 0; i < size; i++)
+        data[i] = (char)('a' + next() % alphabet);
+}
+
+static ErrorOr<void> test_find_byte(Functions const& tested,
+    Functions const& scalar, char const* data, u32 size)
+{
+    for (u32 byte = 'a'; byte <= 'z'; byte++) {
+        auto expected = scalar.find_byte(data, size, (char)byte);
+        if (tested.find_byte(data, size, (char)byte) != expected)
+            return Error::from_string_literal("find_byte differs");
+    }
+    return {};
+}
+
+static ErrorOr<void> test_find_any_byte(Functions const& tested,
+    Functions const& scalar, char const* data, u32 size)
+{
+    char set[20];
+    for (u32 set_size = 0; set_size <= sizeof(set); set_size++) {
+        fill(set, set_size, 26);
+        auto expected
+            = scalar.find_any_byte(data, size, set, set_size);
+        if (tested.find_any_byte(data, size, set, set_size)
+            != expected)
+            return Error::from_string_literal(
+                "find_any_byte differs");
+    }
+    return {};
+}
+
+static ErrorOr<void> test_find_sequence(Functions const& tested,
+    Functions const& scalar, char const* data, u32 size)
+{
+    // NOTE: Taken out of the buffer at every offset, so each is
+    //       found, mostly where it was taken from.
+    u32 const sequence_sizes[] = { 1, 2, 3, 7, 16, 17, 33 };
+    for (auto sequence_size : sequence_sizes) {
+        for (u32 at = 0; at + sequence_size <= size; at++) {
+            auto* sequence = data + at;
+            auto expected = scalar.find_sequence(data, size,
+                sequence, sequence_size);
+            if (expected > at)
+                return Error::from_string_literal(
+                    "scalar find_sequence missed");
+            if (tested.find_sequence(data, size, sequence,
+                    sequence_size)
+                != expected)
+                return Error::from_string_literal(
+                    "find_sequence differs");
+        }
+    }
+
+    // NOTE: Sequences that are not there, some longer than the
+    //       buffer, and some with the right first and last byte.
+    char sequence[max_size + 2];
+    for (u32 sequence_size = 0; sequence_size <= size + 1;
+         sequence_size++) {
+        fill(sequence, sequence_size, 3);
+        if (sequence_size > 2)
+            sequence[sequence_size / 2] = 'z';
+        auto expected = scalar.find_sequence(data, size, sequence,
+            sequence_size);
+        if (tested.find_sequence(data, size, sequence,
+                sequence_size)
+            != expected)
+            return Error::from_string_literal(
+                "find_sequence differs on a miss");
+    }
+    return {};
+}
+
+static ErrorOr<void> test_equals(Functions const& tested,
+    char const* data, u32 size)
+{
+    char copy[max_size];
+    for (u32 i = 0; i < size; i++)
+        copy[i] = data[i];
+    if (!tested.equals(data, copy, size))
+        return Error::from_string_literal("equal bytes differ");
+    // NOTE: One byte off, in a full block and in the tail.
+    for (u32 i = 0; i < size; i++) {
+        copy[i] ^= 1;
+        if (tested.equals(data, copy, size))
+            return Error::from_string_literal(
+                "changed byte missed");
+        copy[i] ^= 1;
+    }
+    return {};
+}
+
+static ErrorOr<void> test(Functions const& tested)
+{
+    auto scalar = functions_for(Implementation::Scalar).value();
+    // NOTE: Buffers start at every offset of a block, the loads
+    //       are unaligned.
+    char buffer[max_size + 32];
+    for (u32 size = 0; size <= max_size; size++) {
+        auto* data = buffer + size % 32;
+        // NOTE: Two letters hit in nearly every block, 26 leave
+        //       blocks without a hit.
+        u32 const alphabets[] = { 2, 26 };
+        for (auto alphabet : alphabets) {
+            fill(data, size, alphabet);
+            TRY(test_find_byte(tested, scalar, data, size));
+            TRY(test_find_any_byte(tested, scalar, data, size));
+            TRY(test_find_sequence(tested, scalar, data, size));
+            TRY(test_equals(tested, data, size));
+        }
+    }
+
+    // NOTE: A byte only in the tail after the last full block.
+    u32 const tails[] = { 15, 16, 31, 32, 33 };
+    for (auto tail : tails) {
+        auto size = 64 + tail;
+        fill(buffer, size, 2);
+        buffer[size - 1] = 'z';
+        if (tested.find_byte(buffer, size, 'z') != size - 1)
+            return Error::from_string_literal("tail byte missed");
+        if (tested.find_any_byte(buffer, size, "xyz", 3)
+            != size - 1)
+            return Error::from_string_literal("tail byte missed");
+        if (tested.find_sequence(buffer, size, buffer + size - 2, 2)
+            != scalar.find_sequence(buffer, size,
+                buffer + size - 2, 2))
+            return Error::from_string_literal(
+                "tail sequence missed");
+    }
+    return {};
+}
+
+int main()
+{
+    auto& out = Core::File::stderr();
+    Implementation const implementations[] = {
+        Implementation::Scalar,
+        Implementation::SSE2,
+        Implementation::AVX2,
+    };
+    StringView const names[] = { "scalar"sv, "SSE2"sv, "AVX2"sv };
+    for (u32 i = 0; i < 3; i++) {
+        auto tested = functions_for(implementations[i]);
+        if (!tested.has_value()) {
+            out.writeln("SKIP: "sv, names[i]).ignore();
+            continue;
+        }
+        if (auto result = test(tested.value());
+            result.is_error()) {
+            out.writeln("FAIL: "sv, names[i], ": "sv,
+                result.error())
+                .ignore();
+            return 1;
+        }
+    }
+    out.writeln("PASS"sv).ignore();
+    return 0;
+}
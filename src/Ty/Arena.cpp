@@ -0,0 +1,36 @@
+#include "Arena.h"
+#include "Memory.h"
+#include "Try.h"
+
+namespace Ty {
+
+ErrorOr<Arena> Arena::create(usize capacity)
+{
+    auto* base = (u8*)TRY(allocate_memory(capacity));
+    return Arena(base, capacity, true);
+}
+
+Arena::~Arena()
+{
+    if (m_base != nullptr && m_is_owned)
+        free_memory(m_base);
+    m_base = nullptr;
+}
+
+ErrorOr<void*> Arena::reallocate(void* ptr, usize old_size,
+    usize size)
+{
+    auto* start = (u8*)ptr;
+    if (start + old_size == &m_base[m_used]) {
+        auto offset = (usize)(start - m_base);
+        if (offset + size > m_capacity)
+            return Error::from_string_literal("arena exhausted");
+        m_used = offset + size;
+        return ptr;
+    }
+    auto* moved = TRY(allocate(size));
+    __builtin_memcpy(moved, ptr, old_size < size ? old_size : size);
+    return moved;
+}
+
+}
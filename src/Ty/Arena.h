@@ -0,0 +1,83 @@
+#pragma once
+#include "Base.h"
+#include "ErrorOr.h"
+
+namespace Ty {
+
+// Memory handed out by bumping a cursor, and taken back all at
+// once by reset(). Containers created against an arena never free
+// what they grow into, so it has to outlive them, and nothing may
+// point into it past the next reset().
+struct Arena {
+    static ErrorOr<Arena> create(usize capacity);
+
+    // NOTE: Over memory the arena does not own, such as a region of
+    //       a Mem::AddressSpace.
+    static Arena create_in(void* base, usize capacity)
+    {
+        return Arena((u8*)base, capacity, false);
+    }
+
+    Arena(Arena&& other)
+        : m_base(other.m_base)
+        , m_capacity(other.m_capacity)
+        , m_used(other.m_used)
+        , m_high_water(other.m_high_water)
+        , m_is_owned(other.m_is_owned)
+    {
+        other.m_base = nullptr;
+    }
+
+    Arena(Arena const&) = delete;
+    Arena& operator=(Arena const&) = delete;
+
+    ~Arena();
+
+    ErrorOr<void*> allocate(usize size, usize alignment = 16)
+    {
+        auto start = (m_used + alignment - 1) & ~(alignment - 1);
+        if (start + size > m_capacity)
+            return Error::from_string_literal("arena exhausted");
+        m_used = start + size;
+        return &m_base[start];
+    }
+
+    // NOTE: Grows in place when ptr is the latest allocation, which
+    //       is what a single growing buffer always is.
+    ErrorOr<void*> reallocate(void* ptr, usize old_size,
+        usize size);
+
+    void reset()
+    {
+        if (m_used > m_high_water)
+            m_high_water = m_used;
+        m_used = 0;
+    }
+
+    usize used() const { return m_used; }
+    usize capacity() const { return m_capacity; }
+
+    // NOTE: The most used between two resets so far, for sizing.
+    usize high_water() const
+    {
+        return m_used > m_high_water ? m_used : m_high_water;
+    }
+
+private:
+    Arena(u8* base, usize capacity, bool is_owned)
+        : m_base(base)
+        , m_capacity(capacity)
+        , m_is_owned(is_owned)
+    {
+    }
+
+    u8* m_base { nullptr };
+    usize m_capacity { 0 };
+    usize m_used { 0 };
+    usize m_high_water { 0 };
+    bool m_is_owned { false };
+};
+
+}
+
+using Ty::Arena; // NOLINT
@@ -0,0 +1,404 @@
+#pragma once
+#include "Base.h"
+#include "Lock.h"
+#include "System.h"
+
+namespace Ty {
+
+// Blocks of a few fixed sizes, carved out of spans in a single
+// reserved range, one size class per span. Blocks are told apart
+// from other memory by their address, and their class is looked up
+// by span, so they need no header. Spans are never given back.
+//
+// Every thread keeps a free list per class, and only goes to the
+// central lists, a batch at a time, when one runs empty or grows
+// past two batches.
+//
+// Config lays the heap out, with span_size, reserve_size,
+// commit_size and class_count, class_size() and batch_size() for
+// each class, and commit() to make reserved pages usable. All
+// state is static, so there is one heap per Config.
+template <typename Config>
+struct BlockHeap {
+    struct Counters {
+        u64 allocations { 0 };
+        u64 frees { 0 };
+
+        // NOTE: Blocks handed out, at the size of their class.
+        u64 bytes_in_use { 0 };
+
+        // NOTE: Free blocks kept by threads, stats() adds the ones
+        //       in the central lists.
+        u64 cached_bytes { 0 };
+
+        // NOTE: Left to the user, for what it serves some other
+        //       way.
+        u64 overflow { 0 };
+    };
+
+    struct Stats {
+        Counters counters;
+
+        // NOTE: The high-water mark as well, spans stay taken.
+        u64 span_bytes;
+    };
+
+    static bool contains(void const* ptr)
+    {
+        auto base
+            = __atomic_load_n(&s_spans.base, __ATOMIC_ACQUIRE);
+        return base != 0 && (uptr)ptr - base < Config::reserve_size;
+    }
+
+    // NOTE: Only for blocks the heap contains().
+    static u32 class_of(void const* ptr)
+    {
+        return s_span_classes[((uptr)ptr - s_spans.base)
+            / Config::span_size];
+    }
+
+    // NOTE: Null once the heap can not grow.
+    static void* allocate(u32 size_class)
+    {
+        auto size = Config::class_size(size_class);
+        if (t_cache_is_gone) [[unlikely]] {
+            auto list = FreeList();
+            refill(list, size_class);
+            if (list.count == 0)
+                return nullptr;
+            auto* block = list.pop();
+            release(list, size_class, list.count);
+            count(&Counters::bytes_in_use, size);
+            return block;
+        }
+
+        t_cache.register_if_needed();
+        auto& list = t_cache.lists[size_class];
+        if (list.count == 0) {
+            refill(list, size_class);
+            if (list.count == 0)
+                return nullptr;
+            add(t_cache.counters.cached_bytes, list.count * size);
+        }
+        add(t_cache.counters.cached_bytes, -size);
+        add(t_cache.counters.bytes_in_use, size);
+        return list.pop();
+    }
+
+    static void free(void* ptr, u32 size_class)
+    {
+        auto size = Config::class_size(size_class);
+        if (t_cache_is_gone) [[unlikely]] {
+            auto list = FreeList();
+            list.push((Block*)ptr);
+            release(list, size_class, 1);
+            count(&Counters::bytes_in_use, -size);
+            return;
+        }
+
+        t_cache.register_if_needed();
+        auto& list = t_cache.lists[size_class];
+        list.push((Block*)ptr);
+        add(t_cache.counters.bytes_in_use, -size);
+        add(t_cache.counters.cached_bytes, size);
+        auto batch = Config::batch_size(size_class);
+        if (list.count > 2 * batch) {
+            release(list, size_class, batch);
+            add(t_cache.counters.cached_bytes, -(batch * size));
+        }
+    }
+
+    static void count(u64 Counters::*counter, u64 amount)
+    {
+        if (t_cache_is_gone) [[unlikely]] {
+            __atomic_add_fetch(&(s_retired.*counter), amount,
+                __ATOMIC_RELAXED);
+            return;
+        }
+        t_cache.register_if_needed();
+        add(t_cache.counters.*counter, amount);
+    }
+
+    // NOTE: Spans are not committed past this many bytes, the
+    //       reserved range is the limit otherwise.
+    static void set_limit(usize bytes)
+    {
+        s_spans.lock.lock();
+        s_spans.limit = bytes;
+        s_spans.lock.unlock();
+    }
+
+    // NOTE: Summed over all threads without stopping them, so the
+    //       numbers may be off by what they did meanwhile.
+    static Stats stats()
+    {
+        auto stats = Stats {};
+        auto& counters = stats.counters;
+        auto sum = [&](Counters const& from) {
+            counters.allocations += load(from.allocations);
+            counters.frees += load(from.frees);
+            counters.bytes_in_use += load(from.bytes_in_use);
+            counters.cached_bytes += load(from.cached_bytes);
+            counters.overflow += load(from.overflow);
+        };
+        s_caches_lock.lock();
+        sum(s_retired);
+        for (auto* cache = s_caches; cache; cache = cache->next)
+            sum(cache->counters);
+        s_caches_lock.unlock();
+
+        for (u32 i = 0; i < Config::class_count; i++) {
+            s_central[i].lock.lock();
+            auto cached = s_central[i].blocks.count;
+            counters.cached_bytes += cached * Config::class_size(i);
+            s_central[i].lock.unlock();
+        }
+        s_spans.lock.lock();
+        stats.span_bytes = s_spans.used;
+        s_spans.lock.unlock();
+        return stats;
+    }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    struct FreeList {
+        void push(Block* block)
+        {
+            block->next = head;
+            head = block;
+            count++;
+        }
+
+        Block* pop()
+        {
+            auto* block = head;
+            head = block->next;
+            count--;
+            return block;
+        }
+
+        // NOTE: Moves up to that many blocks from the front of this
+        //       list to the front of the other one.
+        void move_to(FreeList& other, u32 blocks)
+        {
+            if (blocks > count)
+                blocks = count;
+            if (blocks == 0)
+                return;
+            auto* first = head;
+            auto* last = head;
+            for (u32 i = 1; i < blocks; i++)
+                last = last->next;
+            head = last->next;
+            count -= blocks;
+            last->next = other.head;
+            other.head = first;
+            other.count += blocks;
+        }
+
+        Block* head { nullptr };
+        u32 count { 0 };
+    };
+
+    // NOTE: Blocks of a new span are carved off as they are handed
+    //       out, so its pages are not touched before they are used.
+    struct CentralList {
+        Lock lock {};
+        FreeList blocks {};
+        u8* carved_to { nullptr };
+        u8* span_end { nullptr };
+    };
+
+    struct Spans {
+        Lock lock {};
+        uptr base { 0 };
+        usize used { 0 };
+        usize committed { 0 };
+        usize limit { Config::reserve_size };
+        bool has_failed { false };
+    };
+
+    struct ThreadCache {
+        constexpr ThreadCache() = default;
+
+        ~ThreadCache()
+        {
+            for (u32 i = 0; i < Config::class_count; i++)
+                release(lists[i], i, lists[i].count);
+            counters.cached_bytes = 0;
+            t_cache_is_gone = true;
+            if (!is_registered)
+                return;
+
+            s_caches_lock.lock();
+            if (previous != nullptr)
+                previous->next = next;
+            else
+                s_caches = next;
+            if (next != nullptr)
+                next->previous = previous;
+            s_caches_lock.unlock();
+
+            u64 Counters::*const retired[] = {
+                &Counters::allocations,
+                &Counters::frees,
+                &Counters::bytes_in_use,
+                &Counters::overflow,
+            };
+            for (auto counter : retired) {
+                __atomic_add_fetch(&(s_retired.*counter),
+                    counters.*counter, __ATOMIC_RELAXED);
+            }
+        }
+
+        void register_if_needed()
+        {
+            if (is_registered) [[likely]]
+                return;
+            s_caches_lock.lock();
+            next = s_caches;
+            if (next != nullptr)
+                next->previous = this;
+            s_caches = this;
+            s_caches_lock.unlock();
+            is_registered = true;
+        }
+
+        FreeList lists[Config::class_count] {};
+        Counters counters {};
+        ThreadCache* next { nullptr };
+        ThreadCache* previous { nullptr };
+        bool is_registered { false };
+    };
+
+    // NOTE: Counters are written by their own thread only, but read
+    //       by stats() from any.
+    static void add(u64& counter, u64 amount)
+    {
+        __atomic_store_n(&counter, counter + amount,
+            __ATOMIC_RELAXED);
+    }
+
+    static u64 load(u64 const& counter)
+    {
+        return __atomic_load_n(&counter, __ATOMIC_RELAXED);
+    }
+
+    // NOTE: In the order they nest, a central list is locked while
+    //       it takes a span.
+    static void lock_everything()
+    {
+        for (auto& central : s_central)
+            central.lock.lock();
+        s_spans.lock.lock();
+        s_caches_lock.lock();
+    }
+
+    static void unlock_everything()
+    {
+        s_caches_lock.unlock();
+        s_spans.lock.unlock();
+        for (auto& central : s_central)
+            central.lock.unlock();
+    }
+
+    // NOTE: Only takes address space, pages are committed as spans
+    //       are handed out.
+    static bool reserve()
+    {
+        auto reserved = System::mmap(
+            Config::reserve_size + Config::span_size, PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE);
+        if (reserved.is_error())
+            return false;
+        auto base = ((uptr)reserved.value() + Config::span_size - 1)
+            & ~(Config::span_size - 1);
+
+        // NOTE: A fork while another thread holds one of the locks
+        //       would leave it locked in the child for good.
+        pthread_atfork(lock_everything, unlock_everything,
+            unlock_everything);
+
+        __atomic_store_n(&s_spans.base, base, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    static u8* take_span(u32 size_class)
+    {
+        s_spans.lock.lock();
+        u8* span = nullptr;
+        if (s_spans.base == 0 && !s_spans.has_failed)
+            s_spans.has_failed = !reserve();
+        auto limit = s_spans.limit < Config::reserve_size
+            ? s_spans.limit
+            : Config::reserve_size;
+        if (!s_spans.has_failed && s_spans.used == s_spans.committed
+            && s_spans.committed + Config::commit_size <= limit) {
+            auto* start = (u8*)s_spans.base + s_spans.committed;
+            if (Config::commit(start, Config::commit_size))
+                s_spans.committed += Config::commit_size;
+        }
+        if (s_spans.used < s_spans.committed) {
+            span = (u8*)s_spans.base + s_spans.used;
+            s_span_classes[s_spans.used / Config::span_size]
+                = size_class;
+            s_spans.used += Config::span_size;
+        }
+        s_spans.lock.unlock();
+        return span;
+    }
+
+    // NOTE: Hands out up to a batch of blocks, from the central
+    //       list or a new span. None when the heap can not grow.
+    static void refill(FreeList& into, u32 size_class)
+    {
+        auto& central = s_central[size_class];
+        auto size = Config::class_size(size_class);
+        auto batch = Config::batch_size(size_class);
+        central.lock.lock();
+        central.blocks.move_to(into, batch);
+        while (into.count < batch) {
+            auto left = central.span_end - central.carved_to;
+            if ((usize)left < size) {
+                auto* span = take_span(size_class);
+                if (span == nullptr)
+                    break;
+                central.carved_to = span;
+                central.span_end = span + Config::span_size;
+            }
+            into.push((Block*)central.carved_to);
+            central.carved_to += size;
+        }
+        central.lock.unlock();
+    }
+
+    static void release(FreeList& from, u32 size_class, u32 blocks)
+    {
+        auto& central = s_central[size_class];
+        central.lock.lock();
+        from.move_to(central.blocks, blocks);
+        central.lock.unlock();
+    }
+
+    static inline CentralList s_central[Config::class_count] {};
+    static inline Spans s_spans {};
+    static inline u8 s_span_classes[Config::reserve_size
+        / Config::span_size] {};
+
+    static inline Lock s_caches_lock {};
+    static inline ThreadCache* s_caches { nullptr };
+    static inline Counters s_retired {};
+
+    static inline thread_local ThreadCache t_cache {};
+
+    // NOTE: Set once the cache is destroyed at thread exit, blocks
+    //       freed by later destructors go to the central lists.
+    static inline thread_local bool t_cache_is_gone { false };
+};
+
+}
+
+using Ty::BlockHeap; // NOLINT
@@ -0,0 +1,716 @@
+#include "Deflate.h"
+#include "Defer.h"
+#include "Memory.h"
+
+namespace Ty::Deflate {
+
+namespace {
+
+constexpr u32 window_size = 32 * 1024;
+constexpr u32 window_mask = window_size - 1;
+constexpr u32 hash_bits = 15;
+constexpr u32 hash_size = 1 << hash_bits;
+constexpr u32 min_match = 3;
+constexpr u32 max_match = 258;
+
+// NOTE: About what zlib does at its default level, matches this
+//       long are taken without looking any further.
+constexpr u32 max_chain = 128;
+constexpr u32 nice_match = 128;
+
+constexpr u32 block_symbols = 16 * 1024;
+constexpr u32 max_stored_size = 65535;
+
+constexpr u32 litlen_count = 286;
+constexpr u32 distance_count = 30;
+constexpr u32 code_length_count = 19;
+constexpr u32 end_of_block = 256;
+constexpr u32 max_code_length = 15;
+constexpr u32 max_code_length_code_length = 7;
+
+constexpr u16 length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35,
+    43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+constexpr u8 length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+    2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+constexpr u16 distance_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193,
+    12289, 16385, 24577,
+};
+constexpr u8 distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+constexpr u8 code_length_order[code_length_count] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5,
+    11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+constexpr u8 code_length_extra[code_length_count] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7,
+};
+
+// NOTE: Index into length_base, the code is 257 past it.
+constexpr u32 length_code(u32 length)
+{
+    auto offset = length - min_match;
+    if (offset < 8)
+        return offset;
+    if (offset == max_match - min_match)
+        return 28;
+    u32 high_bit = 31 - __builtin_clz(offset);
+    return 4 * (high_bit - 1) + ((offset >> (high_bit - 2)) & 3);
+}
+
+constexpr u32 distance_code(u32 distance)
+{
+    auto offset = distance - 1;
+    if (offset < 4)
+        return offset;
+    u32 high_bit = 31 - __builtin_clz(offset);
+    return 2 * high_bit + ((offset >> (high_bit - 1)) & 1);
+}
+
+struct CRC32Table {
+    u32 entries[256];
+};
+
+constexpr CRC32Table make_crc32_table()
+{
+    auto table = CRC32Table();
+    for (u32 i = 0; i < 256; i++) {
+        auto value = i;
+        for (u32 bit = 0; bit < 8; bit++)
+            value = (value & 1) ? 0xEDB88320U ^ (value >> 1)
+                                : value >> 1;
+        table.entries[i] = value;
+    }
+    return table;
+}
+constexpr auto crc32_table = make_crc32_table();
+
+// NOTE: A literal byte when distance is 0, a match otherwise.
+struct Symbol {
+    u16 value;
+    u16 distance;
+};
+
+// NOTE: Bits are bit reversed already, as DEFLATE sends codes
+//       starting from their most significant bit.
+struct Code {
+    u16 bits;
+    u8 length;
+};
+
+struct BitWriter {
+    Vector<char>& output;
+    u64 bits { 0 };
+    u32 count { 0 };
+
+    // NOTE: Callers make sure output has room.
+    void write(u32 value, u32 size)
+    {
+        bits |= (u64)value << count;
+        count += size;
+        while (count >= 8) {
+            output.unchecked_append((char)bits);
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    void write(Code code) { write(code.bits, code.length); }
+
+    void align()
+    {
+        if (count != 0)
+            write(0, 8 - count);
+    }
+};
+
+// NOTE: Moffat and Katajainen's in place algorithm. Takes weights
+//       sorted from lightest to heaviest, and leaves the code
+//       length of each in its place.
+void minimum_redundancy(u32* weights, u32 count)
+{
+    weights[0] += weights[1];
+    u32 root = 0;
+    u32 leaf = 2;
+    for (u32 next = 1; next < count - 1; next++) {
+        if (leaf >= count || weights[root] < weights[leaf]) {
+            weights[next] = weights[root];
+            weights[root++] = next;
+        } else {
+            weights[next] = weights[leaf++];
+        }
+        if (leaf >= count
+            || (root < next && weights[root] < weights[leaf])) {
+            weights[next] += weights[root];
+            weights[root++] = next;
+        } else {
+            weights[next] += weights[leaf++];
+        }
+    }
+
+    weights[count - 2] = 0;
+    for (i32 next = (i32)count - 3; next >= 0; next--)
+        weights[next] = weights[weights[next]] + 1;
+
+    i32 available = 1;
+    i32 used = 0;
+    u32 depth = 0;
+    i32 root_index = (i32)count - 2;
+    i32 next = (i32)count - 1;
+    while (available > 0) {
+        while (root_index >= 0 && weights[root_index] == depth) {
+            used++;
+            root_index--;
+        }
+        while (available > used) {
+            weights[next--] = depth;
+            available--;
+        }
+        available = 2 * used;
+        depth++;
+        used = 0;
+    }
+}
+
+void build_lengths(u32 const* frequencies, u32 count,
+    u32 max_length, u8* lengths)
+{
+    u16 symbols[litlen_count];
+    u32 weights[litlen_count];
+    u32 used = 0;
+    for (u32 i = 0; i < count; i++) {
+        lengths[i] = 0;
+        if (frequencies[i] != 0)
+            symbols[used++] = (u16)i;
+    }
+    if (used == 0)
+        return;
+    if (used == 1) {
+        lengths[symbols[0]] = 1;
+        return;
+    }
+
+    for (u32 i = 1; i < used; i++) {
+        auto symbol = symbols[i];
+        auto weight = frequencies[symbol];
+        auto j = i;
+        for (; j > 0 && frequencies[symbols[j - 1]] > weight; j--)
+            symbols[j] = symbols[j - 1];
+        symbols[j] = symbol;
+    }
+    for (u32 i = 0; i < used; i++)
+        weights[i] = frequencies[symbols[i]];
+    minimum_redundancy(weights, used);
+
+    // NOTE: Codes past the limit are cut down to it, and the
+    //       overfull tree that leaves is fixed up by moving codes
+    //       one level deeper until it is complete again.
+    u32 length_counts[max_code_length + 1] = {};
+    for (u32 i = 0; i < used; i++) {
+        auto length = weights[i] < max_length ? weights[i]
+                                              : max_length;
+        length_counts[length]++;
+    }
+    u32 total = 0;
+    for (u32 length = 1; length <= max_length; length++)
+        total += length_counts[length] << (max_length - length);
+    while (total != 1U << max_length) {
+        length_counts[max_length]--;
+        for (u32 length = max_length - 1; length > 0; length--) {
+            if (length_counts[length] != 0) {
+                length_counts[length]--;
+                length_counts[length + 1] += 2;
+                break;
+            }
+        }
+        total--;
+    }
+
+    // NOTE: The heaviest symbols get the shortest codes.
+    auto next = used;
+    for (u32 length = 1; length <= max_length; length++) {
+        for (u32 i = 0; i < length_counts[length]; i++)
+            lengths[symbols[--next]] = (u8)length;
+    }
+}
+
+void build_codes(u8 const* lengths, u32 count, Code* codes)
+{
+    u32 length_counts[max_code_length + 1] = {};
+    for (u32 i = 0; i < count; i++)
+        length_counts[lengths[i]]++;
+    length_counts[0] = 0;
+
+    u32 next_code[max_code_length + 1] = {};
+    u32 code = 0;
+    for (u32 length = 1; length <= max_code_length; length++) {
+        code = (code + length_counts[length - 1]) << 1;
+        next_code[length] = code;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        auto length = lengths[i];
+        codes[i] = { 0, length };
+        if (length == 0)
+            continue;
+        auto value = next_code[length]++;
+        u16 reversed = 0;
+        for (u32 bit = 0; bit < length; bit++) {
+            reversed = (u16)((reversed << 1) | (value & 1));
+            value >>= 1;
+        }
+        codes[i].bits = reversed;
+    }
+}
+
+struct FixedCodes {
+    u8 litlen_lengths[litlen_count + 2];
+    Code litlen[litlen_count + 2];
+    Code distance[distance_count];
+};
+
+FixedCodes const& fixed_codes()
+{
+    static FixedCodes const codes = [] {
+        auto codes = FixedCodes();
+        for (u32 i = 0; i < litlen_count + 2; i++) {
+            u8 length = 8;
+            if (i >= 144 && i < 256)
+                length = 9;
+            else if (i >= 256 && i < 280)
+                length = 7;
+            codes.litlen_lengths[i] = length;
+        }
+        build_codes(codes.litlen_lengths, litlen_count + 2,
+            codes.litlen);
+        u8 distance_lengths[distance_count];
+        for (auto& length : distance_lengths)
+            length = 5;
+        build_codes(distance_lengths, distance_count,
+            codes.distance);
+        return codes;
+    }();
+    return codes;
+}
+
+struct CodeLengthSymbol {
+    u8 symbol;
+    u8 extra;
+};
+
+// NOTE: Runs of the same length become repeat symbols, 16 repeats
+//       the previous length, 17 and 18 are runs of zeroes.
+u32 encode_lengths(u8 const* lengths, u32 count,
+    CodeLengthSymbol* symbols)
+{
+    u32 size = 0;
+    for (u32 i = 0; i < count;) {
+        auto length = lengths[i];
+        u32 run = 1;
+        while (i + run < count && lengths[i + run] == length)
+            run++;
+        i += run;
+
+        if (length == 0) {
+            while (run >= 11) {
+                auto part = run < 138 ? run : 138;
+                symbols[size++] = { 18, (u8)(part - 11) };
+                run -= part;
+            }
+            if (run >= 3) {
+                symbols[size++] = { 17, (u8)(run - 3) };
+                run = 0;
+            }
+        } else {
+            symbols[size++] = { length, 0 };
+            run--;
+            while (run >= 3) {
+                auto part = run < 6 ? run : 6;
+                symbols[size++] = { 16, (u8)(part - 3) };
+                run -= part;
+            }
+        }
+        for (; run > 0; run--)
+            symbols[size++] = { length, 0 };
+    }
+    return size;
+}
+
+void write_symbols(BitWriter& writer, Symbol const* symbols,
+    u32 count, Code const* litlen, Code const* distance)
+{
+    for (u32 i = 0; i < count; i++) {
+        auto symbol = symbols[i];
+        if (symbol.distance == 0) {
+            writer.write(litlen[symbol.value]);
+            continue;
+        }
+        auto length = length_code(symbol.value);
+        writer.write(litlen[end_of_block + 1 + length]);
+        writer.write(symbol.value - length_base[length],
+            length_extra[length]);
+        auto code = distance_code(symbol.distance);
+        writer.write(distance[code]);
+        writer.write(symbol.distance - distance_base[code],
+            distance_extra[code]);
+    }
+    writer.write(litlen[end_of_block]);
+}
+
+ErrorOr<void> write_stored(BitWriter& writer, StringView raw,
+    bool is_final)
+{
+    u32 offset = 0;
+    do {
+        auto size = raw.size - offset;
+        if (size > max_stored_size)
+            size = max_stored_size;
+        auto is_last = offset + size == raw.size;
+        TRY(writer.output.ensure_capacity(
+            writer.output.size() + size + 8));
+        writer.write(is_final && is_last ? 1 : 0, 3);
+        writer.align();
+        writer.write(size, 16);
+        writer.write(~size & 0xFFFF, 16);
+        for (u32 i = 0; i < size; i++)
+            writer.output.unchecked_append(raw[offset + i]);
+        offset += size;
+    } while (offset < raw.size);
+    return {};
+}
+
+// NOTE: Symbols are what raw compressed to, the block is written in
+//       whichever form is smallest.
+ErrorOr<void> write_block(BitWriter& writer, Symbol const* symbols,
+    u32 count, StringView raw, bool is_final)
+{
+    u32 litlen_frequencies[litlen_count] = {};
+    u32 distance_frequencies[distance_count] = {};
+    u64 extra_bits = 0;
+    for (u32 i = 0; i < count; i++) {
+        auto symbol = symbols[i];
+        if (symbol.distance == 0) {
+            litlen_frequencies[symbol.value]++;
+            continue;
+        }
+        auto length = length_code(symbol.value);
+        auto distance = distance_code(symbol.distance);
+        litlen_frequencies[end_of_block + 1 + length]++;
+        distance_frequencies[distance]++;
+        extra_bits += length_extra[length];
+        extra_bits += distance_extra[distance];
+    }
+    litlen_frequencies[end_of_block] = 1;
+
+    u8 litlen_lengths[litlen_count];
+    u8 distance_lengths[distance_count];
+    build_lengths(litlen_frequencies, litlen_count, max_code_length,
+        litlen_lengths);
+    build_lengths(distance_frequencies, distance_count,
+        max_code_length, distance_lengths);
+
+    u32 litlen_used = litlen_count;
+    while (litlen_used > end_of_block + 1
+        && litlen_lengths[litlen_used - 1] == 0)
+        litlen_used--;
+    u32 distance_used = distance_count;
+    while (distance_used > 1
+        && distance_lengths[distance_used - 1] == 0)
+        distance_used--;
+    // NOTE: Blocks without matches still describe one distance
+    //       code, as some decoders refuse an empty code.
+    if (distance_lengths[0] == 0 && distance_used == 1)
+        distance_lengths[0] = 1;
+    u8 lengths[litlen_count + distance_count];
+    for (u32 i = 0; i < litlen_used; i++)
+        lengths[i] = litlen_lengths[i];
+    for (u32 i = 0; i < distance_used; i++)
+        lengths[litlen_used + i] = distance_lengths[i];
+
+    CodeLengthSymbol length_symbols[litlen_count + distance_count];
+    auto length_symbol_count = encode_lengths(lengths,
+        litlen_used + distance_used, length_symbols);
+    u32 code_length_frequencies[code_length_count] = {};
+    for (u32 i = 0; i < length_symbol_count; i++)
+        code_length_frequencies[length_symbols[i].symbol]++;
+    u8 code_length_lengths[code_length_count];
+    build_lengths(code_length_frequencies, code_length_count,
+        max_code_length_code_length, code_length_lengths);
+    u32 code_length_used = code_length_count;
+    while (code_length_used > 4) {
+        auto last = code_length_order[code_length_used - 1];
+        if (code_length_lengths[last] != 0)
+            break;
+        code_length_used--;
+    }
+
+    auto const& fixed = fixed_codes();
+    u64 dynamic_bits = 3 + 5 + 5 + 4 + 3 * code_length_used
+        + extra_bits;
+    u64 fixed_bits = 3 + extra_bits;
+    for (u32 i = 0; i < code_length_count; i++) {
+        dynamic_bits += (u64)code_length_frequencies[i]
+            * (code_length_lengths[i] + code_length_extra[i]);
+    }
+    for (u32 i = 0; i < litlen_count; i++) {
+        dynamic_bits
+            += (u64)litlen_frequencies[i] * litlen_lengths[i];
+        fixed_bits += (u64)litlen_frequencies[i]
+            * fixed.litlen_lengths[i];
+    }
+    for (u32 i = 0; i < distance_count; i++) {
+        dynamic_bits
+            += (u64)distance_frequencies[i] * distance_lengths[i];
+        fixed_bits += (u64)distance_frequencies[i] * 5;
+    }
+    auto stored_chunks = raw.size / max_stored_size + 1;
+    u64 stored_bits = stored_chunks * (3 + 7 + 32) + 8 * raw.size;
+
+    if (stored_bits <= dynamic_bits && stored_bits <= fixed_bits)
+        return write_stored(writer, raw, is_final);
+
+    auto bits
+        = dynamic_bits < fixed_bits ? dynamic_bits : fixed_bits;
+    TRY(writer.output.ensure_capacity(
+        writer.output.size() + bits / 8 + 16));
+
+    if (fixed_bits <= dynamic_bits) {
+        writer.write((is_final ? 1 : 0) | 1 << 1, 3);
+        write_symbols(writer, symbols, count, fixed.litlen,
+            fixed.distance);
+        return {};
+    }
+
+    Code litlen_codes[litlen_count];
+    Code distance_codes[distance_count];
+    Code code_length_codes[code_length_count];
+    build_codes(litlen_lengths, litlen_count, litlen_codes);
+    build_codes(distance_lengths, distance_count, distance_codes);
+    build_codes(code_length_lengths, code_length_count,
+        code_length_codes);
+
+    writer.write((is_final ? 1 : 0) | 2 << 1, 3);
+    writer.write(litlen_used - 257, 5);
+    writer.write(distance_used - 1, 5);
+    writer.write(code_length_used - 4, 4);
+    for (u32 i = 0; i < code_length_used; i++)
+        writer.write(code_length_lengths[code_length_order[i]], 3);
+    for (u32 i = 0; i < length_symbol_count; i++) {
+        auto symbol = length_symbols[i];
+        writer.write(code_length_codes[symbol.symbol]);
+        writer.write(symbol.extra,
+            code_length_extra[symbol.symbol]);
+    }
+    write_symbols(writer, symbols, count, litlen_codes,
+        distance_codes);
+    return {};
+}
+
+// NOTE: Compares eight bytes at a time, the first differing byte
+//       is the lowest set one in their xor on little endian.
+u32 match_length(char const* a, char const* b, u32 max_length)
+{
+    u32 length = 0;
+    while (length + 8 <= max_length) {
+        u64 x;
+        u64 y;
+        __builtin_memcpy(&x, a + length, sizeof(x));
+        __builtin_memcpy(&y, b + length, sizeof(y));
+        if (auto difference = x ^ y; difference != 0)
+            return length + (__builtin_ctzll(difference) >> 3);
+        length += 8;
+    }
+    while (length < max_length && a[length] == b[length])
+        length++;
+    return length;
+}
+
+struct Match {
+    u32 length;
+    u32 distance;
+};
+
+// NOTE: Chains of earlier positions with the same three byte hash.
+//       Positions are stored plus one, so 0 ends a chain.
+struct Matcher {
+    StringView data;
+    u32* head;
+    u32* previous;
+
+    u32 hash_at(u32 position) const
+    {
+        u32 value = (u8)data[position] | (u8)data[position + 1] << 8
+            | (u8)data[position + 2] << 16;
+        return (value * 2654435761U) >> (32 - hash_bits);
+    }
+
+    void insert(u32 position)
+    {
+        if (position + min_match > data.size)
+            return;
+        auto hash = hash_at(position);
+        previous[position & window_mask] = head[hash];
+        head[hash] = position + 1;
+    }
+
+    Match longest_match(u32 position) const
+    {
+        auto best = Match { 0, 0 };
+        if (position + min_match > data.size)
+            return best;
+        auto max_length = data.size - position;
+        if (max_length > max_match)
+            max_length = max_match;
+
+        auto candidate = head[hash_at(position)];
+        for (u32 chain = 0; candidate != 0 && chain < max_chain;
+             chain++) {
+            auto start = candidate - 1;
+            if (position - start > window_size)
+                break;
+            if (data[start + best.length]
+                == data[position + best.length]) {
+                auto length = match_length(data.data + start,
+                    data.data + position, max_length);
+                if (length > best.length) {
+                    best = { length, position - start };
+                    // NOTE: Nothing longer fits, and looking
+                    //       further would read past the end.
+                    if (length >= nice_match
+                        || length == max_length)
+                        break;
+                }
+            }
+            // NOTE: Slots are reused once positions fall out of the
+            //       window, chains only ever go backwards.
+            auto next = previous[start & window_mask];
+            if (next >= candidate)
+                break;
+            candidate = next;
+        }
+        if (best.length < min_match)
+            return { 0, 0 };
+        return best;
+    }
+};
+
+ErrorOr<void> compress_into(Vector<char>& output, StringView input)
+{
+    auto* head
+        = (u32*)TRY(allocate_memory(hash_size * sizeof(u32)));
+    Defer free_head = [&] {
+        free_memory(head);
+    };
+    auto* previous
+        = (u32*)TRY(allocate_memory(window_size * sizeof(u32)));
+    Defer free_previous = [&] {
+        free_memory(previous);
+    };
+    auto* symbols = (Symbol*)TRY(
+        allocate_memory(block_symbols * sizeof(Symbol)));
+    Defer free_symbols = [&] {
+        free_memory(symbols);
+    };
+    __builtin_memset(head, 0, hash_size * sizeof(u32));
+
+    auto writer = BitWriter { output };
+    auto matcher = Matcher { input, head, previous };
+    u32 count = 0;
+    u32 block_start = 0;
+    u32 position = 0;
+    auto flush_block = [&](bool is_final) -> ErrorOr<void> {
+        TRY(write_block(writer, symbols, count,
+            input.part(block_start, position), is_final));
+        count = 0;
+        block_start = position;
+        return {};
+    };
+
+    while (position < input.size) {
+        if (count + 2 > block_symbols)
+            TRY(flush_block(false));
+
+        auto match = matcher.longest_match(position);
+        matcher.insert(position);
+        // NOTE: A longer match starting at the next byte is worth
+        //       a literal.
+        if (match.length != 0 && match.length < nice_match) {
+            auto next = matcher.longest_match(position + 1);
+            if (next.length > match.length) {
+                symbols[count++] = { (u8)input[position], 0 };
+                position++;
+                matcher.insert(position);
+                match = next;
+            }
+        }
+
+        if (match.length == 0) {
+            symbols[count++] = { (u8)input[position], 0 };
+            position++;
+            continue;
+        }
+        symbols[count++] = {
+            (u16)match.length,
+            (u16)match.distance,
+        };
+        for (u32 i = 1; i < match.length; i++)
+            matcher.insert(position + i);
+        position += match.length;
+    }
+    TRY(flush_block(true));
+
+    TRY(output.ensure_capacity(output.size() + 1));
+    writer.align();
+    return {};
+}
+
+}
+
+ErrorOr<Vector<char>> compress(StringView input)
+{
+    auto output = TRY(Vector<char>::create(input.size / 2 + 64));
+    TRY(compress_into(output, input));
+    return output;
+}
+
+ErrorOr<Vector<char>> gzip(StringView input)
+{
+    auto output = TRY(Vector<char>::create(input.size / 2 + 64));
+
+    // NOTE: No modification time, name or extra fields, and 255 as
+    //       the operating system, which stands for unknown.
+    constexpr u8 header[] = {
+        0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF,
+    };
+    for (auto byte : header)
+        output.unchecked_append((char)byte);
+
+    TRY(compress_into(output, input));
+
+    TRY(output.ensure_capacity(output.size() + 8));
+    auto crc = crc32(input);
+    for (u32 i = 0; i < 4; i++)
+        output.unchecked_append((char)(crc >> (8 * i)));
+    for (u32 i = 0; i < 4; i++)
+        output.unchecked_append((char)(input.size >> (8 * i)));
+    return output;
+}
+
+u32 crc32(StringView input, u32 crc)
+{
+    crc = ~crc;
+    for (u32 i = 0; i < input.size; i++) {
+        crc = crc32_table.entries[(crc ^ (u8)input[i]) & 0xFF]
+            ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "Base.h"
+#include "ErrorOr.h"
+#include "StringView.h"
+#include "Vector.h"
+
+// DEFLATE (RFC 1951) compression with gzip (RFC 1952) framing, for
+// compressing files once and serving the result many times. Matches
+// are found with hash chains and one step of lazy matching, blocks
+// are written with whichever of dynamic Huffman codes, the fixed
+// codes or no compression comes out smallest.
+namespace Ty::Deflate {
+
+// NOTE: A raw DEFLATE stream, for containers other than gzip.
+ErrorOr<Vector<char>> compress(StringView input);
+
+// NOTE: A single gzip member holding input.
+ErrorOr<Vector<char>> gzip(StringView input);
+
+u32 crc32(StringView input, u32 crc = 0);
+
+}
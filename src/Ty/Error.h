@@ -1,6 +1,5 @@
 #pragma once
 #include "Base.h"
-#include "Hardware.h"
 #include "Id.h"
 #include "StaticVector.h"
 #include "StringView.h"
@@ -24,7 +23,7 @@ struct ErrorCodeData {
 };
 using ErrorCode = SmallId<ErrorCodeData>;
 
-// More than 0x1000 errors on 0xFF cores seems a bit much.
+// More than 0x1000 errors on 0xFF threads seems a bit much.
 using ErrorCodes
     = StaticVector<StaticVector<ErrorCodeData, 0x1000>, 0xFF>;
 
@@ -116,12 +115,27 @@ private:
             .function = function_view,
             .line = line_in_file,
         };
-        m_thread_slot = Hardware::current_thread();
+        m_thread_slot = thread_slot();
         m_code = MUST(
             s_error_codes[m_thread_slot].find_or_append(data));
     }
 
+    // NOTE: Tables are only appended to by the thread they belong
+    //       to, so they need no lock. Threads get one on their
+    //       first error, and only share them past 0xFF threads.
+    static u8 thread_slot()
+    {
+        static thread_local u8 slot = 0xFF;
+        if (slot == 0xFF) [[unlikely]] {
+            auto count = __atomic_fetch_add(&s_thread_count, 1,
+                __ATOMIC_RELAXED);
+            slot = count % 0xFF;
+        }
+        return slot;
+    }
+
     static ErrorCodes s_error_codes;
+    static inline u32 s_thread_count { 0 };
 };
 
 }
@@ -2,6 +2,7 @@
 
 namespace Ty {
 
+struct Arena;
 struct StringBuffer;
 struct Error;
 
@@ -1,10 +1,15 @@
 #pragma once
 #include "Base.h"
+#include <unistd.h>
+
+#ifdef __linux__
+#    include <sched.h>
+#endif
 
 namespace Ty {
 
 struct Hardware {
-    static Hardware the()
+    static Hardware const& the()
     {
         static Hardware hardware;
 
@@ -13,50 +18,107 @@ struct Hardware {
             auto info = Info::the();
             hardware.m_threads = info.threads;
             hardware.m_cores = info.cores;
+#ifdef __linux__
+            hardware.m_cpus = info.cpus;
+#endif
         }
 
         return hardware;
     }
 
+    // NOTE: Threads this process may run on, which is every online
+    //       one unless it has been given a narrower affinity.
     u32 threads() const { return m_threads; }
     u32 cores() const { return m_cores; }
+
+    // NOTE: The CPU number of the index-th of threads(), to pin to.
+    u32 cpu(u32 index) const
+    {
+#ifdef __linux__
+        auto left = index;
+        for (u32 cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (!CPU_ISSET(cpu, &m_cpus))
+                continue;
+            if (left-- == 0)
+                return cpu;
+        }
+#endif
+        return index;
+    }
+
+    // NOTE: The CPU the calling thread runs on right now, as the
+    //       system numbers them.
     static u32 current_thread()
     {
-        return Info::the().current_thread;
+#ifdef __linux__
+        if (auto cpu = sched_getcpu(); cpu >= 0)
+            return cpu;
+#endif
+        return 0;
     }
 
 private:
+    struct Registers {
+        u32 eax;
+        u32 ebx;
+        u32 ecx;
+        u32 edx;
+    };
+
+    static Registers cpuid(u32 leaf, u32 sub_leaf)
+    {
+        Registers registers;
+
+        asm volatile("cpuid"
+                     : "=a"(registers.eax), "=b"(registers.ebx),
+                     "=c"(registers.ecx), "=d"(registers.edx)
+                     : "0"(leaf), "2"(sub_leaf)
+                     :);
+
+        return registers;
+    }
+
     struct Info {
         u32 cores;
         u32 threads;
-        u32 unknown;
-        u32 current_thread;
+#ifdef __linux__
+        cpu_set_t cpus;
+#endif
 
         static Info the()
         {
-            Info info;
-
-            asm volatile("cpuid"
-                         : "=a"(info.threads), "=b"(info.cores),
-                         "=c"(info.unknown),
-                         "=d"(info.current_thread)
-                         : "0"(11), "2"(0)
-                         :);
+            auto info = Info {};
+#ifdef __linux__
+            CPU_ZERO(&info.cpus);
+            if (sched_getaffinity(0, sizeof(info.cpus), &info.cpus)
+                == 0)
+                info.threads = CPU_COUNT(&info.cpus);
+#endif
+            if (info.threads == 0) {
+                auto online = sysconf(_SC_NPROCESSORS_ONLN);
+                info.threads = online > 0 ? (u32)online : 1;
+            }
 
+            // NOTE: Leaf 0x0B sub-leaf 0 is the SMT level, its EBX
+            //       holds the logical processors in a core. The
+            //       core level above it only counts one package.
+            auto threads_per_core = cpuid(0x0B, 0).ebx & 0xFFFF;
+            if (threads_per_core == 0)
+                threads_per_core = 1;
+            info.cores = info.threads / threads_per_core;
+            if (info.cores == 0)
+                info.cores = 1;
             return info;
         }
     };
 
     constexpr Hardware() = default;
 
-    constexpr Hardware(u32 threads, u32 cores)
-        : m_threads(threads)
-        , m_cores(cores)
-    {
-    }
-
-    u32 m_threads;
-    u32 m_cores;
+    u32 m_threads { 1 };
+    u32 m_cores { 1 };
+#ifdef __linux__
+    cpu_set_t m_cpus {};
+#endif
 };
 
 }
@@ -0,0 +1,71 @@
+#pragma once
+#include "Base.h"
+#include "StringView.h"
+
+namespace Ty {
+
+// NOTE: FNV-1a, keys hashed here are short, like routes and paths.
+constexpr u32 hash(StringView key)
+{
+    u32 value = 2166136261U;
+    for (u32 i = 0; i < key.size; i++) {
+        value ^= (u8)key.data[i];
+        value *= 16777619U;
+    }
+    return value;
+}
+
+// NOTE: Mixes every bit of the input into the low ones, which is
+//       what power of two sized tables look at.
+constexpr u32 hash(u32 key)
+{
+    key ^= key >> 16;
+    key *= 0x85EBCA6BU;
+    key ^= key >> 13;
+    key *= 0xC2B2AE35U;
+    key ^= key >> 16;
+    return key;
+}
+
+constexpr u32 hash(i32 key) { return hash((u32)key); }
+
+// NOTE: For whole file contents, where FNV-1a would spend a
+//       multiply on every byte. Takes 32 bytes a round, spread over
+//       four lanes that do not wait on each other.
+inline u64 content_hash(char const* data, u64 size)
+{
+    constexpr u64 prime = 0x9E3779B97F4A7C15ULL;
+    auto mix = [](u64 value) {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDULL;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ULL;
+        value ^= value >> 33;
+        return value;
+    };
+    auto load = [](char const* from) {
+        u64 value;
+        __builtin_memcpy(&value, from, sizeof(value));
+        return value;
+    };
+
+    u64 lanes[4] = { prime, prime << 1, prime << 2, prime << 3 };
+    u64 i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (u32 lane = 0; lane < 4; lane++) {
+            lanes[lane] = (lanes[lane] ^ load(data + i + lane * 8))
+                * prime;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+    auto value = size * prime;
+    for (auto lane : lanes)
+        value = mix(value ^ lane);
+    for (; i + 8 <= size; i += 8)
+        value = mix(value ^ load(data + i));
+    u64 tail = 0;
+    __builtin_memcpy(&tail, data + i, size - i);
+    return mix(value ^ tail);
+}
+
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include "ErrorOr.h"
+#include "Hash.h"
+#include "Id.h"
+#include "Move.h"
+#include "Optional.h"
+#include "Try.h"
+#include "Vector.h"
+#include "Verify.h"
+
+namespace Ty {
+
+// Keeps keys and values in insertion order like LinearMap, so ids
+// stay stable until entries are removed, and finds them through a
+// power of two sized table of hash and index pairs that is probed
+// linearly. The hash of every key is stored in the table, so keys
+// are only compared when the full hashes match, and growing does
+// not hash them again.
+template <typename Key, typename Value>
+struct HashMap {
+    static ErrorOr<HashMap> create(u32 capacity = 8)
+    {
+        auto map = HashMap {
+            TRY(Vector<Key>::create(capacity)),
+            TRY(Vector<Value>::create(capacity)),
+        };
+        TRY(map.rehash(table_size_for(capacity)));
+        return map;
+    }
+
+    ErrorOr<Id<Value>> append(Key key, Value value)
+    {
+        auto key_hash = hash(key);
+        if (find(key, key_hash).has_value())
+            return Error::from_string_literal("key already in map");
+        if (table_size_for(m_keys.size() + 1) > m_slots.size())
+            TRY(rehash(m_slots.size() * 2));
+
+        TRY(m_keys.append(move(key)));
+        auto id = TRY(m_values.append(move(value)));
+        insert_slot(key_hash, id.raw());
+        return Id<Value>(id.raw());
+    }
+
+    Optional<Id<Value>> find(Key const& key) const
+    {
+        return find(key, hash(key));
+    }
+
+    // NOTE: Removes the entries should_remove(id) is true for. The
+    //       rest keep their order, but move down into the gaps, so
+    //       ids taken before are stale. The new id of every old one
+    //       is returned, an invalid one for those removed.
+    template <typename F>
+    ErrorOr<Vector<Id<Value>>> remove_if(F should_remove)
+    {
+        auto new_ids
+            = TRY(Vector<Id<Value>>::create(m_keys.size()));
+        u32 kept = 0;
+        for (u32 i = 0; i < m_keys.size(); i++) {
+            if (should_remove(Id<Value>(i))) {
+                new_ids.unchecked_append(Id<Value>::invalid());
+                continue;
+            }
+            new_ids.unchecked_append(Id<Value>(kept++));
+        }
+        if (kept == m_keys.size())
+            return new_ids;
+
+        // NOTE: The table is built anew, as emptied slots would cut
+        //       probe sequences short.
+        auto slots = TRY(empty_slots(m_slots.size()));
+        auto old_slots = move(m_slots);
+        m_slots = move(slots);
+        auto is_removed = [&](u32 i) {
+            return !new_ids[i].is_valid();
+        };
+        m_keys.remove_if(is_removed);
+        m_values.remove_if(is_removed);
+        for (auto slot : old_slots) {
+            if (slot.index == empty_index)
+                continue;
+            auto new_id = new_ids[slot.index];
+            if (new_id.is_valid())
+                insert_slot(slot.hash, new_id.raw());
+        }
+        return new_ids;
+    }
+
+    Value const& operator[](Id<Value> id) const
+    {
+        VERIFY(id.raw() < m_values.size());
+        return m_values[id];
+    }
+
+    Value& operator[](Id<Value> id)
+    {
+        VERIFY(id.raw() < m_values.size());
+        return m_values[id];
+    }
+
+    Key const& key(Id<Value> id) const
+    {
+        VERIFY(id.raw() < m_keys.size());
+        return m_keys[id.raw()];
+    }
+
+    View<Value> values() { return m_values.view(); }
+
+    u32 size() const { return m_keys.size(); }
+
+private:
+    struct Slot {
+        u32 hash;
+        u32 index;
+    };
+    static constexpr u32 empty_index = 0xFFFFFFFF;
+
+    HashMap(Vector<Key>&& keys, Vector<Value>&& values)
+        : m_keys(move(keys))
+        , m_values(move(values))
+    {
+    }
+
+    // NOTE: Keeps the table at most half full, so probe sequences
+    //       stay short.
+    static constexpr u32 table_size_for(u32 entries)
+    {
+        u32 size = 8;
+        while (size < entries * 2)
+            size *= 2;
+        return size;
+    }
+
+    Optional<Id<Value>> find(Key const& key, u32 key_hash) const
+    {
+        if (m_slots.is_empty())
+            return {};
+        auto mask = m_slots.size() - 1;
+        for (auto i = key_hash & mask;; i = (i + 1) & mask) {
+            auto slot = m_slots[i];
+            if (slot.index == empty_index)
+                return {};
+            if (slot.hash == key_hash && m_keys[slot.index] == key)
+                return Id<Value>(slot.index);
+        }
+    }
+
+    void insert_slot(u32 key_hash, u32 index)
+    {
+        auto mask = m_slots.size() - 1;
+        auto i = key_hash & mask;
+        while (m_slots[i].index != empty_index)
+            i = (i + 1) & mask;
+        m_slots[i] = { key_hash, index };
+    }
+
+    static ErrorOr<Vector<Slot>> empty_slots(u32 table_size)
+    {
+        auto slots = TRY(Vector<Slot>::create(table_size));
+        for (u32 i = 0; i < table_size; i++)
+            TRY(slots.append({ 0, empty_index }));
+        return slots;
+    }
+
+    ErrorOr<void> rehash(u32 table_size)
+    {
+        auto slots = TRY(empty_slots(table_size));
+        auto old_slots = move(m_slots);
+        m_slots = move(slots);
+        for (auto slot : old_slots) {
+            if (slot.index != empty_index)
+                insert_slot(slot.hash, slot.index);
+        }
+        return {};
+    }
+
+    Vector<Key> m_keys;
+    Vector<Value> m_values;
+    Vector<Slot> m_slots {};
+};
+
+}
+
+using Ty::HashMap; // NOLINT
@@ -31,9 +31,18 @@ struct Token {
     Type type;
 };
 
-constexpr ErrorOr<Vector<Token>> lex(StringView);
+constexpr ErrorOr<Vector<Token>> lex(StringView, Arena*);
 constexpr ErrorOr<JsonValue> parse(StringView, View<Token>,
-    Vector<JsonObject>&, Vector<JsonArray>&);
+    Vector<JsonObject>&, Vector<JsonArray>&, Arena*);
+
+// NOTE: On the heap without an arena.
+template <typename T>
+ErrorOr<T> create_in(Arena* arena)
+{
+    if (arena != nullptr)
+        return T::create(*arena);
+    return T::create();
+}
 
 }
 
@@ -49,11 +58,21 @@ constexpr Json::Json(JsonValue root, JsonObjects&& objects,
 
 ErrorOr<Json> Json::create_from(StringView source)
 {
-    auto tokens = TRY(lex(source));
-    auto objects = TRY(JsonObjects::create());
-    auto arrays = TRY(JsonArrays::create());
+    return create_from(source, nullptr);
+}
+
+ErrorOr<Json> Json::create_from(Arena& arena, StringView source)
+{
+    return create_from(source, &arena);
+}
+
+ErrorOr<Json> Json::create_from(StringView source, Arena* arena)
+{
+    auto tokens = TRY(lex(source, arena));
+    auto objects = TRY(create_in<JsonObjects>(arena));
+    auto arrays = TRY(create_in<JsonArrays>(arena));
     return Json {
-        TRY(parse(source, tokens.view(), objects, arrays)),
+        TRY(parse(source, tokens.view(), objects, arrays, arena)),
         move(objects),
         move(arrays),
     };
@@ -64,18 +83,15 @@ ErrorOr<Json> Json::create_from(StringView source)
 namespace {
 
 // FIXME: Escape strings properly.
-constexpr ErrorOr<Token> lex_string(StringView source, u32 start)
+ErrorOr<Token> lex_string(StringView source, u32 start)
 {
-    auto end = start;
-    while (end++ < source.size) {
-        if (source[end] == '"')
-            break;
-    }
-    if (source[end] != '"')
+    auto contents = source.shrink_from_start(start + 1);
+    auto quote = contents.find_first('"');
+    if (!quote.has_value())
         return Error::from_string_literal("no end quote");
     return Token {
         start,
-        end - start + 1,
+        quote.value() + 2,
         Token::String,
     };
 }
@@ -195,9 +211,10 @@ constexpr ErrorOr<Token> lex_single_token(StringView source,
     }
 }
 
-constexpr ErrorOr<Vector<Token>> lex(StringView source)
+constexpr ErrorOr<Vector<Token>> lex(StringView source,
+    Arena* arena)
 {
-    auto tokens = TRY(Vector<Token>::create());
+    auto tokens = TRY(create_in<Vector<Token>>(arena));
 
     u32 i = 0;
     while (i < source.size) {
@@ -231,7 +248,8 @@ struct SingleValue {
 };
 
 ErrorOr<SingleValue> parse_single_value(StringView source,
-    View<Token> tokens, JsonObjects& objects, JsonArrays& arrays);
+    View<Token> tokens, JsonObjects& objects, JsonArrays& arrays,
+    Arena* arena);
 
 constexpr ErrorOr<SingleValue> parse_number(StringView source,
     Token token)
@@ -259,9 +277,10 @@ constexpr ErrorOr<SingleValue> parse_string(StringView source,
 }
 
 ErrorOr<SingleValue> parse_object(StringView source,
-    View<Token> tokens, JsonObjects& objects, JsonArrays& arrays)
+    View<Token> tokens, JsonObjects& objects, JsonArrays& arrays,
+    Arena* arena)
 {
-    auto object = TRY(JsonObject::create());
+    auto object = TRY(create_in<JsonObject>(arena));
     ASSERT(tokens[0].type = Token::OpenCurly);
     tokens = View<Token> {
         tokens.data() + 1,
@@ -288,8 +307,8 @@ ErrorOr<SingleValue> parse_object(StringView source,
             tokens.size() - 2,
         };
 
-        auto value = TRY(
-            parse_single_value(source, tokens, objects, arrays));
+        auto value = TRY(parse_single_value(source, tokens,
+            objects, arrays, arena));
         TRY(object.append(key.value.unsafe_as_string(),
             value.value));
 
@@ -317,9 +336,10 @@ ErrorOr<SingleValue> parse_object(StringView source,
 }
 
 ErrorOr<SingleValue> parse_array(StringView source,
-    View<Token> tokens, JsonObjects& objects, JsonArrays& arrays)
+    View<Token> tokens, JsonObjects& objects, JsonArrays& arrays,
+    Arena* arena)
 {
-    auto array = TRY(JsonArray::create());
+    auto array = TRY(create_in<JsonArray>(arena));
 
     ASSERT(tokens[0].type == Token::OpenBracket);
     u32 consumed_tokens = 1;
@@ -337,8 +357,8 @@ ErrorOr<SingleValue> parse_array(StringView source,
     }
 
     while (tokens.size() > 0) {
-        auto value = TRY(
-            parse_single_value(source, tokens, objects, arrays));
+        auto value = TRY(parse_single_value(source, tokens,
+            objects, arrays, arena));
         consumed_tokens += value.consumed_tokens;
         tokens = View<Token> {
             tokens.data() + value.consumed_tokens,
@@ -378,15 +398,18 @@ constexpr SingleValue parse_false()
 }
 
 ErrorOr<SingleValue> parse_single_value(StringView source,
-    View<Token> tokens, JsonObjects& objects, JsonArrays& arrays)
+    View<Token> tokens, JsonObjects& objects, JsonArrays& arrays,
+    Arena* arena)
 {
     switch (tokens[0].type) {
     case Token::Number: return TRY(parse_number(source, tokens[0]));
     case Token::String: return TRY(parse_string(source, tokens[0]));
     case Token::OpenCurly:
-        return TRY(parse_object(source, tokens, objects, arrays));
+        return TRY(
+            parse_object(source, tokens, objects, arrays, arena));
     case Token::OpenBracket:
-        return TRY(parse_array(source, tokens, objects, arrays));
+        return TRY(
+            parse_array(source, tokens, objects, arrays, arena));
     case Token::Null: return parse_null();
     case Token::True: return parse_true();
     case Token::False: return parse_false();
@@ -403,10 +426,11 @@ ErrorOr<SingleValue> parse_single_value(StringView source,
 }
 
 constexpr ErrorOr<JsonValue> parse(StringView source,
-    View<Token> tokens, JsonObjects& objects, JsonArrays& arrays)
+    View<Token> tokens, JsonObjects& objects, JsonArrays& arrays,
+    Arena* arena)
 {
-    auto value
-        = TRY(parse_single_value(source, tokens, objects, arrays));
+    auto value = TRY(parse_single_value(source, tokens, objects,
+        arrays, arena));
     ASSERT(value.consumed_tokens == tokens.size());
     return value.value;
 }
@@ -119,6 +119,9 @@ private:
 struct Json {
     static ErrorOr<Json> create_from(StringView);
 
+    // NOTE: Only valid until the arena is reset.
+    static ErrorOr<Json> create_from(Arena&, StringView);
+
     constexpr JsonObject const& at(Id<JsonObject> id) const
     {
         return m_objects[id];
@@ -161,6 +164,8 @@ struct Json {
     }
 
 private:
+    static ErrorOr<Json> create_from(StringView, Arena*);
+
     constexpr Json(JsonValue root, JsonObjects&& objects,
         JsonArrays&& arrays);
 
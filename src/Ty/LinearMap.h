@@ -17,6 +17,14 @@ struct LinearMap {
         };
     }
 
+    static ErrorOr<LinearMap> create(Arena& arena)
+    {
+        return LinearMap {
+            TRY(Vector<Key>::create(arena)),
+            TRY(Vector<Value>::create(arena)),
+        };
+    }
+
     constexpr ErrorOr<void> append(Key key, Value value) requires(
         is_trivially_copyable<Key>and is_trivially_copyable<Value>)
     {
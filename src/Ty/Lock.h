@@ -0,0 +1,18 @@
+#pragma once
+#include <pthread.h>
+
+namespace Ty {
+
+// NOTE: Constant initialized, so it can guard globals used before
+//       any constructor runs.
+struct Lock {
+    void lock() { pthread_mutex_lock(&m_mutex); }
+    void unlock() { pthread_mutex_unlock(&m_mutex); }
+
+private:
+    pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+};
+
+}
+
+using Ty::Lock; // NOLINT
@@ -1,24 +1,159 @@
 #include "Memory.h"
+#include "BlockHeap.h"
 #include "ErrorOr.h"
+#include "System.h"
+
+// NOTE: Small allocations are blocks of one size class, from a
+//       heap of 64 KiB spans. free_memory() tells them apart from
+//       large ones by their address.
 
 namespace Ty {
 
-ErrorOr<void*> allocate_memory(usize size)
+namespace {
+
+constexpr usize max_small_size = 32 * 1024;
+
+// NOTE: Large allocations come from the system with their size in
+//       front, which keeps them 16 byte aligned.
+constexpr usize large_header_size = 16;
+
+// NOTE: Classes go up by 16 bytes to 128, then by a quarter of the
+//       power of two below them.
+constexpr u32 size_class_of(usize size)
 {
-    auto* ptr = __builtin_malloc(size);
-    if (!ptr)
+    if (size <= 128)
+        return size == 0 ? 0 : (u32)((size + 15) / 16 - 1);
+    auto last = size - 1;
+    u32 bit = 63 - __builtin_clzl(last);
+    return 8 + (bit - 7) * 4 + (u32)((last >> (bit - 2)) & 3);
+}
+
+struct SmallBlocks {
+    static constexpr usize span_size = 64 * 1024;
+    static constexpr usize reserve_size = 64LU * 1024 * 1024 * 1024;
+    static constexpr usize commit_size = 1024 * 1024;
+    static constexpr u32 class_count = 40;
+
+    static constexpr usize class_size(u32 size_class)
+    {
+        if (size_class < 8)
+            return (size_class + 1) * 16;
+        auto step = size_class - 8;
+        auto bit = 7 + step / 4;
+        return (1LU << bit) + (step % 4 + 1) * (1LU << (bit - 2));
+    }
+
+    // NOTE: About 16 KiB of blocks.
+    static constexpr u32 batch_size(u32 size_class)
+    {
+        auto blocks = (u32)(16 * 1024 / class_size(size_class));
+        if (blocks < 2)
+            return 2;
+        if (blocks > 32)
+            return 32;
+        return blocks;
+    }
+
+    static bool commit(u8* start, usize size)
+    {
+        auto committed = System::mprotect(start, size,
+            PROT_READ | PROT_WRITE);
+        return !committed.is_error();
+    }
+};
+
+using Heap = BlockHeap<SmallBlocks>;
+using Counters = Heap::Counters;
+
+static_assert(size_class_of(max_small_size)
+    == SmallBlocks::class_count - 1);
+static_assert(SmallBlocks::class_size(SmallBlocks::class_count - 1)
+    == max_small_size);
+static_assert(SmallBlocks::class_size(size_class_of(129)) == 160);
+static_assert(SmallBlocks::class_size(size_class_of(257)) == 320);
+
+ErrorOr<void*> allocate_large(usize size)
+{
+    auto* header
+        = (usize*)__builtin_malloc(large_header_size + size);
+    if (!header)
         return Error::from_errno();
-    return ptr;
+    *header = size;
+    Heap::count(&Counters::overflow, size);
+    return (u8*)header + large_header_size;
+}
+
+}
+
+ErrorOr<void*> allocate_memory(usize size)
+{
+    Heap::count(&Counters::allocations, 1);
+    if (size <= max_small_size) {
+        auto size_class = size_class_of(size);
+        if (auto* block = Heap::allocate(size_class); block)
+            return block;
+    }
+    return TRY(allocate_large(size));
 }
 
 ErrorOr<void*> reallocate_memory(void* ptr, usize size)
 {
-    auto* new_ptr = __builtin_realloc(ptr, size);
-    if (!new_ptr)
+    if (!ptr)
+        return TRY(allocate_memory(size));
+
+    if (Heap::contains(ptr)) {
+        auto size_class = Heap::class_of(ptr);
+        auto old_size = SmallBlocks::class_size(size_class);
+        if (size <= old_size)
+            return ptr;
+        auto* moved = TRY(allocate_memory(size));
+        __builtin_memcpy(moved, ptr, old_size);
+        free_memory(ptr);
+        return moved;
+    }
+
+    auto* header = (usize*)((u8*)ptr - large_header_size);
+    auto old_size = *header;
+    if (size <= max_small_size && size <= old_size) {
+        auto* moved = TRY(allocate_memory(size));
+        __builtin_memcpy(moved, ptr, size);
+        free_memory(ptr);
+        return moved;
+    }
+    header = (usize*)__builtin_realloc(header,
+        large_header_size + size);
+    if (!header)
         return Error::from_errno();
-    return new_ptr;
+    *header = size;
+    Heap::count(&Counters::overflow, size - old_size);
+    return (u8*)header + large_header_size;
 }
 
-void free_memory(void* ptr) { __builtin_free(ptr); }
+void free_memory(void* ptr)
+{
+    if (!ptr)
+        return;
+    Heap::count(&Counters::frees, 1);
+    if (Heap::contains(ptr)) {
+        Heap::free(ptr, Heap::class_of(ptr));
+        return;
+    }
+    auto* header = (usize*)((u8*)ptr - large_header_size);
+    Heap::count(&Counters::overflow, -*header);
+    __builtin_free(header);
+}
+
+MemoryStats memory_stats()
+{
+    auto stats = Heap::stats();
+    return MemoryStats {
+        .allocations = stats.counters.allocations,
+        .frees = stats.counters.frees,
+        .small_bytes_in_use = stats.counters.bytes_in_use,
+        .large_bytes_in_use = stats.counters.overflow,
+        .cached_bytes = stats.counters.cached_bytes,
+        .heap_bytes = stats.span_bytes,
+    };
+}
 
 }
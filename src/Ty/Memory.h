@@ -9,4 +9,27 @@ ErrorOr<void*> allocate_memory(usize size);
 ErrorOr<void*> reallocate_memory(void* ptr, usize size);
 void free_memory(void* ptr);
 
+struct MemoryStats {
+    u64 allocations;
+    u64 frees;
+
+    // NOTE: Small allocations count the size of their class.
+    u64 small_bytes_in_use;
+    u64 large_bytes_in_use;
+
+    // NOTE: Freed small blocks kept for reuse, by threads or in
+    //       the central free lists.
+    u64 cached_bytes;
+
+    // NOTE: Spans taken from the operating system, they are kept
+    //       for the rest of the process.
+    u64 heap_bytes;
+};
+
+// NOTE: Summed over all threads without stopping them, so the
+//       numbers may be off by the allocations made meanwhile.
+//       The system allocator only fills in what malloc reports,
+//       all of it counting as large.
+MemoryStats memory_stats();
+
 }
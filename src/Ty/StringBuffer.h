@@ -1,4 +1,5 @@
 #pragma once
+#include "Arena.h"
 #include "Base.h"
 #include "Concepts.h"
 #include "ErrorOr.h"
@@ -31,6 +32,29 @@ struct StringBuffer {
         return StringBuffer();
     }
 
+    // NOTE: Spills into the arena instead of the heap, and leaves
+    //       freeing to its reset().
+    static ErrorOr<StringBuffer> create_saturated(Arena& arena,
+        u32 capacity)
+    {
+        auto buffer = StringBuffer {
+            (char*)TRY(arena.allocate(capacity, 1)),
+            capacity,
+        };
+        buffer.m_arena = &arena;
+        return buffer;
+    }
+
+    static ErrorOr<StringBuffer> create(Arena& arena,
+        u32 capacity = inline_capacity)
+    {
+        if (capacity > inline_capacity)
+            return create_saturated(arena, capacity);
+        auto buffer = StringBuffer();
+        buffer.m_arena = &arena;
+        return buffer;
+    }
+
     template <typename... Args>
     static constexpr ErrorOr<StringBuffer> create_saturated_fill(
         Args... args) requires(sizeof...(args) > 1)
@@ -70,6 +94,7 @@ struct StringBuffer {
         : m_data(other.m_data)
         , m_size(other.m_size)
         , m_capacity(other.m_capacity)
+        , m_arena(other.m_arena)
     {
         if (!other.is_saturated()) {
             __builtin_memcpy(m_storage, other.m_storage,
@@ -82,7 +107,7 @@ struct StringBuffer {
     constexpr ~StringBuffer()
     {
         if (is_valid()) {
-            if (is_saturated())
+            if (is_saturated() && m_arena == nullptr)
                 free_memory(m_data);
             invalidate();
         }
@@ -95,6 +120,7 @@ struct StringBuffer {
         m_data = other.m_data;
         m_size = other.m_size;
         m_capacity = other.m_capacity;
+        m_arena = other.m_arena;
         if (!other.is_saturated()) {
             __builtin_memcpy(m_storage, other.m_storage,
                 inline_capacity);
@@ -188,6 +214,25 @@ struct StringBuffer {
     ErrorOr<void> expand_by(u32 size)
     {
         auto new_capacity = m_size + size;
+        // NOTE: Doubling keeps buffers that are cleared and reused,
+        //       like a connection's write buffer, from growing
+        //       again on every response.
+        if (new_capacity < m_capacity * 2)
+            new_capacity = m_capacity * 2;
+        if (m_arena != nullptr) {
+            auto* new_data = m_data;
+            if (is_saturated()) {
+                new_data = (char*)TRY(m_arena->reallocate(m_data,
+                    m_capacity, new_capacity));
+            } else {
+                new_data = (char*)TRY(
+                    m_arena->allocate(new_capacity, 1));
+                __builtin_memcpy(new_data, m_storage, m_size);
+            }
+            m_data = new_data;
+            m_capacity = new_capacity;
+            return {};
+        }
         auto* new_data = (char*)TRY(allocate_memory(new_capacity));
         __builtin_memcpy(new_data, data(), m_size);
         if (is_saturated())
@@ -225,6 +270,7 @@ private:
     char* m_data { nullptr };
     u32 m_size { 0 };
     u32 m_capacity { 0 };
+    Arena* m_arena { nullptr };
 };
 
 template <>
@@ -0,0 +1,337 @@
+#include "StringSearch.h"
+
+#if defined(__x86_64__)
+#    include <immintrin.h>
+#endif
+
+namespace Ty::StringSearch {
+
+namespace {
+
+u32 find_byte_scalar(char const* data, u32 size, char byte)
+{
+    for (u32 i = 0; i < size; i++) {
+        if (data[i] == byte)
+            return i;
+    }
+    return size;
+}
+
+u32 find_any_byte_scalar(char const* data, u32 size,
+    char const* set, u32 set_size)
+{
+    for (u32 i = 0; i < size; i++) {
+        for (u32 j = 0; j < set_size; j++) {
+            if (data[i] == set[j])
+                return i;
+        }
+    }
+    return size;
+}
+
+u32 find_sequence_scalar(char const* data, u32 size,
+    char const* sequence, u32 sequence_size)
+{
+    if (sequence_size == 0)
+        return 0;
+    for (u32 i = 0; i + sequence_size <= size; i++) {
+        if (data[i] != sequence[0])
+            continue;
+        if (__builtin_memcmp(data + i, sequence, sequence_size)
+            == 0)
+            return i;
+    }
+    return size;
+}
+
+bool equals_scalar(char const* a, char const* b, u32 size)
+{
+    for (u32 i = 0; i < size; i++) {
+        if (a[i] != b[i])
+            return false;
+    }
+    return true;
+}
+
+#if defined(__x86_64__)
+
+// NOTE: SSE2 is part of x86_64, so these need no check.
+
+u32 find_byte_sse2(char const* data, u32 size, char byte)
+{
+    auto needle = _mm_set1_epi8(byte);
+    u32 i = 0;
+    for (; i + 16 <= size; i += 16) {
+        auto block = _mm_loadu_si128((__m128i const*)(data + i));
+        u32 mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    return i + find_byte_scalar(data + i, size - i, byte);
+}
+
+u32 find_any_byte_sse2(char const* data, u32 size,
+    char const* set, u32 set_size)
+{
+    if (set_size > 16)
+        return find_any_byte_scalar(data, size, set, set_size);
+    __m128i needles[16];
+    for (u32 j = 0; j < set_size; j++)
+        needles[j] = _mm_set1_epi8(set[j]);
+
+    u32 i = 0;
+    for (; i + 16 <= size; i += 16) {
+        auto block = _mm_loadu_si128((__m128i const*)(data + i));
+        auto hits = _mm_setzero_si128();
+        for (u32 j = 0; j < set_size; j++) {
+            hits = _mm_or_si128(hits,
+                _mm_cmpeq_epi8(block, needles[j]));
+        }
+        u32 mask = _mm_movemask_epi8(hits);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    return i
+        + find_any_byte_scalar(data + i, size - i, set, set_size);
+}
+
+// NOTE: Compares the first and last byte of the sequence against a
+//       block at once, and only checks the rest where both match.
+u32 find_sequence_sse2(char const* data, u32 size,
+    char const* sequence, u32 sequence_size)
+{
+    if (sequence_size <= 1 || sequence_size > size) {
+        return find_sequence_scalar(data, size, sequence,
+            sequence_size);
+    }
+    auto last_offset = sequence_size - 1;
+    auto first = _mm_set1_epi8(sequence[0]);
+    auto last = _mm_set1_epi8(sequence[last_offset]);
+
+    u32 i = 0;
+    for (; i + last_offset + 16 <= size; i += 16) {
+        auto block_first
+            = _mm_loadu_si128((__m128i const*)(data + i));
+        auto block_last = _mm_loadu_si128(
+            (__m128i const*)(data + i + last_offset));
+        u32 mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+                _mm_cmpeq_epi8(block_last, last)));
+        while (mask != 0) {
+            auto offset = i + __builtin_ctz(mask);
+            if (__builtin_memcmp(data + offset + 1, sequence + 1,
+                    sequence_size - 2)
+                == 0)
+                return offset;
+            mask &= mask - 1;
+        }
+    }
+    return i
+        + find_sequence_scalar(data + i, size - i, sequence,
+            sequence_size);
+}
+
+bool equals_sse2(char const* a, char const* b, u32 size)
+{
+    u32 i = 0;
+    for (; i + 16 <= size; i += 16) {
+        auto block_a = _mm_loadu_si128((__m128i const*)(a + i));
+        auto block_b = _mm_loadu_si128((__m128i const*)(b + i));
+        u32 mask
+            = _mm_movemask_epi8(_mm_cmpeq_epi8(block_a, block_b));
+        if (mask != 0xFFFF)
+            return false;
+    }
+    return equals_scalar(a + i, b + i, size - i);
+}
+
+// NOTE: The AVX2 versions leave their tails to the SSE2 ones, which
+//       are not VEX encoded. Running those with the upper halves of
+//       the ymm registers dirty costs a state transition or a false
+//       dependency on every instruction, so they are cleared first.
+
+[[gnu::target("avx2")]] u32 find_byte_avx2(char const* data,
+    u32 size, char byte)
+{
+    auto needle = _mm256_set1_epi8(byte);
+    u32 i = 0;
+    for (; i + 32 <= size; i += 32) {
+        auto block = _mm256_loadu_si256((__m256i const*)(data + i));
+        u32 mask = _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(block, needle));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    _mm256_zeroupper();
+    return i + find_byte_sse2(data + i, size - i, byte);
+}
+
+[[gnu::target("avx2")]] u32 find_any_byte_avx2(char const* data,
+    u32 size, char const* set, u32 set_size)
+{
+    if (set_size > 16)
+        return find_any_byte_scalar(data, size, set, set_size);
+    __m256i needles[16];
+    for (u32 j = 0; j < set_size; j++)
+        needles[j] = _mm256_set1_epi8(set[j]);
+
+    u32 i = 0;
+    for (; i + 32 <= size; i += 32) {
+        auto block = _mm256_loadu_si256((__m256i const*)(data + i));
+        auto hits = _mm256_setzero_si256();
+        for (u32 j = 0; j < set_size; j++) {
+            hits = _mm256_or_si256(hits,
+                _mm256_cmpeq_epi8(block, needles[j]));
+        }
+        u32 mask = _mm256_movemask_epi8(hits);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    _mm256_zeroupper();
+    return i
+        + find_any_byte_sse2(data + i, size - i, set, set_size);
+}
+
+[[gnu::target("avx2")]] u32 find_sequence_avx2(char const* data,
+    u32 size, char const* sequence, u32 sequence_size)
+{
+    if (sequence_size <= 1 || sequence_size > size) {
+        return find_sequence_scalar(data, size, sequence,
+            sequence_size);
+    }
+    auto last_offset = sequence_size - 1;
+    auto first = _mm256_set1_epi8(sequence[0]);
+    auto last = _mm256_set1_epi8(sequence[last_offset]);
+
+    u32 i = 0;
+    for (; i + last_offset + 32 <= size; i += 32) {
+        auto block_first
+            = _mm256_loadu_si256((__m256i const*)(data + i));
+        auto block_last = _mm256_loadu_si256(
+            (__m256i const*)(data + i + last_offset));
+        u32 mask = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first),
+                _mm256_cmpeq_epi8(block_last, last)));
+        while (mask != 0) {
+            auto offset = i + __builtin_ctz(mask);
+            if (__builtin_memcmp(data + offset + 1, sequence + 1,
+                    sequence_size - 2)
+                == 0)
+                return offset;
+            mask &= mask - 1;
+        }
+    }
+    _mm256_zeroupper();
+    return i
+        + find_sequence_sse2(data + i, size - i, sequence,
+            sequence_size);
+}
+
+[[gnu::target("avx2")]] bool equals_avx2(char const* a,
+    char const* b, u32 size)
+{
+    u32 i = 0;
+    for (; i + 32 <= size; i += 32) {
+        auto block_a = _mm256_loadu_si256((__m256i const*)(a + i));
+        auto block_b = _mm256_loadu_si256((__m256i const*)(b + i));
+        u32 mask = _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(block_a, block_b));
+        if (mask != 0xFFFFFFFF)
+            return false;
+    }
+    _mm256_zeroupper();
+    return equals_sse2(a + i, b + i, size - i);
+}
+
+#endif
+
+Functions select_functions()
+{
+    if (auto avx2 = functions_for(Implementation::AVX2);
+        avx2.has_value())
+        return avx2.value();
+    if (auto sse2 = functions_for(Implementation::SSE2);
+        sse2.has_value())
+        return sse2.value();
+    return functions_for(Implementation::Scalar).value();
+}
+
+Functions const& functions()
+{
+    static Functions const selected = select_functions();
+    return selected;
+}
+
+}
+
+u32 find_byte(char const* data, u32 size, char byte)
+{
+    return functions().find_byte(data, size, byte);
+}
+
+u32 find_any_byte(char const* data, u32 size, char const* set,
+    u32 set_size)
+{
+    return functions().find_any_byte(data, size, set, set_size);
+}
+
+u32 find_sequence(char const* data, u32 size, char const* sequence,
+    u32 sequence_size)
+{
+    return functions().find_sequence(data, size, sequence,
+        sequence_size);
+}
+
+bool equals(char const* a, char const* b, u32 size)
+{
+    return functions().equals(a, b, size);
+}
+
+Implementation implementation()
+{
+    return functions().implementation;
+}
+
+Optional<Functions> functions_for(Implementation implementation)
+{
+    switch (implementation) {
+    case Implementation::Scalar:
+        return Functions {
+            find_byte_scalar,
+            find_any_byte_scalar,
+            find_sequence_scalar,
+            equals_scalar,
+            Implementation::Scalar,
+        };
+    case Implementation::SSE2:
+#if defined(__x86_64__)
+        return Functions {
+            find_byte_sse2,
+            find_any_byte_sse2,
+            find_sequence_sse2,
+            equals_sse2,
+            Implementation::SSE2,
+        };
+#else
+        return {};
+#endif
+    case Implementation::AVX2:
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("avx2"))
+            return {};
+        return Functions {
+            find_byte_avx2,
+            find_any_byte_avx2,
+            find_sequence_avx2,
+            equals_avx2,
+            Implementation::AVX2,
+        };
+#else
+        return {};
+#endif
+    }
+    return {};
+}
+
+}
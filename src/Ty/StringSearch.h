@@ -0,0 +1,42 @@
+#pragma once
+#include "Base.h"
+#include "Optional.h"
+
+// Byte scanning behind StringView. Picks an SSE2 or AVX2 version
+// on first use, depending on what the CPU supports, and falls back
+// to plain loops elsewhere. Searches return size when there is no
+// match.
+namespace Ty::StringSearch {
+
+u32 find_byte(char const* data, u32 size, char byte);
+
+// NOTE: The set is meant to be small, like "\r\n:", every byte in
+//       it costs a compare per block.
+u32 find_any_byte(char const* data, u32 size, char const* set,
+    u32 set_size);
+
+u32 find_sequence(char const* data, u32 size, char const* sequence,
+    u32 sequence_size);
+
+bool equals(char const* a, char const* b, u32 size);
+
+enum class Implementation : u8 {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+Implementation implementation();
+
+struct Functions {
+    u32 (*find_byte)(char const*, u32, char);
+    u32 (*find_any_byte)(char const*, u32, char const*, u32);
+    u32 (*find_sequence)(char const*, u32, char const*, u32);
+    bool (*equals)(char const*, char const*, u32);
+    Implementation implementation;
+};
+
+// NOTE: For tests, which hold every implementation the CPU runs
+//       against the scalar one. Empty when the CPU can not.
+Optional<Functions> functions_for(Implementation implementation);
+
+}
@@ -8,9 +8,12 @@ ErrorOr<Vector<u32>> StringView::find_all(char character) const
 {
     auto occurrences = TRY(Vector<u32>::create());
 
-    for (u32 i = 0; i < size; i++) {
-        if (data[i] == character)
-            TRY(occurrences.append(i));
+    for (u32 i = 0; i < size;) {
+        auto index = shrink_from_start(i).find_first(character);
+        if (!index.has_value())
+            break;
+        TRY(occurrences.append(i + index.value()));
+        i += index.value() + 1;
     }
 
     return occurrences;
@@ -19,14 +22,15 @@ ErrorOr<Vector<u32>> StringView::find_all(char character) const
 ErrorOr<Vector<u32>> StringView::find_all(StringView sequence) const
 {
     auto occurrences = TRY(Vector<u32>::create());
+    if (sequence.is_empty())
+        return occurrences;
 
     for (u32 i = 0; i < size;) {
-        if (sub_view(i, sequence.size) == sequence) {
-            TRY(occurrences.append(i));
-            i += sequence.size;
-            continue;
-        }
-        i++;
+        auto index = shrink_from_start(i).find_first(sequence);
+        if (!index.has_value())
+            break;
+        TRY(occurrences.append(i + index.value()));
+        i += index.value() + sequence.size;
     }
 
     return occurrences;
@@ -2,10 +2,13 @@
 #include "Base.h"
 #include "Forward.h"
 #include "Optional.h"
+#include "StringSearch.h"
 #include "Traits.h"
 
 namespace Ty {
 
+struct StringSplit;
+
 struct StringView {
     char const* data;
     u32 size;
@@ -39,6 +42,8 @@ struct StringView {
         if (!is_constant_evaluated()) {
             if (data == other.data)
                 return true;
+            if (size >= search_threshold)
+                return StringSearch::equals(data, other.data, size);
         }
 
         bool same = true;
@@ -58,6 +63,8 @@ struct StringView {
 
     constexpr bool contains(char character) const
     {
+        if (!is_constant_evaluated())
+            return find_first(character).has_value();
         for (u32 i = 0; i < size; i++) {
             if (data[i] == character)
                 return true;
@@ -124,16 +131,45 @@ struct StringView {
     ErrorOr<Vector<StringView>> split_on(StringView sequence) const;
     ErrorOr<Vector<u32>> find_all(char character) const;
     ErrorOr<Vector<u32>> find_all(StringView sequence) const;
+
+    // NOTE: Like split_on(), but walks the parts one at a time
+    //       instead of collecting them into a Vector. A view with
+    //       no delimiter in it is a single part.
+    StringSplit split(char character) const;
+    StringSplit split(StringView sequence) const;
+
     Optional<u32> find_first(char character) const
     {
-        for (u32 i = 0; i < size; i++) {
-            if (data[i] == character)
-                return i;
-        }
-        return {};
+        auto index = StringSearch::find_byte(data, size, character);
+        if (index == size)
+            return {};
+        return index;
+    }
+
+    Optional<u32> find_first(StringView sequence) const
+    {
+        auto index = StringSearch::find_sequence(data, size,
+            sequence.data, sequence.size);
+        if (index == size && sequence.size != 0)
+            return {};
+        return index;
+    }
+
+    // NOTE: First occurrence of any of the characters in set.
+    Optional<u32> find_first_of(StringView set) const
+    {
+        auto index = StringSearch::find_any_byte(data, size,
+            set.data, set.size);
+        if (index == size)
+            return {};
+        return index;
     }
 
 private:
+    // NOTE: Below this, a plain loop beats calling out to the
+    //       vectorized search.
+    static constexpr u32 search_threshold = 16;
+
     [[gnu::flatten]] static constexpr u32 strncpy(
         char* __restrict to, StringView from)
     {
@@ -153,6 +189,69 @@ private:
     }
 };
 
+struct StringSplit {
+    struct End { };
+
+    StringSplit(StringView source, StringView sequence,
+        char character)
+        : m_rest(source)
+        , m_sequence(sequence)
+        , m_character(character)
+    {
+        advance();
+    }
+
+    StringSplit begin() const { return *this; }
+    constexpr End end() const { return {}; }
+    constexpr bool operator!=(End) const { return !m_is_at_end; }
+    constexpr StringView operator*() const { return m_current; }
+    StringSplit& operator++()
+    {
+        advance();
+        return *this;
+    }
+
+private:
+    void advance()
+    {
+        if (m_is_last) {
+            m_is_at_end = true;
+            return;
+        }
+        auto index = m_sequence.is_empty()
+            ? m_rest.find_first(m_character)
+            : m_rest.find_first(m_sequence);
+        if (!index.has_value()) {
+            m_current = m_rest;
+            m_is_last = true;
+            return;
+        }
+        u32 delimiter_size = 1;
+        if (!m_sequence.is_empty())
+            delimiter_size = m_sequence.size;
+        m_current = m_rest.sub_view(0, index.value());
+        m_rest = m_rest.shrink_from_start(index.value()
+            + delimiter_size);
+    }
+
+    StringView m_rest {};
+    StringView m_current {};
+    StringView m_sequence {};
+    char m_character { 0 };
+    bool m_is_last { false };
+    bool m_is_at_end { false };
+};
+
+inline StringSplit StringView::split(char character) const
+{
+    return StringSplit(*this, {}, character);
+}
+
+inline StringSplit StringView::split(StringView sequence) const
+{
+    return StringSplit(*this, sequence, 0);
+}
+
 constexpr StringView operator""sv(c_string data, usize size)
 {
     return StringView(data, size);
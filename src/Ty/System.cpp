@@ -11,8 +11,13 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
 
+#if __linux__
+#include <sys/syscall.h>
+#endif
+
 #if __APPLE__
 #include <signal.h>
 #endif
@@ -47,6 +52,15 @@ ErrorOr<Stat> stat(c_string path)
     return Stat(buf);
 }
 
+ErrorOr<usize> read(int fd, void* data, usize size)
+{
+    auto rv = ::read(fd, data, size);
+    if (rv < 0) {
+        return Error::from_errno();
+    }
+    return (usize)rv;
+}
+
 ErrorOr<usize> write(int fd, void const* data, usize size)
 {
     auto rv = ::write(fd, data, size);
@@ -105,6 +119,14 @@ ErrorOr<void> mprotect(void* addr, usize len, int prot)
     return {};
 }
 
+ErrorOr<void> madvise(void* addr, usize len, int advice)
+{
+    auto rv = ::madvise(addr, len, advice);
+    if (rv < 0)
+        return Error::from_errno();
+    return {};
+}
+
 ErrorOr<void> remove(c_string path)
 {
     // Assume not directory.
@@ -147,6 +169,14 @@ ErrorOr<void> close(int fd)
     return {};
 }
 
+ErrorOr<void> pipe(int fds[2])
+{
+    auto rv = ::pipe(fds);
+    if (rv < 0)
+        return Error::from_errno();
+    return {};
+}
+
 ErrorOr<void> unlink(c_string path)
 {
     auto rv = ::unlink(path);
@@ -227,6 +257,21 @@ ErrorOr<u32> page_size()
     return size;
 }
 
+ErrorOr<struct rlimit> getrlimit(int resource)
+{
+    struct rlimit limit;
+    if (::getrlimit(resource, &limit) < 0)
+        return Error::from_errno();
+    return limit;
+}
+
+ErrorOr<void> setrlimit(int resource, struct rlimit limit)
+{
+    if (::setrlimit(resource, &limit) < 0)
+        return Error::from_errno();
+    return {};
+}
+
 Optional<c_string> getenv(StringView name)
 {
     for (u32 i = 0; environ[i] != nullptr; i++) {
@@ -250,8 +295,7 @@ ErrorOr<bool> has_program(StringView name)
     auto path = StringView::from_c_string(maybe_path.value());
 
     auto file_path = StringBuffer();
-    auto paths = TRY(path.split_on(':'));
-    for (auto directory : paths) {
+    for (auto directory : path.split(':')) {
         Defer clear_file_path = [&] {
             file_path.clear();
         };
@@ -270,6 +314,13 @@ ErrorOr<bool> has_program(StringView name)
 
 void sleep(u32 seconds) { ::sleep(seconds); }
 
+u64 monotonic_milliseconds()
+{
+    struct timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000 + (u64)now.tv_nsec / 1000000;
+}
+
 [[noreturn]] void exit(int code)
 {
     ::exit(code);
@@ -284,6 +335,45 @@ ErrorOr<int> fork()
     return pid;
 }
 
+ErrorOr<pthread_t> pthread_create(void* (*entry)(void*),
+    void* argument)
+{
+    pthread_t thread;
+    auto rc = ::pthread_create(&thread, nullptr, entry, argument);
+    if (rc != 0)
+        return Error::from_errno(rc);
+    return thread;
+}
+
+ErrorOr<void> pthread_join(pthread_t thread)
+{
+    auto rc = ::pthread_join(thread, nullptr);
+    if (rc != 0)
+        return Error::from_errno(rc);
+    return {};
+}
+
+ErrorOr<void> pthread_detach(pthread_t thread)
+{
+    auto rc = ::pthread_detach(thread);
+    if (rc != 0)
+        return Error::from_errno(rc);
+    return {};
+}
+
+#ifdef __linux__
+ErrorOr<void> pthread_setaffinity(pthread_t thread, u32 cpu)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    auto rc = ::pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+    if (rc != 0)
+        return Error::from_errno(rc);
+    return {};
+}
+#endif
+
 #if __APPLE__
 
 #pragma push_macro("sigemptyset")
@@ -370,6 +460,18 @@ ErrorOr<ssize_t> send(int fd, StringView view, int flags)
     return TRY(send(fd, view.data, view.size, flags));
 }
 
+ErrorOr<ssize_t> send(int fd, IOVec const* iovec, int count,
+    int flags)
+{
+    struct msghdr message { };
+    message.msg_iov = (struct iovec*)iovec;
+    message.msg_iovlen = count;
+    auto rv = ::sendmsg(fd, &message, flags);
+    if (rv < 0)
+        return Error::from_errno();
+    return rv;
+}
+
 ErrorOr<struct addrinfo*> getaddrinfo(u16 service,
     struct addrinfo hints)
 {
@@ -428,6 +530,23 @@ ErrorOr<void> setsockopt(int fd, int level, int optname, int value)
     return {};
 }
 
+ErrorOr<void> setsockopt(int fd, int level, int optname,
+    void const* value, socklen_t value_size)
+{
+    auto rv = ::setsockopt(fd, level, optname, value, value_size);
+    if (rv < 0)
+        return Error::from_errno();
+    return {};
+}
+
+ErrorOr<int> fcntl(int fd, int command, int argument)
+{
+    auto rv = ::fcntl(fd, command, argument);
+    if (rv < 0)
+        return Error::from_errno();
+    return rv;
+}
+
 static void* get_in_addr(struct sockaddr* sa)
 {
     if (sa->sa_family == AF_INET)
@@ -446,4 +565,112 @@ ErrorOr<StringBuffer> inet_ntop(struct sockaddr_storage sa)
         StringView::from_c_string(buf));
 }
 
+ErrorOr<u32> poll(struct pollfd* fds, u32 count, int timeout_ms)
+{
+    while (true) {
+        auto rv = ::poll(fds, count, timeout_ms);
+        if (rv < 0) {
+            if (errno == EINTR)
+                continue;
+            return Error::from_errno();
+        }
+        return (u32)rv;
+    }
+}
+
+#ifdef __linux__
+
+ErrorOr<int> io_uring_setup(u32 entries,
+    struct io_uring_params* params)
+{
+    auto rv = ::syscall(__NR_io_uring_setup, entries, params);
+    if (rv < 0)
+        return Error::from_errno();
+    return (int)rv;
+}
+
+ErrorOr<u32> io_uring_enter(int fd, u32 to_submit, u32 min_complete,
+    u32 flags)
+{
+    while (true) {
+        auto rv = ::syscall(__NR_io_uring_enter, fd, to_submit,
+            min_complete, flags, nullptr, 0);
+        if (rv < 0) {
+            if (errno == EINTR)
+                continue;
+            return Error::from_errno();
+        }
+        return (u32)rv;
+    }
+}
+
+ErrorOr<void> io_uring_register(int fd, u32 opcode,
+    void const* argument, u32 count)
+{
+    auto rv = ::syscall(__NR_io_uring_register, fd, opcode,
+        argument, count);
+    if (rv < 0)
+        return Error::from_errno();
+    return {};
+}
+
+ErrorOr<u32> getdents64(int fd, void* buffer, u32 size)
+{
+    auto rv = ::syscall(SYS_getdents64, fd, buffer, size);
+    if (rv < 0)
+        return Error::from_errno();
+    return (u32)rv;
+}
+
+ErrorOr<struct statx> statx(int directory_fd, c_string path,
+    int flags, u32 mask)
+{
+    struct statx buf;
+    auto rv = ::statx(directory_fd, path, flags, mask, &buf);
+    if (rv < 0)
+        return Error::from_errno();
+    return buf;
+}
+
+ErrorOr<int> memfd_create(c_string name, u32 flags)
+{
+    auto rv = ::memfd_create(name, flags);
+    if (rv < 0)
+        return Error::from_errno();
+    return rv;
+}
+
+ErrorOr<int> epoll_create(int flags)
+{
+    auto rv = ::epoll_create1(flags);
+    if (rv < 0)
+        return Error::from_errno();
+    return rv;
+}
+
+ErrorOr<void> epoll_ctl(int epoll_fd, int operation, int fd,
+    struct epoll_event* event)
+{
+    if (::epoll_ctl(epoll_fd, operation, fd, event) < 0)
+        return Error::from_errno();
+    return {};
+}
+
+ErrorOr<u32> epoll_wait(int epoll_fd, struct epoll_event* events,
+    int max_events, int timeout_ms)
+{
+    while (true) {
+        auto rv = ::epoll_wait(epoll_fd, events, max_events,
+            timeout_ms);
+        if (rv < 0) {
+            if (errno == EINTR)
+                continue;
+            return Error::from_errno();
+        }
+        return (u32)rv;
+    }
+}
+
+#endif
+
 }
@@ -4,11 +4,18 @@
 #include "StringBuffer.h"
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
 #include <spawn.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
 #include <sys/wait.h>
+#ifdef __linux__
+#    include <linux/io_uring.h>
+#    include <sys/epoll.h>
+#endif
 
 extern "C" {
 extern char** environ;
@@ -206,6 +213,7 @@ namespace Ty::System {
 #    warning "unimplemented"
 #endif
 
+ErrorOr<usize> read(int fd, void* data, usize size);
 ErrorOr<usize> write(int fd, StringBuffer const& string);
 ErrorOr<usize> write(int fd, StringView string);
 ErrorOr<usize> write(int fd, void const* data, usize size);
@@ -217,6 +225,7 @@ ErrorOr<u8*> mmap(usize size, int prot, int flags, int fd = -1,
 ErrorOr<u8*> mmap(void* addr, usize size, int prot, int flags,
     int fd = -1, long offset = 0);
 ErrorOr<void> mprotect(void* addr, usize len, int prot);
+ErrorOr<void> madvise(void* addr, usize len, int advice);
 
 struct Stat {
     constexpr Stat(struct stat st)
@@ -236,6 +245,10 @@ struct Stat {
     }
 
     constexpr off_t size() const { return raw.st_size; }
+    constexpr i64 modified_seconds() const
+    {
+        return raw.st_mtime;
+    }
 
     struct stat raw;
 };
@@ -246,6 +259,7 @@ ErrorOr<int> mkstemps(char* template_, int suffixlen);
 ErrorOr<int> open(c_string path, int flags);
 ErrorOr<int> open(c_string path, int flags, mode_t mode);
 ErrorOr<void> close(int fd);
+ErrorOr<void> pipe(int fds[2]);
 ErrorOr<void> remove(c_string path);
 ErrorOr<void> unlink(c_string path);
 
@@ -268,16 +282,28 @@ ErrorOr<long> sysconf(int name);
 
 ErrorOr<u32> page_size();
 
+ErrorOr<struct rlimit> getrlimit(int resource);
+ErrorOr<void> setrlimit(int resource, struct rlimit limit);
+
 Optional<c_string> getenv(StringView name);
 
 ErrorOr<bool> has_program(StringView name);
 
 void sleep(u32 seconds);
+u64 monotonic_milliseconds();
 
 [[noreturn]] void exit(int code);
 
 ErrorOr<int> fork();
 
+ErrorOr<pthread_t> pthread_create(void* (*entry)(void*),
+    void* argument);
+ErrorOr<void> pthread_join(pthread_t thread);
+ErrorOr<void> pthread_detach(pthread_t thread);
+#ifdef __linux__
+ErrorOr<void> pthread_setaffinity(pthread_t thread, u32 cpu);
+#endif
+
 ErrorOr<void> sigemptyset(sigset_t* set);
 
 ErrorOr<void> sigaction(int sig,
@@ -295,6 +321,8 @@ ErrorOr<ssize_t> recv(int fd, void* buf, size_t buf_size,
 ErrorOr<ssize_t> send(int fd, void const* buf, size_t buf_size,
     int flags = 0);
 ErrorOr<ssize_t> send(int fd, StringView view, int flags = 0);
+ErrorOr<ssize_t> send(int fd, IOVec const* iovec, int count,
+    int flags = 0);
 ErrorOr<struct addrinfo*> getaddrinfo(u16 service,
     struct addrinfo hints);
 ErrorOr<struct addrinfo*> getaddrinfo(StringView name, u16 service,
@@ -302,8 +330,37 @@ ErrorOr<struct addrinfo*> getaddrinfo(StringView name, u16 service,
 ErrorOr<struct addrinfo*> getaddrinfo(StringView name,
     StringView service, struct addrinfo hints);
 ErrorOr<void> setsockopt(int fd, int level, int optname, int value);
+ErrorOr<void> setsockopt(int fd, int level, int optname,
+    void const* value, socklen_t value_size);
+ErrorOr<int> fcntl(int fd, int command, int argument = 0);
 ErrorOr<StringBuffer> inet_ntop(struct sockaddr_storage sa);
 
+// NOTE: Returns how many of fds have events, 0 on timeout.
+ErrorOr<u32> poll(struct pollfd* fds, u32 count,
+    int timeout_ms = -1);
+
+#ifdef __linux__
+ErrorOr<int> io_uring_setup(u32 entries,
+    struct io_uring_params* params);
+ErrorOr<u32> io_uring_enter(int fd, u32 to_submit, u32 min_complete,
+    u32 flags);
+ErrorOr<void> io_uring_register(int fd, u32 opcode,
+    void const* argument, u32 count);
+
+// NOTE: Fills buffer with struct dirent64 records, and returns how
+//       many bytes of it were used, 0 at the end of the directory.
+ErrorOr<u32> getdents64(int fd, void* buffer, u32 size);
+ErrorOr<struct statx> statx(int directory_fd, c_string path,
+    int flags, u32 mask);
+ErrorOr<int> memfd_create(c_string name, u32 flags);
+
+ErrorOr<int> epoll_create(int flags = 0);
+ErrorOr<void> epoll_ctl(int epoll_fd, int operation, int fd,
+    struct epoll_event* event);
+ErrorOr<u32> epoll_wait(int epoll_fd, struct epoll_event* events,
+    int max_events, int timeout_ms = -1);
+#endif
+
 }
 
 using namespace Ty;
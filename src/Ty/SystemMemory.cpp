@@ -0,0 +1,50 @@
+#include "Memory.h"
+#include "ErrorOr.h"
+
+#ifdef __GLIBC__
+#    include <malloc.h>
+#endif
+
+// NOTE: For -Dallocator=system, which leaves all of it to malloc,
+//       so tools that hook into it, like sanitizers, see it all.
+
+namespace Ty {
+
+ErrorOr<void*> allocate_memory(usize size)
+{
+    auto* ptr = __builtin_malloc(size);
+    if (!ptr)
+        return Error::from_errno();
+    return ptr;
+}
+
+ErrorOr<void*> reallocate_memory(void* ptr, usize size)
+{
+    auto* new_ptr = __builtin_realloc(ptr, size);
+    if (!new_ptr)
+        return Error::from_errno();
+    return new_ptr;
+}
+
+void free_memory(void* ptr) { __builtin_free(ptr); }
+
+// NOTE: Only what malloc tells about itself, which is nothing
+//       outside of glibc. Allocations are not counted.
+MemoryStats memory_stats()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    auto info = mallinfo2();
+    return MemoryStats {
+        .allocations = 0,
+        .frees = 0,
+        .small_bytes_in_use = 0,
+        .large_bytes_in_use = info.uordblks + info.hblkhd,
+        .cached_bytes = info.fordblks,
+        .heap_bytes = info.arena + info.hblkhd,
+    };
+#else
+    return {};
+#endif
+}
+
+}
@@ -5,6 +5,10 @@ namespace Ty {
 
 struct Threads {
     static u32 in_machine() { return Hardware::the().threads(); }
+
+    // NOTE: Where the index-th thread goes, within the CPUs this
+    //       process may run on.
+    static u32 cpu(u32 index) { return Hardware::the().cpu(index); }
 };
 
 }
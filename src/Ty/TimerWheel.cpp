@@ -0,0 +1,80 @@
+#include "TimerWheel.h"
+
+namespace Ty {
+
+void TimerWheel::schedule(Timer& timer, u64 deadline_ms)
+{
+    if (timer.is_scheduled())
+        unlink(timer);
+    auto tick = (deadline_ms + m_tick_ms - 1) / m_tick_ms;
+    if (tick <= m_now)
+        tick = m_now + 1;
+    if (tick - m_now >= max_ticks)
+        tick = m_now + max_ticks - 1;
+    timer.tick = tick;
+    insert(timer);
+    m_count++;
+}
+
+void TimerWheel::cancel(Timer& timer)
+{
+    if (timer.is_scheduled())
+        unlink(timer);
+}
+
+// NOTE: A timer goes in the finest wheel that reaches its tick. The
+//       slot it lands in comes round again before the tick does,
+//       and is emptied into the finer wheels then.
+void TimerWheel::insert(Timer& timer)
+{
+    auto delta = timer.tick - m_now;
+    u32 wheel = 0;
+    while (wheel + 1 < wheel_count
+        && delta >= 1LU << (slot_bits * (wheel + 1)))
+        wheel++;
+    auto index = (timer.tick >> (slot_bits * wheel)) & slot_mask;
+    auto slot = (u16)(wheel * slots_per_wheel + index);
+
+    timer.slot = slot;
+    timer.previous = nullptr;
+    timer.next = m_slots[slot];
+    if (timer.next != nullptr)
+        timer.next->previous = &timer;
+    m_slots[slot] = &timer;
+}
+
+void TimerWheel::unlink(Timer& timer)
+{
+    if (timer.previous != nullptr)
+        timer.previous->next = timer.next;
+    else
+        m_slots[timer.slot] = timer.next;
+    if (timer.next != nullptr)
+        timer.next->previous = timer.previous;
+    timer.next = nullptr;
+    timer.previous = nullptr;
+    timer.slot = Timer::unscheduled;
+    m_count--;
+}
+
+// NOTE: Each time a wheel turns over, the slot of the next coarser
+//       one that is now current is spread over the finer wheels.
+void TimerWheel::cascade()
+{
+    for (u32 wheel = 1; wheel < wheel_count; wheel++) {
+        auto shift = slot_bits * wheel;
+        if ((m_now & ((1LU << shift) - 1)) != 0)
+            return;
+        auto index = (m_now >> shift) & slot_mask;
+        auto slot = (u16)(wheel * slots_per_wheel + index);
+        auto* timer = m_slots[slot];
+        m_slots[slot] = nullptr;
+        while (timer != nullptr) {
+            auto* next = timer->next;
+            insert(*timer);
+            timer = next;
+        }
+    }
+}
+
+}
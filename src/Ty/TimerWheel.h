@@ -0,0 +1,108 @@
+#pragma once
+#include "Base.h"
+
+namespace Ty {
+
+// Deadlines kept in four wheels of 64 slots, each slot of a wheel
+// spanning a whole turn of the one below. Scheduling and cancelling
+// only link and unlink a timer, and advance() finds the timers due
+// by the slots it passes, not by looking at every timer. Timers
+// further out are moved to a finer wheel as their time comes near.
+//
+// Timers are embedded in whatever they time, the wheel does not own
+// them. One has to be cancelled before it goes away.
+struct TimerWheel {
+    struct Timer {
+        bool is_scheduled() const { return slot != unscheduled; }
+
+        // NOTE: Handed back on expiry, to tell timers apart.
+        u32 owner { 0 };
+
+    private:
+        friend TimerWheel;
+        static constexpr u16 unscheduled = 0xFFFF;
+
+        Timer* next { nullptr };
+        Timer* previous { nullptr };
+        u64 tick { 0 };
+        u16 slot { unscheduled };
+    };
+
+    // NOTE: Deadlines are rounded up to whole ticks, so timers
+    //       expire up to one tick late, never early.
+    TimerWheel(u32 tick_ms, u64 now_ms)
+        : m_tick_ms(tick_ms)
+        , m_now(now_ms / tick_ms)
+    {
+    }
+
+    // NOTE: Timers stay where they are embedded, only the heads of
+    //       their lists move. The wheel moved from is left empty.
+    TimerWheel(TimerWheel&& other)
+        : m_tick_ms(other.m_tick_ms)
+        , m_count(other.m_count)
+        , m_now(other.m_now)
+    {
+        for (u32 slot = 0; slot < slots_per_wheel * wheel_count;
+             slot++) {
+            m_slots[slot] = other.m_slots[slot];
+            other.m_slots[slot] = nullptr;
+        }
+        other.m_count = 0;
+    }
+
+    TimerWheel(TimerWheel const&) = delete;
+    TimerWheel& operator=(TimerWheel const&) = delete;
+
+    // NOTE: Reschedules the timer if it already is. Deadlines past
+    //       the furthest wheel, about 16.7M ticks out, are clamped.
+    void schedule(Timer& timer, u64 deadline_ms);
+    void cancel(Timer& timer);
+
+    // NOTE: Calls on_expired with every timer due by now_ms, which
+    //       is unscheduled by then and free to be scheduled again.
+    template <typename F>
+    void advance(u64 now_ms, F on_expired)
+    {
+        auto target = now_ms / m_tick_ms;
+        if (m_count == 0) {
+            if (target > m_now)
+                m_now = target;
+            return;
+        }
+        while (m_now < target) {
+            m_now++;
+            cascade();
+            auto slot = (u16)(m_now & slot_mask);
+            while (auto* timer = m_slots[slot]) {
+                unlink(*timer);
+                on_expired(*timer);
+            }
+        }
+    }
+
+    bool is_empty() const { return m_count == 0; }
+    u32 size() const { return m_count; }
+    u32 tick_ms() const { return m_tick_ms; }
+
+private:
+    static constexpr u32 slot_bits = 6;
+    static constexpr u32 slots_per_wheel = 1 << slot_bits;
+    static constexpr u64 slot_mask = slots_per_wheel - 1;
+    static constexpr u32 wheel_count = 4;
+    static constexpr u64 max_ticks = 1LU
+        << (slot_bits * wheel_count);
+
+    void insert(Timer& timer);
+    void unlink(Timer& timer);
+    void cascade();
+
+    Timer* m_slots[slots_per_wheel * wheel_count] {};
+    u32 m_tick_ms { 0 };
+    u32 m_count { 0 };
+    u64 m_now { 0 };
+};
+
+}
+
+using Ty::TimerWheel; // NOLINT
@@ -1,4 +1,5 @@
 #pragma once
+#include "Arena.h"
 #include "Base.h"
 #include "ErrorOr.h"
 #include "Id.h"
@@ -31,6 +32,17 @@ struct Vector {
         };
     }
 
+    // NOTE: Grows into the arena, which takes it back on reset().
+    static ErrorOr<Vector<T>> create(Arena& arena,
+        u32 starting_capacity = inline_capacity)
+    {
+        auto vector = Vector();
+        vector.m_arena = &arena;
+        if (starting_capacity > inline_capacity)
+            TRY(vector.expand(starting_capacity));
+        return vector;
+    }
+
     constexpr Vector()
         : m_capacity(inline_capacity)
     {
@@ -40,6 +52,7 @@ struct Vector {
         : m_data(other.m_data)
         , m_size(other.m_size)
         , m_capacity(other.m_capacity)
+        , m_arena(other.m_arena)
     {
         if (!other.is_hydrated()) {
             for (u32 i = 0; i < m_size; i++) {
@@ -51,11 +64,20 @@ struct Vector {
         other.invalidate();
     }
 
+    constexpr Vector& operator=(Vector&& other)
+    {
+        if (this == &other)
+            return *this;
+        this->~Vector();
+        new (this) Vector(move(other));
+        return *this;
+    }
+
     constexpr ~Vector()
     {
         if (is_valid()) {
             destroy_elements();
-            if (is_hydrated())
+            if (is_hydrated() && m_arena == nullptr)
                 free_memory(m_data);
             invalidate();
         }
@@ -201,6 +223,41 @@ struct Vector {
     constexpr T const& last() const { return data()[m_size - 1]; }
     constexpr T& last() { return data()[m_size - 1]; }
 
+    constexpr T take_last()
+    {
+        VERIFY(!is_empty());
+        T value = move(last());
+        last().~T();
+        m_size--;
+        return value;
+    }
+
+    // NOTE: Drops the elements should_remove(index) is true for.
+    //       The rest keep their order, and move down into the gaps.
+    template <typename F>
+    constexpr void remove_if(F should_remove)
+    {
+        u32 kept = 0;
+        for (u32 i = 0; i < m_size; i++) {
+            if (should_remove(i)) {
+                data()[i].~T();
+                continue;
+            }
+            if (kept != i) {
+                new (&data()[kept]) T(move(data()[i]));
+                data()[i].~T();
+            }
+            kept++;
+        }
+        m_size = kept;
+    }
+
+    constexpr void clear()
+    {
+        destroy_elements();
+        m_size = 0;
+    }
+
     ALWAYS_INLINE constexpr u32 size() const { return m_size; }
 
     constexpr bool is_empty() const { return m_size == 0; }
@@ -219,7 +276,7 @@ private:
 
     ErrorOr<void> expand_hydrate(u32 capacity)
     {
-        auto* data = (T*)TRY(allocate_memory(capacity * sizeof(T)));
+        auto* data = (T*)TRY(allocate(capacity * sizeof(T)));
         __builtin_memcpy(data, inline_buffer(), storage_size());
         m_capacity = capacity;
         m_data = data;
@@ -227,6 +284,13 @@ private:
         return {};
     }
 
+    ErrorOr<void*> allocate(usize size)
+    {
+        if (m_arena != nullptr)
+            return TRY(m_arena->allocate(size, alignof(T)));
+        return TRY(allocate_memory(size));
+    }
+
     ALWAYS_INLINE constexpr bool is_hydrated() const
     {
         return m_data != nullptr;
@@ -238,8 +302,13 @@ private:
             TRY(expand_hydrate(capacity));
             return {};
         }
-        m_data = (T*)TRY(
-            reallocate_memory(m_data, capacity * sizeof(T)));
+        if (m_arena != nullptr) {
+            m_data = (T*)TRY(m_arena->reallocate(m_data,
+                m_capacity * sizeof(T), capacity * sizeof(T)));
+        } else {
+            m_data = (T*)TRY(
+                reallocate_memory(m_data, capacity * sizeof(T)));
+        }
         m_capacity = capacity;
 
         return {};
@@ -297,6 +366,7 @@ private:
     T* m_data { nullptr };
     u32 m_size { 0 };
     u32 m_capacity { 0 };
+    Arena* m_arena { nullptr };
 };
 
 }
@@ -0,0 +1,310 @@
+#include "Compressor.h"
+#include <Core/Thread.h>
+#include <Ty/Defer.h>
+#include <Ty/Deflate.h>
+#include <Ty/Memory.h>
+#include <Ty/New.h>
+#include <Ty/StringBuffer.h>
+#include <Ty/System.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#    include <sys/mman.h>
+#endif
+
+namespace Web {
+
+namespace {
+
+// NOTE: Unnamed, so it goes away with the last descriptor, and
+//       compressed files can be sent with sendfile(2) like plain
+//       ones.
+ErrorOr<int> create_anonymous_file()
+{
+#ifdef __linux__
+    return TRY(System::memfd_create("dory-gzip", MFD_CLOEXEC));
+#else
+    char path[] = "/tmp/dory-gzip-XXXXXX";
+    auto fd = TRY(System::mkstemps(path));
+    System::unlink(path).ignore();
+    return fd;
+#endif
+}
+
+ErrorOr<void> write_all(int fd, StringView contents)
+{
+    while (!contents.is_empty()) {
+        auto written = TRY(System::write(fd, contents));
+        contents = contents.shrink_from_start(written);
+    }
+    return {};
+}
+
+}
+
+ErrorOr<CompressedFile*> CompressedFile::create(
+    Core::MappedFile&& file, Encoding encoding, MimeType mime_type,
+    StringView charset, StringView etag, HTTP::Date last_modified)
+{
+    auto* memory = TRY(allocate_memory(sizeof(CompressedFile)));
+    auto* compressed = new (memory) CompressedFile(-1, encoding,
+        mime_type, charset, etag, last_modified);
+    compressed->m_file = move(file);
+    compressed->m_references = 1;
+    compressed->m_state = State::Ready;
+    auto rendered = compressed->render_headers();
+    if (rendered.is_error()) {
+        compressed->release();
+        return rendered.release_error();
+    }
+    return compressed;
+}
+
+CompressedFile::CompressedFile(int source_fd, Encoding encoding,
+    MimeType mime_type, StringView charset, StringView etag,
+    HTTP::Date last_modified)
+    : m_source_fd(source_fd)
+    , m_encoding(encoding)
+    , m_mime_type(mime_type)
+    , m_charset(charset)
+    , m_last_modified(last_modified)
+{
+    auto inner = etag.shrink(1);
+    for (u32 i = 0; i < inner.size; i++)
+        m_etag_storage[m_etag_size++] = inner[i];
+    m_source_etag_size = m_etag_size;
+    m_etag_storage[m_etag_size++] = '-';
+    for (u32 i = 0; i < coding().size; i++)
+        m_etag_storage[m_etag_size++] = coding()[i];
+    m_etag_storage[m_etag_size++] = '"';
+}
+
+CompressedFile::~CompressedFile()
+{
+    if (m_source_fd != -1)
+        System::close(m_source_fd).ignore();
+}
+
+StringView CompressedFile::coding() const
+{
+    switch (m_encoding) {
+    case Encoding::Gzip:
+        return "gzip"sv;
+    case Encoding::Brotli:
+        return "br"sv;
+    }
+}
+
+void CompressedFile::retain()
+{
+    __atomic_add_fetch(&m_references, 1, __ATOMIC_RELAXED);
+}
+
+bool CompressedFile::is_unused() const
+{
+    return __atomic_load_n(&m_references, __ATOMIC_ACQUIRE) == 1;
+}
+
+bool CompressedFile::is_for(MimeType mime_type,
+    StringView charset, StringView etag,
+    HTTP::Date last_modified) const
+{
+    return m_mime_type == mime_type && m_charset == charset
+        && source_etag() == etag.shrink(1)
+        && m_last_modified.seconds == last_modified.seconds;
+}
+
+void CompressedFile::release()
+{
+    if (__atomic_sub_fetch(&m_references, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+    this->~CompressedFile();
+    free_memory(this);
+}
+
+void CompressedFile::compress()
+{
+    // NOTE: Everything but the compressor let go while this was
+    //       queued, so nobody would ever send the result.
+    auto state = State::Failed;
+    if (__atomic_load_n(&m_references, __ATOMIC_ACQUIRE) > 1) {
+        if (!try_compress().is_error())
+            state = State::Ready;
+    }
+    __atomic_store_n(&m_state, state, __ATOMIC_RELEASE);
+}
+
+ErrorOr<void> CompressedFile::try_compress()
+{
+    auto source_fd = m_source_fd;
+    m_source_fd = -1;
+    auto source = TRY(Core::MappedFile::map(source_fd));
+    auto compressed = TRY(Deflate::gzip(source.view()));
+    if (compressed.size() >= source.view().size)
+        return Error::from_string_literal("file did not shrink");
+
+    auto fd = TRY(create_anonymous_file());
+    auto written = write_all(fd,
+        StringView(compressed.data(), compressed.size()));
+    if (written.is_error()) {
+        System::close(fd).ignore();
+        return written.release_error();
+    }
+    m_file = TRY(Core::MappedFile::map(fd));
+    TRY(render_headers());
+    return {};
+}
+
+ErrorOr<void> CompressedFile::render_headers()
+{
+    auto buffer = StringBuffer();
+    TRY(buffer.write("Content-Type: "sv, m_mime_type));
+    if (!m_charset.is_empty())
+        TRY(buffer.write("; charset="sv, m_charset));
+    TRY(buffer.write("\r\nContent-Length: "sv, view().size,
+        "\r\nContent-Encoding: "sv, coding(), "\r\n"sv));
+    auto validators_start = buffer.size();
+    TRY(buffer.write("Vary: Accept-Encoding\r\nETag: "sv));
+    auto etag_start = buffer.size();
+    TRY(buffer.write(StringView(m_etag_storage, m_etag_size)));
+    TRY(buffer.write("\r\nLast-Modified: "sv, m_last_modified,
+        "\r\nServer: Dory\r\n"sv));
+
+    auto stored = TRY(Vector<char>::create(buffer.size()));
+    for (auto character : buffer)
+        stored.unchecked_append(character);
+    m_headers = move(stored);
+    m_etag = headers().sub_view(etag_start, m_etag_size);
+    m_validator_headers = headers().shrink_from_start(
+        validators_start);
+    return {};
+}
+
+Compressor* Compressor::the()
+{
+    static Compressor* const compressor = [] {
+        auto compressor = create();
+        if (compressor.is_error())
+            return (Compressor*)nullptr;
+        return compressor.release_value();
+    }();
+    return compressor;
+}
+
+ErrorOr<Compressor*> Compressor::create()
+{
+    int jobs[2];
+    TRY(System::pipe(jobs));
+    TRY(System::fcntl(jobs[1], F_SETFL, O_NONBLOCK));
+    auto copies = TRY(Copies::create());
+    auto* memory = TRY(allocate_memory(sizeof(Compressor)));
+    auto* compressor = new (memory)
+        Compressor(jobs[0], jobs[1], move(copies));
+    auto thread = TRY(Core::Thread::spawn([compressor] {
+        compressor->run();
+    }));
+    TRY(thread.detach());
+    return compressor;
+}
+
+ErrorOr<CompressedFile*> Compressor::compress(int fd,
+    MimeType mime_type, StringView charset, StringView etag,
+    HTTP::Date last_modified)
+{
+    if (__atomic_load_n(&m_is_backed_up, __ATOMIC_RELAXED))
+        return nullptr;
+
+    pthread_mutex_lock(&m_copies_lock);
+    Defer unlock = [&] {
+        pthread_mutex_unlock(&m_copies_lock);
+    };
+    auto id = m_copies.find(etag.shrink(1));
+    if (id.has_value()) {
+        auto* copy = m_copies[id.value()];
+        if (copy->is_for(mime_type, charset, etag, last_modified)) {
+            copy->retain();
+            return copy;
+        }
+    }
+
+    if (m_copies.size() >= m_sweep_at) {
+        TRY(drop_unused_copies());
+        m_sweep_at = m_copies.size() * 2;
+        if (m_sweep_at < 64)
+            m_sweep_at = 64;
+    }
+    auto* file = TRY(queue(fd, mime_type, charset, etag,
+        last_modified));
+    if (file == nullptr)
+        return nullptr;
+    // NOTE: Files with the same contents but other headers, like
+    //       another type, get a copy of their own.
+    if (id.has_value())
+        return file;
+    // NOTE: The list's reference keeps queued copies wanted even if
+    //       their file lets go, as it may come back for them.
+    file->retain();
+    if (m_copies.append(file->source_etag(), file).is_error())
+        file->release();
+    return file;
+}
+
+// NOTE: Copies only the list still holds are done with, as it is
+//       the only way to get to them.
+ErrorOr<void> Compressor::drop_unused_copies()
+{
+    TRY(m_copies.remove_if([&](auto id) {
+        auto* copy = m_copies[id];
+        if (!copy->is_unused())
+            return false;
+        // NOTE: The key is not looked at again.
+        copy->release();
+        return true;
+    }));
+    return {};
+}
+
+ErrorOr<CompressedFile*> Compressor::queue(int fd,
+    MimeType mime_type, StringView charset, StringView etag,
+    HTTP::Date last_modified)
+{
+    auto source_fd = TRY(System::fcntl(fd, F_DUPFD_CLOEXEC));
+    auto memory = allocate_memory(sizeof(CompressedFile));
+    if (memory.is_error()) {
+        System::close(source_fd).ignore();
+        return memory.release_error();
+    }
+    auto* file = new (memory.release_value())
+        CompressedFile(source_fd, Encoding::Gzip, mime_type,
+            charset, etag, last_modified);
+
+    // NOTE: Pointers are written whole, pipes never split writes
+    //       smaller than PIPE_BUF.
+    auto rv = ::write(m_jobs_write, &file, sizeof(file));
+    if (rv < 0) {
+        auto error = errno;
+        file->~CompressedFile();
+        free_memory(file);
+        if (error != EAGAIN)
+            return Error::from_errno(error);
+        __atomic_store_n(&m_is_backed_up, true, __ATOMIC_RELAXED);
+        return nullptr;
+    }
+    return file;
+}
+
+void Compressor::run()
+{
+    while (true) {
+        CompressedFile* file = nullptr;
+        auto bytes = System::read(m_jobs_read, &file, sizeof(file));
+        if (bytes.is_error() || bytes.value() != sizeof(file))
+            continue;
+        __atomic_store_n(&m_is_backed_up, false, __ATOMIC_RELAXED);
+        file->compress();
+        file->release();
+    }
+}
+
+}
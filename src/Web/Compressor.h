@@ -0,0 +1,158 @@
+#pragma once
+#include "MimeType.h"
+#include <Core/MappedFile.h>
+#include <HTTP/Date.h>
+#include <Ty/ErrorOr.h>
+#include <Ty/HashMap.h>
+#include <Ty/StringView.h>
+#include <Ty/Vector.h>
+#include <pthread.h>
+
+namespace Web {
+
+enum class Encoding : u8 {
+    Gzip,
+    Brotli,
+};
+
+// A compressed copy of a file, and the headers to send it with.
+// Copies made at runtime are gzip encoded on the compressor thread,
+// while the file they were made from keeps serving its plain
+// contents. Those are shared by every file with the same contents,
+// and held by them, the compressor and its list of copies, the
+// last to let go frees it.
+struct CompressedFile {
+    // NOTE: For copies compressed ahead of time, which are ready
+    //       right away and only held by their file.
+    static ErrorOr<CompressedFile*> create(Core::MappedFile&& file,
+        Encoding, MimeType, StringView charset, StringView etag,
+        HTTP::Date last_modified);
+
+    bool is_ready() const
+    {
+        return __atomic_load_n(&m_state, __ATOMIC_ACQUIRE)
+            == State::Ready;
+    }
+
+    // NOTE: Only valid once is_ready().
+    StringView view() const { return m_file.view(); }
+    int fd() const { return m_file.fd(); }
+    StringView headers() const
+    {
+        return StringView(m_headers.data(), m_headers.size());
+    }
+    StringView validator_headers() const
+    {
+        return m_validator_headers;
+    }
+    StringView etag() const { return m_etag; }
+
+    Encoding encoding() const { return m_encoding; }
+
+    // NOTE: The name of the encoding in Accept-Encoding and
+    //       Content-Encoding.
+    StringView coding() const;
+
+    void release();
+
+private:
+    friend struct Compressor;
+
+    void retain();
+    bool is_unused() const;
+    bool is_for(MimeType, StringView charset, StringView etag,
+        HTTP::Date last_modified) const;
+
+    // NOTE: The ETag of the file compressed, less the closing
+    //       quote, which starts the copy's own.
+    StringView source_etag() const
+    {
+        return StringView(m_etag_storage, m_source_etag_size);
+    }
+
+    enum class State : u8 {
+        Pending,
+        Ready,
+        Failed,
+    };
+
+    CompressedFile(int source_fd, Encoding, MimeType,
+        StringView charset, StringView etag,
+        HTTP::Date last_modified);
+    ~CompressedFile();
+
+    void compress();
+    ErrorOr<void> try_compress();
+    ErrorOr<void> render_headers();
+
+    int m_source_fd;
+    Encoding m_encoding;
+    MimeType m_mime_type;
+    StringView m_charset;
+    HTTP::Date m_last_modified;
+
+    Core::MappedFile m_file {};
+    Vector<char> m_headers {};
+    StringView m_etag {};
+    StringView m_validator_headers {};
+
+    // NOTE: The plain file's ETag with the coding added inside the
+    //       quotes, as the two are different representations.
+    //       Plain ones are at most 35 characters.
+    char m_etag_storage[48];
+    u32 m_etag_size { 0 };
+    u32 m_source_etag_size { 0 };
+
+    u32 m_references { 2 };
+    State m_state { State::Pending };
+};
+
+// One thread for the whole process, compressing files in the
+// order they were asked for. Files with the same contents are only
+// compressed once.
+struct Compressor {
+    // NOTE: Started on first use, null if that failed.
+    static Compressor* the();
+
+    // NOTE: fd is duplicated, so the file may be reloaded or closed
+    //       before its turn comes. The result starts out pending,
+    //       unless one for the same ETag was asked for before.
+    //       Null while the compressor is too far behind to take
+    //       more, the file is sent as is until asked for again.
+    ErrorOr<CompressedFile*> compress(int fd, MimeType,
+        StringView charset, StringView etag,
+        HTTP::Date last_modified);
+
+private:
+    // NOTE: Keyed by CompressedFile::source_etag().
+    using Copies = HashMap<StringView, CompressedFile*>;
+
+    static ErrorOr<Compressor*> create();
+
+    Compressor(int jobs_read, int jobs_write, Copies&& copies)
+        : m_jobs_read(jobs_read)
+        , m_jobs_write(jobs_write)
+        , m_copies(move(copies))
+    {
+    }
+
+    ErrorOr<CompressedFile*> queue(int fd, MimeType,
+        StringView charset, StringView etag,
+        HTTP::Date last_modified);
+    ErrorOr<void> drop_unused_copies();
+
+    [[noreturn]] void run();
+
+    int m_jobs_read;
+
+    // NOTE: Non-blocking, so a full pipe turns jobs away rather
+    //       than stall the worker, and every other one on the lock.
+    int m_jobs_write;
+    bool m_is_backed_up { false };
+
+    pthread_mutex_t m_copies_lock = PTHREAD_MUTEX_INITIALIZER;
+    Copies m_copies;
+    u32 m_sweep_at { 64 };
+};
+
+}
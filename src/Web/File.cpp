@@ -1,73 +1,227 @@
 #include "File.h"
 #include <Core/MappedFile.h>
+#include <Ty/Hash.h>
+#include <Ty/System.h>
 
 namespace Web {
 
+namespace {
+
+// NOTE: Writes value as lower case hex into to, which has to have
+//       room for 16 characters, and returns how many it used.
+u32 write_hex(char* to, u64 value)
+{
+    char digits[16];
+    u32 count = 0;
+    do {
+        digits[count++] = "0123456789abcdef"[value & 0xF];
+        value >>= 4;
+    } while (value != 0);
+    for (u32 i = 0; i < count; i++)
+        to[i] = digits[count - i - 1];
+    return count;
+}
+
+}
+
 ErrorOr<File> File::open(StringView path)
 {
-    return File {
-        TRY(Core::MappedFile::open(path)),
-        path,
+    auto file = unloaded(path);
+    TRY(file.reload());
+    return file;
+}
+
+StringView File::sidecar_extension(Encoding encoding)
+{
+    switch (encoding) {
+    case Encoding::Gzip:
+        return ".gz"sv;
+    case Encoding::Brotli:
+        return ".br"sv;
+    }
+}
+
+Optional<StringView> File::sidecar_owner(StringView path)
+{
+    Encoding const encodings[] = {
+        Encoding::Gzip,
+        Encoding::Brotli,
     };
+    for (auto encoding : encodings) {
+        auto extension = sidecar_extension(encoding);
+        if (path.ends_with(extension))
+            return path.shrink(extension.size);
+    }
+    return {};
 }
 
 File::File(Core::MappedFile&& file, StringView path)
     : m_file(move(file))
     , m_path(path)
+    , m_mime_type(MimeType::from_path(path))
 {
 }
 
 ErrorOr<void> File::reload()
 {
     m_file = TRY(Core::MappedFile::open(m_path));
+    release_encodings();
+    auto stat = TRY(System::fstat(m_file.fd()));
+    m_last_modified = HTTP::Date { stat.modified_seconds() };
+
+    auto brotli = open_sidecar(Encoding::Brotli);
+    auto gzip = open_sidecar(Encoding::Gzip);
+    TRY(render_headers(!brotli.is_error() || !gzip.is_error()
+        || is_worth_compressing()));
+
+    m_brotli = adopt_sidecar(move(brotli), Encoding::Brotli);
+    m_gzip = adopt_sidecar(move(gzip), Encoding::Gzip);
+    if (m_gzip == nullptr)
+        compress_in_background();
     return {};
 }
 
-StringView File::charset() const
+void File::unload()
 {
-    switch(mime_type().type()) {
-    case MimeType::ApplicationJson:
-        return "utf-8"sv;
-    case MimeType::ApplicationOctetStream:
-        return ""sv;
-    case MimeType::ImageIco:
-        return ""sv;
-    case MimeType::ImagePng:
-        return ""sv;
-    case MimeType::TextCss:
-        return "utf-8"sv;
-    case MimeType::TextHtml:
-        return "utf-8"sv;
-    case MimeType::TextJavascript:
-        return "utf-8"sv;
-    case MimeType::TextMarkdown:
-        return "utf-8"sv;
-    case MimeType::TextPlain:
-        return "utf-8"sv;
+    m_file = Core::MappedFile();
+    m_headers.clear();
+    m_etag = ""sv;
+    m_validator_headers = ""sv;
+    release_encodings();
+    m_is_compression_deferred = false;
+}
+
+ErrorOr<void> File::render_headers(bool varies)
+{
+    auto buffer = StringBuffer();
+    TRY(buffer.write("Content-Type: "sv, mime_type()));
+    if (!charset().is_empty())
+        TRY(buffer.write("; charset="sv, charset()));
+    TRY(buffer.write("\r\nContent-Length: "sv, view().size,
+        "\r\nAccept-Ranges: bytes\r\n"sv));
+
+    // NOTE: Strong, so it goes by the contents. They are hashed
+    //       once per load, at about 0.2 ms per megabyte.
+    char etag[2 * 16 + 3];
+    u32 etag_size = 0;
+    etag[etag_size++] = '"';
+    etag_size += write_hex(etag + etag_size, view().size);
+    etag[etag_size++] = '-';
+    etag_size += write_hex(etag + etag_size,
+        content_hash(view().data, view().size));
+    etag[etag_size++] = '"';
+    auto validators_start = buffer.size();
+    if (varies)
+        TRY(buffer.write("Vary: Accept-Encoding\r\n"sv));
+    TRY(buffer.write("ETag: "sv));
+    auto etag_start = buffer.size();
+    TRY(buffer.write(StringView(etag, etag_size)));
+
+    TRY(buffer.write("\r\nLast-Modified: "sv, m_last_modified,
+        "\r\nServer: Dory\r\n"sv));
+
+    // NOTE: Kept on the heap and only as large as needed, so files
+    //       stay small, and views into it stay valid as they move.
+    auto stored = TRY(Vector<char>::create(buffer.size()));
+    for (auto character : buffer)
+        stored.unchecked_append(character);
+    m_headers = move(stored);
+    m_etag = headers().sub_view(etag_start, etag_size);
+    m_validator_headers = headers().shrink_from_start(
+        validators_start);
+    return {};
+}
+
+bool File::is_worth_compressing() const
+{
+    // NOTE: Below this, the gzip header and trailer take up most of
+    //       what could be saved.
+    return mime_type().is_compressible() && view().size >= 256;
+}
+
+CompressedFile const* File::encoded_for(
+    HTTP::Request const& request) const
+{
+    // NOTE: Ranges are of the plain file, so compressed copies only
+    //       go out when all of it is asked for.
+    if (request.has_header(HTTP::Header::Range))
+        return nullptr;
+
+    // NOTE: Brotli goes first to win ties, its copies are smaller.
+    CompressedFile const* best = nullptr;
+    u32 best_quality = 0;
+    CompressedFile const* const copies[] = { m_brotli, m_gzip };
+    for (auto const* encoded : copies) {
+        if (encoded == nullptr || !encoded->is_ready())
+            continue;
+        auto quality = request.encoding_quality(encoded->coding());
+        if (quality > best_quality) {
+            best = encoded;
+            best_quality = quality;
+        }
+    }
+    return best;
+}
+
+ErrorOr<Core::MappedFile> File::open_sidecar(
+    Encoding encoding) const
+{
+    auto path = TRY(StringBuffer::create_fill(m_path,
+        sidecar_extension(encoding), "\0"sv));
+    auto sidecar = TRY(Core::MappedFile::open(path.data()));
+    auto stat = TRY(System::fstat(sidecar.fd()));
+    if (stat.modified_seconds() < m_last_modified.seconds)
+        return Error::from_string_literal("sidecar is out of date");
+    return sidecar;
+}
+
+CompressedFile* File::adopt_sidecar(
+    ErrorOr<Core::MappedFile>&& sidecar, Encoding encoding) const
+{
+    if (sidecar.is_error())
+        return nullptr;
+    auto compressed
+        = CompressedFile::create(sidecar.release_value(), encoding,
+            mime_type(), charset(), etag(), m_last_modified);
+    if (compressed.is_error())
+        return nullptr;
+    return compressed.release_value();
+}
+
+void File::compress_in_background()
+{
+    if (!is_worth_compressing())
+        return;
+    auto* compressor = Compressor::the();
+    if (compressor == nullptr)
+        return;
+
+    // NOTE: Without a compressed copy, the file is sent as is.
+    auto gzip = compressor->compress(fd(), mime_type(), charset(),
+        etag(), last_modified());
+    if (gzip.is_error()) {
+        m_is_compression_deferred = false;
+        return;
     }
+    m_gzip = gzip.release_value();
+    m_is_compression_deferred = m_gzip == nullptr;
+}
+
+bool File::retry_compression()
+{
+    if (m_is_compression_deferred)
+        compress_in_background();
+    return m_is_compression_deferred;
 }
 
-MimeType File::mime_type() const
+void File::release_encodings()
 {
-    if (m_path.ends_with(".png"sv))
-        return MimeType::ImagePng;
-    if (m_path.ends_with(".html"sv))
-        return MimeType::TextHtml;
-    if (m_path.ends_with(".css"sv))
-        return MimeType::TextCss;
-    if (m_path.ends_with(".js"sv))
-        return MimeType::TextJavascript;
-    if (m_path.ends_with(".json"sv))
-        return MimeType::ApplicationJson;
-    if (m_path.ends_with(".ico"sv))
-        return MimeType::ImageIco;
-    if (m_path.ends_with(".map"sv))
-        return MimeType::ApplicationJson;
-    if (m_path.ends_with(".md"sv))
-        return MimeType::TextMarkdown;
-    if (m_path.ends_with(".txt"sv))
-        return MimeType::TextPlain;
-    return MimeType::ApplicationOctetStream;
+    if (m_brotli != nullptr)
+        m_brotli->release();
+    m_brotli = nullptr;
+    if (m_gzip != nullptr)
+        m_gzip->release();
+    m_gzip = nullptr;
 }
 
 }
@@ -1,7 +1,11 @@
 #pragma once
+#include "Compressor.h"
+#include "MimeType.h"
 #include <Core/MappedFile.h>
+#include <HTTP/Date.h>
+#include <HTTP/Request.h>
 #include <Ty/StringBuffer.h>
-#include "MimeType.h"
+#include <Ty/Vector.h>
 
 namespace Web {
 
@@ -9,18 +13,108 @@ struct File {
 
     static ErrorOr<File> open(StringView path);
 
+    // NOTE: Maps nothing until reload(), for files that may not be
+    //       there to map.
+    static File unloaded(StringView path)
+    {
+        return File(Core::MappedFile(), path);
+    }
+
+    File(File&& other)
+        : m_file(move(other.m_file))
+        , m_path(other.m_path)
+        , m_mime_type(other.m_mime_type)
+        , m_headers(move(other.m_headers))
+        , m_etag(other.m_etag)
+        , m_validator_headers(other.m_validator_headers)
+        , m_last_modified(other.m_last_modified)
+        , m_brotli(other.m_brotli)
+        , m_gzip(other.m_gzip)
+        , m_is_compression_deferred(other.m_is_compression_deferred)
+    {
+        other.m_brotli = nullptr;
+        other.m_gzip = nullptr;
+    }
+
+    ~File() { release_encodings(); }
+
+    // NOTE: Sidecars are copies of a file compressed ahead of time,
+    //       named like it with the extension of their encoding.
+    static StringView sidecar_extension(Encoding);
+
+    // NOTE: The path of the file that path is a sidecar of, for
+    //       foo.css.br and foo.css.gz that is foo.css.
+    static Optional<StringView> sidecar_owner(StringView path);
+
     ErrorOr<void> reload();
+    void unload();
+    bool is_loaded() const { return m_file.is_valid(); }
+
+    StringView path() const { return m_path; }
 
-    MimeType mime_type() const;
-    StringView charset() const;
+    // NOTE: Looked up once, by the extension of the path.
+    MimeType mime_type() const { return m_mime_type; }
+    StringView charset() const { return m_mime_type.charset(); }
 
     StringView view() const { return m_file.view(); }
+    int fd() const { return m_file.fd(); }
+
+    // NOTE: Headers of a response with the file as its body, all
+    //       but the status line and Connection, so they fit any
+    //       status. They are only rendered again on reloads.
+    StringView headers() const
+    {
+        return StringView(m_headers.data(), m_headers.size());
+    }
+
+    // NOTE: The part of headers() after the ones describing the
+    //       body, Vary, ETag, Last-Modified and Server. For
+    //       responses that send less than the whole file.
+    StringView validator_headers() const
+    {
+        return m_validator_headers;
+    }
+
+    StringView etag() const { return m_etag; }
+    HTTP::Date last_modified() const { return m_last_modified; }
+
+    // NOTE: The compressed copy the client likes best, going by
+    //       Accept-Encoding, or null to send the file as it is.
+    //       Copies come from sidecars compressed ahead of time,
+    //       foo.css.br and foo.css.gz, or gzip is done here once
+    //       the compressor gets to the file.
+    CompressedFile const* encoded_for(
+        HTTP::Request const& request) const;
+
+    // NOTE: Asks the compressor again if it was too busy when the
+    //       file was loaded, returns whether it still is.
+    bool retry_compression();
 
 private:
     File(Core::MappedFile&& file, StringView path);
 
+    // NOTE: Vary is sent when the file has compressed copies, or
+    //       will have one.
+    ErrorOr<void> render_headers(bool varies);
+
+    ErrorOr<Core::MappedFile> open_sidecar(Encoding) const;
+    CompressedFile* adopt_sidecar(ErrorOr<Core::MappedFile>&&,
+        Encoding) const;
+
+    bool is_worth_compressing() const;
+    void compress_in_background();
+    void release_encodings();
+
     Core::MappedFile m_file;
     StringView m_path;
+    MimeType m_mime_type;
+    Vector<char> m_headers;
+    StringView m_etag;
+    StringView m_validator_headers;
+    HTTP::Date m_last_modified;
+    CompressedFile* m_brotli { nullptr };
+    CompressedFile* m_gzip { nullptr };
+    bool m_is_compression_deferred { false };
 };
 
 }
@@ -1,14 +1,57 @@
 #include "FileRouter.h"
 #include "Ty/StringBuffer.h"
 #include <Core/MappedFile.h>
+#include <Ty/Defer.h>
 #include <Ty/System.h>
 #if __linux__
+#include <dirent.h>
+#include <fcntl.h>
 #include <sys/inotify.h>
 #endif
 #include <unistd.h>
 
 namespace Web {
 
+#if __linux__
+namespace {
+
+constexpr u32 directory_buffer_size = 32 * 1024;
+
+constexpr u32 directory_events = IN_CREATE | IN_DELETE | IN_MODIFY
+    | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF
+    | IN_MOVE_SELF | IN_ONLYDIR;
+
+// NOTE: The path itself counts as below it.
+bool is_below(StringView path, StringView directory)
+{
+    if (!path.starts_with(directory))
+        return false;
+    return path.size == directory.size
+        || path[directory.size] == '/';
+}
+
+// NOTE: Some file systems leave the type out. Symbolic links are
+//       only followed to regular files, so they cannot make loops.
+u8 entry_type(int directory_fd, struct dirent64 const* entry)
+{
+    if (entry->d_type != DT_UNKNOWN && entry->d_type != DT_LNK)
+        return entry->d_type;
+    auto flags = entry->d_type == DT_LNK ? 0 : AT_SYMLINK_NOFOLLOW;
+    auto result = System::statx(directory_fd, entry->d_name, flags,
+        STATX_TYPE);
+    if (result.is_error())
+        return DT_UNKNOWN;
+    auto mode = result.release_value().stx_mode;
+    if (S_ISREG(mode))
+        return DT_REG;
+    if (S_ISDIR(mode) && entry->d_type == DT_UNKNOWN)
+        return DT_DIR;
+    return DT_UNKNOWN;
+}
+
+}
+#endif
+
 ErrorOr<FileRouter> FileRouter::create()
 {
 #if __linux__
@@ -22,6 +65,7 @@ ErrorOr<FileRouter> FileRouter::create()
         TRY(StaticRoutes::create()),
         TRY(Files::create()),
         TRY(WatchFileMap::create()),
+        TRY(WatchDirectoryMap::create()),
 #if __linux__
         filewatch_fd,
 #else
@@ -33,67 +77,438 @@ ErrorOr<FileRouter> FileRouter::create()
 void FileRouter::destroy() const
 {
     System::close(m_filewatch_fd).ignore();
+    for (auto* path : m_paths)
+        free_memory(path);
 }
 
 ErrorOr<void> FileRouter::add_route(StringView route,
     StringView filename)
 {
-    TRY(m_static_routes.append(route, filename));
-    TRY(m_files.append(filename, TRY(File::open(filename))));
+    TRY(m_static_routes.append(route, TRY(add_file(filename))));
+    return {};
+}
+
+ErrorOr<Id<File>> FileRouter::add_file(StringView path)
+{
+    if (auto id = m_files.find(path); id.has_value())
+        return id.value();
+    auto id = TRY(m_files.append(path, TRY(File::open(path))));
 
-    auto name_buf
-        = TRY(StringBuffer::create_fill(filename, "\0"sv));
+    auto name_buf = TRY(StringBuffer::create_fill(path, "\0"sv));
 #if __linux__
     auto watch_file = inotify_add_watch(m_filewatch_fd,
         name_buf.data(), IN_MODIFY);
     if (watch_file < 0) {
         return Error::from_errno();
     }
-    TRY(m_watch_file_map.append(watch_file, filename));
+    TRY(m_watch_file_map.append(watch_file, id));
+
+    // NOTE: Sidecars are read with their file, so it is reloaded
+    //       when they change too. Ones that do not exist yet are
+    //       only picked up once the file itself changes.
+    Encoding const encodings[] = {
+        Encoding::Brotli,
+        Encoding::Gzip,
+    };
+    for (auto encoding : encodings) {
+        auto sidecar = TRY(StringBuffer::create_fill(path,
+            File::sidecar_extension(encoding), "\0"sv));
+        auto watch_sidecar = inotify_add_watch(m_filewatch_fd,
+            sidecar.data(), IN_MODIFY);
+        if (watch_sidecar >= 0)
+            TRY(m_watch_file_map.append(watch_sidecar, id));
+    }
 #endif
+    return id;
+}
+
+ErrorOr<void> FileRouter::add_folder(StringView folder)
+{
+#if __linux__
+    TRY(add_directory(folder, folder.size));
+    return {};
+#else
+    (void)folder;
+    return Error::from_string_literal(
+        "routing folders is only supported on Linux");
+#endif
+}
+
+#if __linux__
+ErrorOr<void> FileRouter::add_directory(StringView path,
+    u32 route_start)
+{
+    auto* buffer
+        = (char*)TRY(allocate_memory(directory_buffer_size));
+    Defer free_buffer = [&] {
+        free_memory(buffer);
+    };
+
+    // NOTE: Directories are walked one at a time from this list,
+    //       so deep trees do not need deep recursion.
+    auto pending = TRY(Vector<StringView>::create());
+    TRY(pending.append(path));
+    while (!pending.is_empty()) {
+        auto directory = pending.take_last();
+        auto directory_z
+            = TRY(StringBuffer::create_fill(directory, "\0"sv));
+        auto fd = TRY(System::open(directory_z.data(),
+            O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        Defer close_directory = [&] {
+            System::close(fd).ignore();
+        };
+        TRY(watch_directory(directory_z.data(), directory,
+            route_start));
+
+        while (true) {
+            auto size = TRY(System::getdents64(fd, buffer,
+                directory_buffer_size));
+            if (size == 0)
+                break;
+            for (u32 offset = 0; offset < size;) {
+                auto const* entry
+                    = (struct dirent64 const*)(buffer + offset);
+                offset += entry->d_reclen;
+                auto name
+                    = StringView::from_c_string(entry->d_name);
+                // NOTE: This skips "." and ".." as well.
+                if (name.starts_with("."sv))
+                    continue;
+                auto type = entry_type(fd, entry);
+                if (type == DT_DIR) {
+                    TRY(pending.append(
+                        TRY(store_path(directory, name))));
+                } else if (type == DT_REG) {
+                    TRY(add_folder_file(
+                        TRY(store_path(directory, name)),
+                        route_start));
+                }
+            }
+        }
+    }
+    return {};
+}
+
+ErrorOr<void> FileRouter::add_folder_file(StringView path,
+    u32 route_start)
+{
+    // NOTE: A directory can be walked again when it is moved back.
+    if (auto id = m_files.find(path); id.has_value()) {
+        reload_file(id.value()).ignore();
+        return {};
+    }
+    auto id = TRY(m_files.append(path, File::unloaded(path)));
+    reload_file(id).ignore();
+    auto route = path.shrink_from_start(route_start);
+    TRY(m_static_routes.append(route, id));
+
+    auto index = "/index.html"sv;
+    if (route.ends_with(index)) {
+        TRY(m_static_routes.append(route.shrink(index.size - 1),
+            id));
+    }
+    return {};
+}
+
+ErrorOr<void> FileRouter::watch_directory(c_string path_z,
+    StringView path, u32 route_start)
+{
+    auto watch = inotify_add_watch(m_filewatch_fd, path_z,
+        directory_events);
+    if (watch < 0)
+        return Error::from_errno();
+    // NOTE: Watching the same directory again gives the same
+    //       descriptor back.
+    if (m_watched_directories.find(watch).has_value())
+        return {};
+    TRY(m_watched_directories.append(watch,
+        WatchedDirectory {
+            .path = path,
+            .route_start = route_start,
+        }));
+    return {};
+}
+
+ErrorOr<void> FileRouter::handle_directory_event(
+    WatchedDirectory directory, u32 mask, StringView name,
+    Core::File& log)
+{
+    // NOTE: Directories removed or moved below a watched one are
+    //       told of by it as well, whichever comes first wins.
+    if ((mask & (IN_DELETE_SELF | IN_MOVE_SELF)) != 0) {
+        TRY(remove_directory(directory.path, log));
+        return {};
+    }
+    if (name.is_empty() || name.starts_with("."sv))
+        return {};
+    auto path_buffer = TRY(
+        StringBuffer::create_fill(directory.path, "/"sv, name));
+    auto path = path_buffer.view();
+
+    auto appeared = (mask & (IN_CREATE | IN_MOVED_TO)) != 0;
+    if ((mask & IN_ISDIR) != 0) {
+        if (appeared) {
+            log.writeln("adding \""sv, path, "\""sv).ignore();
+            TRY(add_directory(TRY(store_path(directory.path, name)),
+                directory.route_start));
+        } else if ((mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+            TRY(remove_directory(path, log));
+        }
+        return {};
+    }
+
+    // NOTE: A file is mapped again along with its sidecars.
+    if (auto owner = File::sidecar_owner(path); owner.has_value()) {
+        if (auto id = m_files.find(owner.value()); id.has_value())
+            TRY(schedule_reload(id.value()));
+    }
+
+    // NOTE: Removed files are not found from here on, but keep
+    //       their routes in case they come back.
+    if (auto id = m_files.find(path); id.has_value()) {
+        if ((mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+            log.writeln("unloading \""sv, path, "\""sv).ignore();
+            m_files[id.value()].unload();
+            return {};
+        }
+        log.writeln("reloading \""sv, path, "\""sv).ignore();
+        TRY(schedule_reload(id.value()));
+        return {};
+    }
+    if (appeared) {
+        log.writeln("adding \""sv, path, "\""sv).ignore();
+        TRY(add_folder_file(TRY(store_path(directory.path, name)),
+            directory.route_start));
+    }
+    return {};
+}
+
+// NOTE: Files that are also routed on their own are only unloaded,
+//       the rest below the directory go with their routes, paths
+//       and watches.
+ErrorOr<void> FileRouter::remove_directory(StringView directory,
+    Core::File& log)
+{
+    auto is_watched = false;
+    for (auto const& watched : m_watched_directories.values()) {
+        if (watched.path == directory)
+            is_watched = true;
+    }
+    if (!is_watched)
+        return {};
+    log.writeln("removing \""sv, directory, "\""sv).ignore();
+
+    // NOTE: The path may be one of those about to be freed.
+    auto path_buffer = TRY(StringBuffer::create_fill(directory));
+    auto path = path_buffer.view();
+
+    auto is_pinned = [&](Id<File> id) {
+        if (id == m_not_found_page)
+            return true;
+        for (auto file_id : m_watch_file_map.values()) {
+            if (file_id == id)
+                return true;
+        }
+        return false;
+    };
+    auto is_removed = [&](Id<File> id) {
+        return is_below(m_files.key(id), path) && !is_pinned(id);
+    };
+    // NOTE: Pinned files are mapped again if they come back.
+    for (u32 i = 0; i < m_files.size(); i++) {
+        if (is_below(m_files.key(Id<File>(i)), path))
+            m_files[Id<File>(i)].unload();
+    }
+
+    TRY(m_static_routes.remove_if([&](auto id) {
+        return is_removed(m_static_routes[id]);
+    }));
+    auto new_ids = TRY(m_files.remove_if(is_removed));
+    for (auto& id : m_static_routes.values())
+        id = new_ids[id.raw()];
+    for (auto& id : m_watch_file_map.values())
+        id = new_ids[id.raw()];
+    for (auto& id : m_changed_files)
+        id = new_ids[id.raw()];
+    m_changed_files.remove_if([&](u32 i) {
+        return !m_changed_files[i].is_valid();
+    });
+    if (m_not_found_page.is_valid())
+        m_not_found_page = new_ids[m_not_found_page.raw()];
+
+    TRY(m_watched_directories.remove_if([&](auto id) {
+        if (!is_below(m_watched_directories[id].path, path))
+            return false;
+        // NOTE: Deleted directories are no longer watched by now,
+        //       which this fails for.
+        inotify_rm_watch(m_filewatch_fd,
+            m_watched_directories.key(id));
+        return true;
+    }));
+
+    m_paths.remove_if([&](u32 i) {
+        auto* stored = m_paths[i];
+        auto stored_path = StringView::from_c_string(stored);
+        if (!is_below(stored_path, path))
+            return false;
+        // NOTE: A pinned file may be keyed by its path.
+        if (auto id = m_files.find(stored_path); id.has_value()) {
+            if (m_files.key(id.value()).data == stored)
+                return false;
+        }
+        free_memory(stored);
+        return true;
+    });
     return {};
 }
+#endif
+
+ErrorOr<StringView> FileRouter::store_path(StringView directory,
+    StringView name)
+{
+    TRY(m_paths.append(nullptr));
+    auto size = directory.size + 1 + name.size;
+    auto* path = (char*)TRY(allocate_memory(size + 1));
+    m_paths.last() = path;
+
+    directory.unchecked_copy_to(path);
+    path[directory.size] = '/';
+    name.unchecked_copy_to(path + directory.size + 1);
+    path[size] = '\0';
+    return StringView(path, size);
+}
 
 ErrorOr<void> FileRouter::reload_files_if_needed(Core::File& log)
 {
 #if __linux__
-    struct inotify_event event;
+    alignas(struct inotify_event) char buffer[4096];
     while (true) {
-        auto rv = ::read(m_filewatch_fd, &event, sizeof(event));
+        auto rv = ::read(m_filewatch_fd, buffer, sizeof(buffer));
         if (rv < 0) {
             if (errno == EAGAIN) {
+                reload_changed_files(log);
                 return {};
             }
             return Error::from_errno();
         }
-        auto path_id = m_watch_file_map.find(event.wd);
-        if (!path_id.has_value()) {
-            return Error::from_string_literal(
-                "could not find name of watched file");
+        for (ssize_t offset = 0; offset < rv;) {
+            auto const* event
+                = (struct inotify_event const*)(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                // NOTE: Events were lost, so any file could have
+                //       changed, they are all mapped again below.
+                log.writeln("lost file events, reloading all"sv)
+                    .ignore();
+                for (u32 i = 0; i < m_files.size(); i++)
+                    TRY(schedule_reload(Id<File>(i)));
+                continue;
+            }
+
+            if (auto watch_id = m_watch_file_map.find(event->wd);
+                watch_id.has_value()) {
+                auto file_id = m_watch_file_map[watch_id.value()];
+                log.writeln("reloading \""sv, m_files.key(file_id),
+                       "\""sv)
+                    .ignore();
+                TRY(schedule_reload(file_id));
+                continue;
+            }
+
+            auto directory_id
+                = m_watched_directories.find(event->wd);
+            if (!directory_id.has_value())
+                continue;
+            auto name = StringView();
+            if (event->len != 0)
+                name = StringView::from_c_string(event->name);
+            handle_directory_event(
+                m_watched_directories[directory_id.value()],
+                event->mask, name, log)
+                .or_else([&](auto error) {
+                    log.writeln("could not follow \""sv, name,
+                           "\": "sv, error)
+                        .ignore();
+                });
         }
-        auto path = m_watch_file_map[path_id.value()];
-        log.writeln("reloading \""sv, path, "\""sv).ignore();
-        TRY(reload_file(path));
     }
 #endif
     return {};
 }
 
-ErrorOr<void> FileRouter::reload_file(StringView path)
+// NOTE: A file that fails to load is not found until it changes,
+//       rather than served the way it was.
+ErrorOr<void> FileRouter::reload_file(Id<File> id)
+{
+    auto& file = m_files[id];
+    if (auto result = file.reload(); result.is_error()) {
+        file.unload();
+        return result.release_error();
+    }
+    return {};
+}
+
+ErrorOr<void> FileRouter::schedule_reload(Id<File> id)
+{
+    m_files[id].unload();
+    TRY(m_changed_files.append(id));
+    return {};
+}
+
+// NOTE: Files with many events are only mapped again once, as the
+//       first reload leaves them loaded. One failing must not hold
+//       the rest back.
+void FileRouter::reload_changed_files(Core::File& log)
+{
+    for (auto id : m_changed_files) {
+        if (m_files[id].is_loaded())
+            continue;
+        reload_file(id).or_else([&](auto error) {
+            log.writeln("could not reload \""sv, m_files.key(id),
+                   "\": "sv, error)
+                .ignore();
+        });
+    }
+    m_changed_files.clear();
+}
+
+bool FileRouter::compress_deferred_files()
 {
-    auto id = m_files.find(path);
-    if (!id.has_value())
-        return Error::from_string_literal("invalid file reload");
-    TRY(m_files[id.value()].reload());
+    auto is_any_deferred = false;
+    for (u32 i = 0; i < m_files.size(); i++) {
+        if (m_files[Id<File>(i)].retry_compression())
+            is_any_deferred = true;
+    }
+    return is_any_deferred;
+}
+
+ErrorOr<void> FileRouter::set_not_found_page(StringView path)
+{
+    m_not_found_page = TRY(add_file(path));
     return {};
 }
 
+Optional<Id<File>> FileRouter::not_found_page() const
+{
+    if (!m_not_found_page.is_valid())
+        return {};
+    if (!m_files[m_not_found_page].is_loaded())
+        return {};
+    return m_not_found_page;
+}
+
 Optional<Id<File>> FileRouter::find(StringView route) const
 {
-    auto filename_id = m_static_routes.find(route);
-    if (!filename_id.has_value())
+    auto route_id = m_static_routes.find(route);
+    if (!route_id.has_value())
+        return {};
+    auto file_id = m_static_routes[route_id.value()];
+    // NOTE: Files that could not be mapped, like ones removed since
+    //       they were found, are not found here either.
+    if (!m_files[file_id].is_loaded())
         return {};
-    return m_files.find(m_static_routes[filename_id.value()]);
+    return file_id;
 }
 
 }
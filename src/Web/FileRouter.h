@@ -3,17 +3,27 @@
 #include <Core/File.h>
 #include <HTTP/Response.h>
 #include <Ty/ErrorOr.h>
-#include <Ty/LinearMap.h>
+#include <Ty/HashMap.h>
 #include <Ty/SmallCapture.h>
+#include <Ty/Vector.h>
 
 namespace Web {
 
 struct FileRouter {
     using Renderer = SmallCapture<ErrorOr<HTTP::Response>>;
 
-    using StaticRoutes = LinearMap<StringView, StringView>;
-    using WatchFileMap = LinearMap<int, StringView>;
-    using Files = LinearMap<StringView, File>;
+    // NOTE: Routes lead straight to their file, and files are kept
+    //       by path, so routes to the same file share it.
+    using StaticRoutes = HashMap<StringView, Id<File>>;
+    using WatchFileMap = HashMap<int, Id<File>>;
+    using Files = HashMap<StringView, File>;
+
+    struct WatchedDirectory {
+        StringView path;
+        // NOTE: Where routes start in paths below this directory.
+        u32 route_start;
+    };
+    using WatchDirectoryMap = HashMap<int, WatchedDirectory>;
 
     static ErrorOr<FileRouter> create();
 
@@ -21,6 +31,10 @@ struct FileRouter {
         : m_static_routes(move(other.m_static_routes))
         , m_files(move(other.m_files))
         , m_watch_file_map(move(other.m_watch_file_map))
+        , m_watched_directories(move(other.m_watched_directories))
+        , m_paths(move(other.m_paths))
+        , m_changed_files(move(other.m_changed_files))
+        , m_not_found_page(other.m_not_found_page)
         , m_filewatch_fd(other.m_filewatch_fd)
     {
         other.invalidate();
@@ -38,16 +52,48 @@ struct FileRouter {
     // ErrorOr<void> add_route(StringView slug, Renderer renderer);
     ErrorOr<void> add_route(StringView route, StringView filename);
 
+    // NOTE: Routes every regular file below folder by its path
+    //       relative to it, and a directory's index.html by the
+    //       directory path as well. Hidden entries are skipped.
+    //       Files are mapped as they are found, and the directories
+    //       are watched for files coming and going. Files that can
+    //       not be mapped are not found until they change.
+    ErrorOr<void> add_folder(StringView folder);
+
+    // NOTE: The page sent with 404 responses, reloaded like any
+    //       other file.
+    ErrorOr<void> set_not_found_page(StringView path);
+    Optional<Id<File>> not_found_page() const;
+
+    // NOTE: Readable whenever a watched file or directory changed,
+    //       reload_files_if_needed() picks the changes up and maps
+    //       changed files again. -1 where files are not watched.
+    int watch_fd() const { return m_filewatch_fd; }
     ErrorOr<void> reload_files_if_needed(Core::File& log);
+
+    // NOTE: Asks the compressor again for the files it was too
+    //       busy to take, returns whether any are still waiting.
+    bool compress_deferred_files();
+
+    // NOTE: Only looks the route up, files are loaded by the time
+    //       they can be found.
     Optional<Id<File>> find(StringView route) const;
 
-    File const& operator[](Id<File> id) { return m_files[id]; }
+    u32 file_count() const { return m_files.size(); }
+
+    File const& operator[](Id<File> id) const
+    {
+        return m_files[id];
+    }
 
 private:
-    constexpr FileRouter(StaticRoutes&& static_routes, Files&& files, WatchFileMap&& watch_file_map, int filewatch_fd)
+    constexpr FileRouter(StaticRoutes&& static_routes,
+        Files&& files, WatchFileMap&& watch_file_map,
+        WatchDirectoryMap&& watched_directories, int filewatch_fd)
         : m_static_routes(move(static_routes))
         , m_files(move(files))
         , m_watch_file_map(move(watch_file_map))
+        , m_watched_directories(move(watched_directories))
         , m_filewatch_fd(filewatch_fd)
     {
     }
@@ -56,11 +102,35 @@ private:
     bool is_valid() const { return m_filewatch_fd != -1; }
     void invalidate() { m_filewatch_fd = -1; }
 
-    ErrorOr<void> reload_file(StringView path);
+    ErrorOr<Id<File>> add_file(StringView path);
+    ErrorOr<void> reload_file(Id<File> id);
+    ErrorOr<void> schedule_reload(Id<File> id);
+    void reload_changed_files(Core::File& log);
+
+    ErrorOr<void> add_directory(StringView path, u32 route_start);
+    ErrorOr<void> add_folder_file(StringView path, u32 route_start);
+    ErrorOr<void> watch_directory(c_string path_z, StringView path,
+        u32 route_start);
+    ErrorOr<void> handle_directory_event(WatchedDirectory directory,
+        u32 mask, StringView name, Core::File& log);
+    ErrorOr<void> remove_directory(StringView path,
+        Core::File& log);
+    ErrorOr<StringView> store_path(StringView directory,
+        StringView name);
 
     StaticRoutes m_static_routes;
     Files m_files;
     WatchFileMap m_watch_file_map;
+    WatchDirectoryMap m_watched_directories;
+
+    // NOTE: Paths found while walking folders, which routes, files
+    //       and watches point into.
+    Vector<char*> m_paths {};
+
+    // NOTE: Unloaded as their events come in, and mapped again once
+    //       all of those at hand are through.
+    Vector<Id<File>> m_changed_files {};
+    Id<File> m_not_found_page {};
     int m_filewatch_fd;
 };
 
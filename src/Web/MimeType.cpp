@@ -2,28 +2,500 @@
 
 namespace Web {
 
-StringView MimeType::name() const
+namespace {
+
+enum Flags : u8 {
+    Binary = 0,
+    Compressible = 1 << 0,
+    // NOTE: Sent with charset=utf-8, and compressed.
+    Text = Compressible | 1 << 1,
+};
+
+struct Entry {
+    StringView extension;
+    StringView name;
+    u8 flags;
+};
+
+// NOTE: By extension, in lower case. The types MimeType.h names
+//       go first, in its order, the rest are sorted.
+constexpr Entry entries[] = {
+    { "bin"sv, "application/octet-stream"sv, Binary },
+    { "txt"sv, "text/plain"sv, Text },
+    { "3g2"sv, "video/3gpp2"sv, Binary },
+    { "3gp"sv, "video/3gpp"sv, Binary },
+    { "3gpp"sv, "video/3gpp"sv, Binary },
+    { "3mf"sv, "model/3mf"sv, Binary },
+    { "7z"sv, "application/x-7z-compressed"sv, Binary },
+    { "aac"sv, "audio/aac"sv, Binary },
+    { "ai"sv, "application/postscript"sv, Compressible },
+    { "aif"sv, "audio/aiff"sv, Compressible },
+    { "aifc"sv, "audio/aiff"sv, Compressible },
+    { "aiff"sv, "audio/aiff"sv, Compressible },
+    { "amr"sv, "audio/amr"sv, Binary },
+    {
+        "apk"sv,
+        "application/vnd.android.package-archive"sv,
+        Binary,
+    },
+    { "apng"sv, "image/apng"sv, Binary },
+    { "appcache"sv, "text/cache-manifest"sv, Text },
+    { "asf"sv, "video/x-ms-asf"sv, Binary },
+    { "asx"sv, "video/x-ms-asf"sv, Binary },
+    { "atom"sv, "application/atom+xml"sv, Text },
+    { "au"sv, "audio/basic"sv, Compressible },
+    { "avi"sv, "video/x-msvideo"sv, Binary },
+    { "avif"sv, "image/avif"sv, Binary },
+    { "azw"sv, "application/vnd.amazon.ebook"sv, Binary },
+    { "bib"sv, "text/x-bibtex"sv, Text },
+    { "bmp"sv, "image/bmp"sv, Compressible },
+    { "bz2"sv, "application/x-bzip2"sv, Binary },
+    { "c"sv, "text/x-c"sv, Text },
+    { "cab"sv, "application/vnd.ms-cab-compressed"sv, Binary },
+    { "caf"sv, "audio/x-caf"sv, Binary },
+    { "cc"sv, "text/x-c++"sv, Text },
+    { "cer"sv, "application/pkix-cert"sv, Binary },
+    { "cfg"sv, "text/plain"sv, Text },
+    { "cjs"sv, "text/javascript"sv, Text },
+    { "conf"sv, "text/plain"sv, Text },
+    { "cpp"sv, "text/x-c++"sv, Text },
+    { "crt"sv, "application/x-x509-ca-cert"sv, Binary },
+    { "csh"sv, "application/x-csh"sv, Text },
+    { "css"sv, "text/css"sv, Text },
+    { "csv"sv, "text/csv"sv, Text },
+    { "cur"sv, "image/x-icon"sv, Compressible },
+    { "cxx"sv, "text/x-c++"sv, Text },
+    { "deb"sv, "application/vnd.debian.binary-package"sv, Binary },
+    { "der"sv, "application/x-x509-ca-cert"sv, Binary },
+    { "diff"sv, "text/x-diff"sv, Text },
+    { "dmg"sv, "application/x-apple-diskimage"sv, Binary },
+    { "doc"sv, "application/msword"sv, Compressible },
+    {
+        "docm"sv,
+        "application/vnd.ms-word.document.macroenabled.12"sv,
+        Binary,
+    },
+    {
+        "docx"sv,
+        "application/vnd.openxmlformats-officedocument."
+        "wordprocessingml.document"sv,
+        Binary,
+    },
+    { "dot"sv, "application/msword"sv, Compressible },
+    {
+        "dotx"sv,
+        "application/vnd.openxmlformats-officedocument."
+        "wordprocessingml.template"sv,
+        Binary,
+    },
+    { "dtd"sv, "application/xml-dtd"sv, Text },
+    { "ear"sv, "application/java-archive"sv, Binary },
+    { "eot"sv, "application/vnd.ms-fontobject"sv, Compressible },
+    { "eps"sv, "application/postscript"sv, Compressible },
+    { "epub"sv, "application/epub+zip"sv, Binary },
+    {
+        "exe"sv,
+        "application/vnd.microsoft.portable-executable"sv,
+        Binary,
+    },
+    { "flac"sv, "audio/flac"sv, Binary },
+    { "flv"sv, "video/x-flv"sv, Binary },
+    { "geojson"sv, "application/geo+json"sv, Text },
+    { "gif"sv, "image/gif"sv, Binary },
+    { "glb"sv, "model/gltf-binary"sv, Compressible },
+    { "gltf"sv, "model/gltf+json"sv, Text },
+    { "gpx"sv, "application/gpx+xml"sv, Text },
+    { "gz"sv, "application/gzip"sv, Binary },
+    { "h"sv, "text/x-c"sv, Text },
+    { "heic"sv, "image/heic"sv, Binary },
+    { "heif"sv, "image/heif"sv, Binary },
+    { "hh"sv, "text/x-c++"sv, Text },
+    { "hpp"sv, "text/x-c++"sv, Text },
+    { "hqx"sv, "application/mac-binhex40"sv, Compressible },
+    { "htc"sv, "text/x-component"sv, Text },
+    { "htm"sv, "text/html"sv, Text },
+    { "html"sv, "text/html"sv, Text },
+    { "ico"sv, "image/vnd.microsoft.icon"sv, Compressible },
+    { "ics"sv, "text/calendar"sv, Text },
+    { "ifb"sv, "text/calendar"sv, Text },
+    { "ini"sv, "text/plain"sv, Text },
+    { "ipynb"sv, "application/x-ipynb+json"sv, Text },
+    { "iso"sv, "application/x-iso9660-image"sv, Compressible },
+    { "jad"sv, "text/vnd.sun.j2me.app-descriptor"sv, Text },
+    { "jar"sv, "application/java-archive"sv, Binary },
+    { "java"sv, "text/x-java"sv, Text },
+    { "jfif"sv, "image/jpeg"sv, Binary },
+    { "jng"sv, "image/x-jng"sv, Binary },
+    { "jnlp"sv, "application/x-java-jnlp-file"sv, Text },
+    { "jp2"sv, "image/jp2"sv, Binary },
+    { "jpe"sv, "image/jpeg"sv, Binary },
+    { "jpeg"sv, "image/jpeg"sv, Binary },
+    { "jpg"sv, "image/jpeg"sv, Binary },
+    { "js"sv, "text/javascript"sv, Text },
+    { "json"sv, "application/json"sv, Text },
+    { "jsonld"sv, "application/ld+json"sv, Text },
+    { "jxl"sv, "image/jxl"sv, Binary },
+    { "kar"sv, "audio/midi"sv, Compressible },
+    { "key"sv, "application/vnd.apple.keynote"sv, Binary },
+    { "kml"sv, "application/vnd.google-earth.kml+xml"sv, Text },
+    { "kmz"sv, "application/vnd.google-earth.kmz"sv, Binary },
+    { "ktx"sv, "image/ktx"sv, Compressible },
+    { "ktx2"sv, "image/ktx2"sv, Binary },
+    { "latex"sv, "application/x-latex"sv, Text },
+    { "log"sv, "text/plain"sv, Text },
+    { "lz"sv, "application/x-lzip"sv, Binary },
+    { "lzma"sv, "application/x-lzma"sv, Binary },
+    { "m2ts"sv, "video/mp2t"sv, Binary },
+    { "m3u"sv, "audio/x-mpegurl"sv, Text },
+    { "m3u8"sv, "application/vnd.apple.mpegurl"sv, Text },
+    { "m4a"sv, "audio/mp4"sv, Binary },
+    { "m4s"sv, "video/iso.segment"sv, Binary },
+    { "m4v"sv, "video/mp4"sv, Binary },
+    { "map"sv, "application/json"sv, Text },
+    { "markdown"sv, "text/markdown"sv, Text },
+    { "mathml"sv, "application/mathml+xml"sv, Text },
+    { "md"sv, "text/markdown"sv, Text },
+    { "mid"sv, "audio/midi"sv, Compressible },
+    { "midi"sv, "audio/midi"sv, Compressible },
+    { "mjs"sv, "text/javascript"sv, Text },
+    { "mka"sv, "audio/x-matroska"sv, Binary },
+    { "mkv"sv, "video/x-matroska"sv, Binary },
+    { "mml"sv, "text/mathml"sv, Text },
+    { "mng"sv, "video/x-mng"sv, Binary },
+    { "mobi"sv, "application/x-mobipocket-ebook"sv, Binary },
+    { "mov"sv, "video/quicktime"sv, Binary },
+    { "mp3"sv, "audio/mpeg"sv, Binary },
+    { "mp4"sv, "video/mp4"sv, Binary },
+    { "mpd"sv, "application/dash+xml"sv, Text },
+    { "mpe"sv, "video/mpeg"sv, Binary },
+    { "mpeg"sv, "video/mpeg"sv, Binary },
+    { "mpg"sv, "video/mpeg"sv, Binary },
+    { "msi"sv, "application/x-msdownload"sv, Binary },
+    { "n3"sv, "text/n3"sv, Text },
+    { "ndjson"sv, "application/x-ndjson"sv, Text },
+    { "numbers"sv, "application/vnd.apple.numbers"sv, Binary },
+    {
+        "odg"sv,
+        "application/vnd.oasis.opendocument.graphics"sv,
+        Binary,
+    },
+    {
+        "odp"sv,
+        "application/vnd.oasis.opendocument.presentation"sv,
+        Binary,
+    },
+    {
+        "ods"sv,
+        "application/vnd.oasis.opendocument.spreadsheet"sv,
+        Binary,
+    },
+    {
+        "odt"sv,
+        "application/vnd.oasis.opendocument.text"sv,
+        Binary,
+    },
+    { "oga"sv, "audio/ogg"sv, Binary },
+    { "ogg"sv, "audio/ogg"sv, Binary },
+    { "ogv"sv, "video/ogg"sv, Binary },
+    { "ogx"sv, "application/ogg"sv, Binary },
+    { "opml"sv, "text/x-opml"sv, Text },
+    { "opus"sv, "audio/ogg"sv, Binary },
+    { "otf"sv, "font/otf"sv, Compressible },
+    { "p12"sv, "application/x-pkcs12"sv, Binary },
+    { "p7b"sv, "application/x-pkcs7-certificates"sv, Binary },
+    { "pages"sv, "application/vnd.apple.pages"sv, Binary },
+    { "patch"sv, "text/x-diff"sv, Text },
+    { "pbm"sv, "image/x-portable-bitmap"sv, Compressible },
+    { "pdf"sv, "application/pdf"sv, Binary },
+    { "pem"sv, "application/x-pem-file"sv, Text },
+    { "pfx"sv, "application/x-pkcs12"sv, Binary },
+    { "pgm"sv, "image/x-portable-graymap"sv, Compressible },
+    { "pjp"sv, "image/jpeg"sv, Binary },
+    { "pjpeg"sv, "image/jpeg"sv, Binary },
+    { "pl"sv, "application/x-perl"sv, Text },
+    { "pls"sv, "audio/x-scpls"sv, Text },
+    { "pm"sv, "application/x-perl"sv, Text },
+    { "png"sv, "image/png"sv, Binary },
+    { "pnm"sv, "image/x-portable-anymap"sv, Compressible },
+    { "pot"sv, "application/vnd.ms-powerpoint"sv, Compressible },
+    {
+        "potx"sv,
+        "application/vnd.openxmlformats-officedocument."
+        "presentationml.template"sv,
+        Binary,
+    },
+    { "ppm"sv, "image/x-portable-pixmap"sv, Compressible },
+    { "pps"sv, "application/vnd.ms-powerpoint"sv, Compressible },
+    {
+        "ppsx"sv,
+        "application/vnd.openxmlformats-officedocument."
+        "presentationml.slideshow"sv,
+        Binary,
+    },
+    { "ppt"sv, "application/vnd.ms-powerpoint"sv, Compressible },
+    {
+        "pptx"sv,
+        "application/vnd.openxmlformats-officedocument."
+        "presentationml.presentation"sv,
+        Binary,
+    },
+    { "prc"sv, "application/x-pilot"sv, Binary },
+    { "ps"sv, "application/postscript"sv, Compressible },
+    { "psd"sv, "image/vnd.adobe.photoshop"sv, Compressible },
+    { "py"sv, "text/x-python"sv, Text },
+    { "qt"sv, "video/quicktime"sv, Binary },
+    { "ra"sv, "audio/x-realaudio"sv, Binary },
+    { "rar"sv, "application/vnd.rar"sv, Binary },
+    { "rdf"sv, "application/rdf+xml"sv, Text },
+    { "rpm"sv, "application/x-redhat-package-manager"sv, Binary },
+    { "rss"sv, "application/rss+xml"sv, Text },
+    { "rtf"sv, "application/rtf"sv, Compressible },
+    { "rtx"sv, "text/richtext"sv, Text },
+    { "run"sv, "application/x-makeself"sv, Binary },
+    { "sea"sv, "application/x-sea"sv, Binary },
+    { "sgm"sv, "text/sgml"sv, Text },
+    { "sgml"sv, "text/sgml"sv, Text },
+    { "sh"sv, "application/x-sh"sv, Text },
+    { "shtml"sv, "text/html"sv, Text },
+    { "sig"sv, "application/pgp-signature"sv, Binary },
+    { "sit"sv, "application/x-stuffit"sv, Binary },
+    { "smi"sv, "application/smil+xml"sv, Text },
+    { "smil"sv, "application/smil+xml"sv, Text },
+    { "snd"sv, "audio/basic"sv, Compressible },
+    { "spx"sv, "audio/ogg"sv, Binary },
+    { "sql"sv, "application/sql"sv, Text },
+    { "srt"sv, "application/x-subrip"sv, Text },
+    { "stl"sv, "model/stl"sv, Compressible },
+    { "svg"sv, "image/svg+xml"sv, Text },
+    { "svgz"sv, "image/svg+xml"sv, Binary },
+    { "swf"sv, "application/x-shockwave-flash"sv, Binary },
+    { "tar"sv, "application/x-tar"sv, Compressible },
+    { "tcl"sv, "application/x-tcl"sv, Text },
+    { "tex"sv, "application/x-tex"sv, Text },
+    { "text"sv, "text/plain"sv, Text },
+    { "tgz"sv, "application/gzip"sv, Binary },
+    { "tif"sv, "image/tiff"sv, Compressible },
+    { "tiff"sv, "image/tiff"sv, Compressible },
+    { "tk"sv, "application/x-tcl"sv, Text },
+    { "toml"sv, "application/toml"sv, Text },
+    { "torrent"sv, "application/x-bittorrent"sv, Compressible },
+    { "ts"sv, "video/mp2t"sv, Binary },
+    { "tsv"sv, "text/tab-separated-values"sv, Text },
+    { "ttc"sv, "font/collection"sv, Compressible },
+    { "ttf"sv, "font/ttf"sv, Compressible },
+    { "ttl"sv, "text/turtle"sv, Text },
+    { "usdz"sv, "model/vnd.usdz+zip"sv, Binary },
+    { "vcard"sv, "text/vcard"sv, Text },
+    { "vcf"sv, "text/vcard"sv, Text },
+    { "vtt"sv, "text/vtt"sv, Text },
+    { "wasm"sv, "application/wasm"sv, Compressible },
+    { "wav"sv, "audio/wav"sv, Compressible },
+    { "wbmp"sv, "image/vnd.wap.wbmp"sv, Binary },
+    { "weba"sv, "audio/webm"sv, Binary },
+    { "webm"sv, "video/webm"sv, Binary },
+    { "webmanifest"sv, "application/manifest+json"sv, Text },
+    { "webp"sv, "image/webp"sv, Binary },
+    { "wma"sv, "audio/x-ms-wma"sv, Binary },
+    { "wml"sv, "text/vnd.wap.wml"sv, Text },
+    { "wmlc"sv, "application/vnd.wap.wmlc"sv, Binary },
+    { "wmv"sv, "video/x-ms-wmv"sv, Binary },
+    { "woff"sv, "font/woff"sv, Binary },
+    { "woff2"sv, "font/woff2"sv, Binary },
+    { "xbm"sv, "image/x-xbitmap"sv, Compressible },
+    { "xht"sv, "application/xhtml+xml"sv, Text },
+    { "xhtml"sv, "application/xhtml+xml"sv, Text },
+    { "xlf"sv, "application/xliff+xml"sv, Text },
+    { "xliff"sv, "application/xliff+xml"sv, Text },
+    { "xls"sv, "application/vnd.ms-excel"sv, Compressible },
+    {
+        "xlsm"sv,
+        "application/vnd.ms-excel.sheet.macroenabled.12"sv,
+        Binary,
+    },
+    {
+        "xlsx"sv,
+        "application/vnd.openxmlformats-officedocument."
+        "spreadsheetml.sheet"sv,
+        Binary,
+    },
+    { "xlt"sv, "application/vnd.ms-excel"sv, Compressible },
+    {
+        "xltx"sv,
+        "application/vnd.openxmlformats-officedocument."
+        "spreadsheetml.template"sv,
+        Binary,
+    },
+    { "xml"sv, "application/xml"sv, Text },
+    { "xpi"sv, "application/x-xpinstall"sv, Binary },
+    { "xpm"sv, "image/x-xpixmap"sv, Compressible },
+    { "xsd"sv, "application/xml"sv, Text },
+    { "xsl"sv, "application/xslt+xml"sv, Text },
+    { "xslt"sv, "application/xslt+xml"sv, Text },
+    { "xspf"sv, "application/xspf+xml"sv, Text },
+    { "xul"sv, "application/vnd.mozilla.xul+xml"sv, Text },
+    { "xz"sv, "application/x-xz"sv, Binary },
+    { "yaml"sv, "application/yaml"sv, Text },
+    { "yml"sv, "application/yaml"sv, Text },
+    { "zip"sv, "application/zip"sv, Binary },
+    { "zst"sv, "application/zstd"sv, Binary },
+};
+
+constexpr u32 entry_count = sizeof(entries) / sizeof(entries[0]);
+constexpr u32 max_extension_size = 16;
+
+constexpr u32 bucket_count = 128;
+constexpr u32 slot_count = 512;
+constexpr u16 empty_slot = 0xFFFF;
+
+constexpr u32 hash(StringView key, u32 seed)
 {
-    switch(m_type) {
-    case ApplicationJson:
-        return "application/json"sv;
-    case ApplicationOctetStream:
-        return "application/octet-stream"sv;
-    case ImageIco:
-        return "image/vnd.microsoft.icon"sv;
-    case ImagePng:
-        return "image/png"sv;
-    case TextCss:
-        return "text/css"sv;
-    case TextHtml:
-        return "text/html"sv;
-    case TextJavascript:
-        return "text/javascript"sv;
-    case TextMarkdown:
-        return "text/markdown"sv;
-    case TextPlain:
-        return "text/plain"sv;
+    u32 value = 2166136261U ^ (seed * 0x9E3779B9U);
+    for (u32 i = 0; i < key.size; i++) {
+        value ^= (u8)key[i];
+        value *= 16777619U;
+    }
+    value ^= value >> 15;
+    value *= 0x85EBCA6BU;
+    value ^= value >> 13;
+    return value;
+}
+
+struct PerfectHash {
+    u16 seeds[bucket_count];
+    u16 slots[slot_count];
+
+    constexpr u32 slot_of(StringView key) const
+    {
+        auto bucket = hash(key, 0) % bucket_count;
+        return hash(key, seeds[bucket]) % slot_count;
     }
+};
+
+// NOTE: Extensions are put in buckets by one hash, then every
+//       bucket, largest first, gets the first seed that spreads
+//       its extensions over free slots with a second one. Lookups
+//       hash twice and compare once.
+constexpr PerfectHash make_perfect_hash()
+{
+    auto result = PerfectHash {};
+    for (u32 slot = 0; slot < slot_count; slot++)
+        result.slots[slot] = empty_slot;
+
+    u32 entry_buckets[entry_count] = {};
+    u32 bucket_sizes[bucket_count] = {};
+    for (u32 i = 0; i < entry_count; i++) {
+        auto bucket = hash(entries[i].extension, 0) % bucket_count;
+        entry_buckets[i] = bucket;
+        bucket_sizes[bucket]++;
+    }
+
+    bool is_placed[bucket_count] = {};
+    for (u32 round = 0; round < bucket_count; round++) {
+        auto bucket = bucket_count;
+        for (u32 i = 0; i < bucket_count; i++) {
+            if (is_placed[i])
+                continue;
+            if (bucket == bucket_count
+                || bucket_sizes[i] > bucket_sizes[bucket])
+                bucket = i;
+        }
+        is_placed[bucket] = true;
+        if (bucket_sizes[bucket] == 0)
+            break;
+
+        u16 members[entry_count] = {};
+        u32 member_count = 0;
+        for (u32 i = 0; i < entry_count; i++) {
+            if (entry_buckets[i] == bucket)
+                members[member_count++] = (u16)i;
+        }
+
+        for (u16 seed = 1; seed != 0; seed++) {
+            u32 slots[entry_count] = {};
+            auto fits = true;
+            for (u32 i = 0; i < member_count && fits; i++) {
+                slots[i] = hash(entries[members[i]].extension, seed)
+                    % slot_count;
+                fits = result.slots[slots[i]] == empty_slot;
+                for (u32 j = 0; j < i && fits; j++)
+                    fits = slots[j] != slots[i];
+            }
+            if (!fits)
+                continue;
+            for (u32 i = 0; i < member_count; i++)
+                result.slots[slots[i]] = members[i];
+            result.seeds[bucket] = seed;
+            break;
+        }
+    }
+    return result;
+}
+
+constexpr auto perfect_hash = make_perfect_hash();
+
+// NOTE: A bucket no seed fits, or an extension listed twice, leaves
+//       entries that lookups never find.
+constexpr bool all_entries_found()
+{
+    for (u32 i = 0; i < entry_count; i++) {
+        auto extension = entries[i].extension;
+        if (extension.size > max_extension_size)
+            return false;
+        auto slot = perfect_hash.slot_of(extension);
+        if (perfect_hash.slots[slot] != i)
+            return false;
+    }
+    return true;
+}
+static_assert(all_entries_found());
+
+}
+
+MimeType MimeType::from_path(StringView path)
+{
+    for (u32 i = path.size; i > 0; i--) {
+        if (path[i - 1] == '/')
+            break;
+        if (path[i - 1] == '.')
+            return from_extension(path.shrink_from_start(i));
+    }
+    return octet_stream();
+}
+
+MimeType MimeType::from_extension(StringView extension)
+{
+    if (extension.size > max_extension_size)
+        return octet_stream();
+    char lower_case[max_extension_size];
+    for (u32 i = 0; i < extension.size; i++) {
+        auto character = extension[i];
+        if (character >= 'A' && character <= 'Z')
+            character = (char)(character - 'A' + 'a');
+        lower_case[i] = character;
+    }
+    auto key = StringView(lower_case, extension.size);
+
+    auto index = perfect_hash.slots[perfect_hash.slot_of(key)];
+    if (index == empty_slot || entries[index].extension != key)
+        return octet_stream();
+    return MimeType(index);
+}
+
+StringView MimeType::name() const
+{
+    return entries[m_index].name;
+}
+
+StringView MimeType::charset() const
+{
+    if ((entries[m_index].flags & Text) != Text)
+        return ""sv;
+    return "utf-8"sv;
+}
+
+bool MimeType::is_compressible() const
+{
+    return (entries[m_index].flags & Compressible) != 0;
 }
 
 }
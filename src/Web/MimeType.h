@@ -4,27 +4,36 @@
 namespace Web {
 
 struct MimeType {
-    enum Type : u8 {
-        ApplicationJson,
-        ApplicationOctetStream,
-        ImageIco,
-        ImagePng,
-        TextCss,
-        TextHtml,
-        TextJavascript,
-        TextMarkdown,
-        TextPlain,
-    };
-    constexpr MimeType(Type type)
-        : m_type(type)
-    {
-    }
+    // NOTE: Goes by the extension of the file name, in any case.
+    //       Files without a known one are octet streams.
+    static MimeType from_path(StringView path);
+    static MimeType from_extension(StringView extension);
+
+    static constexpr MimeType octet_stream() { return MimeType(0); }
+    static constexpr MimeType text_plain() { return MimeType(1); }
 
     StringView name() const;
-    constexpr Type type() const { return m_type; }
+
+    // NOTE: Empty for types that are not text.
+    StringView charset() const;
+
+    // NOTE: Whether the format leaves anything for gzip to find,
+    //       most images and archives are compressed already.
+    bool is_compressible() const;
+
+    constexpr bool operator==(MimeType other) const
+    {
+        return m_index == other.m_index;
+    }
 
 private:
-    Type m_type;
+    constexpr explicit MimeType(u16 index)
+        : m_index(index)
+    {
+    }
+
+    // NOTE: Index into the table in MimeType.cpp.
+    u16 m_index;
 };
 
 }
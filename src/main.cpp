@@ -1,31 +1,100 @@
 #include <CLI/ArgumentParser.h>
 #include <Core/File.h>
-#include <HTTP/Headers.h>
+#include <Core/Thread.h>
+#include <HTTP/Range.h>
+#include <HTTP/Request.h>
 #include <HTTP/Response.h>
 #include <Main/Main.h>
+#include <Mem/AddressSpace.h>
+#include <Net/BufferPool.h>
+#include <Net/EventLoop.h>
+#include <Net/RequestReader.h>
 #include <Net/TCPConnection.h>
 #include <Net/TCPListener.h>
+#include <Ty/Arena.h>
 #include <Ty/Defer.h>
+#include <Ty/Lock.h>
 #include <Ty/Parse.h>
 #include <Ty/SmallCapture.h>
 #include <Ty/SmallMap.h>
 #include <Ty/StringView.h>
+#include <Ty/Threads.h>
 #include <Web/FileRouter.h>
 
 using Renderer
-    = SmallCapture<ErrorOr<HTTP::Response>(HTTP::Headers const&)>;
+    = SmallCapture<ErrorOr<HTTP::Response>(HTTP::Request const&)>;
 using DynamicRouter = Ty::SmallMap<StringView, Renderer>;
 
 static ErrorOr<void> setup_zombie_reaper();
+static ErrorOr<void> raise_open_file_limit();
+static ErrorOr<void> start_logging_stats(Core::File& log);
 
-struct Connection {
-    Net::TCPConnection& client;
+static constexpr u16 listen_backlog = 1024;
+static constexpr u32 stats_interval_seconds = 10;
+
+// NOTE: Enough for the heads of the most ranges a request may ask
+//       for, with room to spare for error messages.
+static constexpr usize request_arena_size = 64 * 1024;
+
+struct Context {
     Core::File& log;
-    Web::FileRouter& file_router;
+    Web::FileRouter const& file_router;
+    DynamicRouter const& dynamic_router;
+
+    // NOTE: Scratch memory for one request at a time, reset when
+    //       it has been answered.
+    Arena& arena;
+};
+
+struct StaticRoute {
+    StringView route;
+    StringView filename;
+};
+using StaticRoutes = View<StaticRoute const>;
+
+struct FileRoutes {
+    StaticRoutes static_routes;
+    StringView routed_folder;
+    StringView not_found_page;
+};
+static ErrorOr<Web::FileRouter> create_file_router(
+    FileRoutes const& routes, Core::File& log);
+
+// NOTE: Workers share one file router, which only the file watcher
+//       changes. Each worker holds its own lock while it answers a
+//       request, and the watcher takes all of them, so workers
+//       only wait on each other while files are reloaded. Padded
+//       so no two share a cache line.
+struct FilesLock {
+    Lock lock;
+    u8 padding[64];
+};
+static ErrorOr<void> start_watching_files(Web::FileRouter& router,
+    View<FilesLock> locks);
+
+struct Worker {
+    Net::TCPListener const& server;
+    Web::FileRouter const& file_router;
+    Lock& files_lock;
     DynamicRouter const& dynamic_router;
-    StringView static_folder_path;
+    Net::Backend backend;
 };
-static ErrorOr<void> handle_connection(Connection const& args);
+static ErrorOr<void> run_worker(Worker const& worker);
+
+static ErrorOr<int> serve_forked(Net::TCPListener& server,
+    Web::FileRouter& file_router, Context const& args);
+static ErrorOr<void> handle_connection(Context const& args,
+    Net::TCPConnection& client);
+static Optional<u64> receive_timeout_ms(Net::ReadPhase phase,
+    Net::ConnectionLimits const& limits, u64& head_deadline);
+static ErrorOr<void> set_socket_timeout(int socket, int option,
+    u64 timeout_ms);
+static ErrorOr<Net::KeepAlive> handle_request(Context const& args,
+    Net::TCPConnection& client, HTTP::Request const& request,
+    Net::KeepAlive may_keep_alive);
+static ErrorOr<void> respond_ranges(Arena& arena,
+    Net::TCPConnection& client, Web::File const& file,
+    HTTP::ByteRanges const& ranges, bool keep_alive);
 
 ErrorOr<int> Main::main(int argc, c_string argv[])
 {
@@ -47,6 +116,56 @@ ErrorOr<int> Main::main(int argc, c_string argv[])
             });
         }));
 
+    auto should_fork = false;
+    TRY(argument_parser.add_flag("--fork"sv, "-f"sv,
+        "serve each connection in a forked process"sv, [&] {
+            should_fork = true;
+        }));
+
+    auto worker_count_or_error = ErrorOr<u32>(Threads::in_machine());
+    TRY(argument_parser.add_option("--workers"sv, "-w"sv, "number"sv,
+        "Worker threads to use (default: one per hardware thread)"sv,
+        [&](auto argument) {
+            auto count = StringView::from_c_string(argument);
+            worker_count_or_error
+                = Parse<u32>::from(count).or_throw([] {
+                      return Error::from_string_literal(
+                          "invalid worker count", "argument_parser");
+                  });
+        }));
+
+    auto should_steer_by_cpu = false;
+    TRY(argument_parser.add_flag("--steer-by-cpu"sv, "-s"sv,
+        "hand connections to the worker on the receiving CPU"sv,
+        [&] {
+            should_steer_by_cpu = true;
+        }));
+
+    auto backend = Net::Backend::Epoll;
+    TRY(argument_parser.add_flag("--io-uring"sv, "-u"sv,
+        "use io_uring instead of epoll when available"sv,
+        [&] {
+            backend = Net::Backend::IOURing;
+        }));
+
+    auto should_use_huge_pages = false;
+    TRY(argument_parser.add_flag("--huge-pages"sv, "-H"sv,
+        "back socket buffers with huge pages"sv, [&] {
+            should_use_huge_pages = true;
+        }));
+
+    auto should_route_folder = false;
+    TRY(argument_parser.add_flag("--route-folder"sv, "-r"sv,
+        "route every file in the static folder by its path"sv, [&] {
+            should_route_folder = true;
+        }));
+
+    auto should_log_stats = false;
+    TRY(argument_parser.add_flag("--stats"sv, "-S"sv,
+        "log memory and buffer use every 10 seconds"sv, [&] {
+            should_log_stats = true;
+        }));
+
     auto static_folder_path = StringView();
     TRY(argument_parser.add_positional_argument("static-folder"sv,
         [&](auto argument) {
@@ -60,16 +179,32 @@ ErrorOr<int> Main::main(int argc, c_string argv[])
         return 1;
     }
     auto port = TRY(port_or_error);
-
-    auto file_router = TRY(Web::FileRouter::create());
+    auto worker_count = TRY(worker_count_or_error);
+    if (worker_count == 0)
+        worker_count = 1;
 
     auto index_path = TRY(StringBuffer::create_fill(
         static_folder_path, "/index.html"sv));
-    TRY(file_router.add_route("/"sv, index_path.view()));
-
     auto script = TRY(StringBuffer::create_fill(static_folder_path,
         "/script.js"sv));
-    TRY(file_router.add_route("/script.js"sv, script.view()));
+    StaticRoute const static_route_table[] = {
+        { "/"sv, index_path.view() },
+        { "/script.js"sv, script.view() },
+    };
+    auto static_routes = StaticRoutes(static_route_table,
+        sizeof(static_route_table) / sizeof(static_route_table[0]));
+    auto routed_folder = StringView();
+    if (should_route_folder) {
+        static_routes = StaticRoutes(static_route_table, 0);
+        routed_folder = static_folder_path;
+    }
+    auto not_found_page = TRY(StringBuffer::create_fill(
+        static_folder_path, "/error/404.html"sv));
+    auto file_routes = FileRoutes {
+        .static_routes = static_routes,
+        .routed_folder = routed_folder,
+        .not_found_page = not_found_page.view(),
+    };
 
     auto dynamic_router = DynamicRouter();
 
@@ -78,66 +213,401 @@ ErrorOr<int> Main::main(int argc, c_string argv[])
             return Error::from_string_literal("panic!");
         }));
 
+    Net::BufferPool::configure({
+        .use_huge_pages = should_use_huge_pages,
+    });
+
     auto& log = Core::File::stderr();
 
     log.writeln("Serving on port: "sv, port).ignore();
 
+    // NOTE: Idle keep-alive clients alone can hold more sockets
+    //       than the default soft limit allows.
+    TRY(raise_open_file_limit());
+
+    if (should_log_stats)
+        TRY(start_logging_stats(log));
+
+    if (should_fork) {
+        auto file_router = TRY(create_file_router(file_routes, log));
+        auto arena = TRY(Arena::create(request_arena_size));
+        auto server
+            = TRY(Net::TCPListener::create(port, listen_backlog));
+        return TRY(serve_forked(server, file_router,
+            {
+                .log = log,
+                .file_router = file_router,
+                .dynamic_router = dynamic_router,
+                .arena = arena,
+            }));
+    }
+
+    // NOTE: Where the event loops keep their connection records.
+    TRY(Mem::LoRam::init());
+
+    // NOTE: Every worker gets its own listener in the same reuseport
+    //       group, so the kernel load balances between them without
+    //       an accept lock. Listeners are bound in worker order,
+    //       which is what --steer-by-cpu relies on.
+    auto reuse_port
+        = worker_count > 1 ? Net::ReusePort::Yes : Net::ReusePort::No;
+    auto listeners
+        = TRY(Vector<Net::TCPListener>::create(worker_count));
+    for (u32 i = 0; i < worker_count; i++) {
+        TRY(listeners.append(TRY(Net::TCPListener::create(port,
+            listen_backlog, Net::IPVersion::V4, reuse_port))));
+    }
+
+    // NOTE: Workers are spread over the CPUs this process may run
+    //       on, which need not start at 0 or be contiguous.
+    auto cpu_count = Threads::in_machine();
+    auto worker_cpus = TRY(Vector<u32>::create(worker_count));
+    for (u32 i = 0; i < worker_count; i++)
+        TRY(worker_cpus.append(Threads::cpu(i % cpu_count)));
+    if (should_steer_by_cpu) {
+        TRY(listeners[0].steer_connections_by_cpu(
+            { worker_cpus.data(), worker_cpus.size() }));
+    }
+
+    auto file_router = TRY(create_file_router(file_routes, log));
+    auto files_locks = TRY(Vector<FilesLock>::create(worker_count));
+    for (u32 i = 0; i < worker_count; i++)
+        TRY(files_locks.append(FilesLock {}));
+    TRY(start_watching_files(file_router,
+        { files_locks.data(), files_locks.size() }));
+    // NOTE: Workers only return on errors, the watcher is kept off
+    //       the router from then on, as it goes with main().
+    Defer stop_watching_files = [&] {
+        for (auto& files_lock : files_locks)
+            files_lock.lock.lock();
+    };
+
+    auto workers = TRY(Vector<Worker>::create(worker_count));
+    for (u32 i = 0; i < worker_count; i++) {
+        TRY(workers.append(Worker {
+            .server = listeners[i],
+            .file_router = file_router,
+            .files_lock = files_locks[i].lock,
+            .dynamic_router = dynamic_router,
+            .backend = backend,
+        }));
+    }
+
+    if (worker_count == 1) {
+        TRY(run_worker(workers[0]));
+        return 0;
+    }
+
+    auto threads = TRY(Vector<Core::Thread>::create(worker_count));
+    for (u32 i = 0; i < worker_count; i++) {
+        auto thread = TRY(Core::Thread::spawn([&worker = workers[i]] {
+            while (true) {
+                auto result = run_worker(worker);
+                if (!result.is_error())
+                    return;
+                auto& log = Core::File::stderr();
+                log.writeln("Error: "sv, result.error()).ignore();
+                log.writeln("Restarting worker in 10 seconds"sv)
+                    .ignore();
+                System::sleep(10);
+            }
+        }));
+        thread.pin_to_cpu(worker_cpus[i]).or_else([&](auto error) {
+            log.writeln("Could not pin worker: "sv, error).ignore();
+        });
+        TRY(threads.append(move(thread)));
+    }
+
+    for (auto& thread : threads)
+        TRY(thread.join());
+
+    return 0;
+}
+
+static ErrorOr<Web::FileRouter> create_file_router(
+    FileRoutes const& routes, Core::File& log)
+{
+    auto file_router = TRY(Web::FileRouter::create());
+    for (auto static_route : routes.static_routes)
+        TRY(file_router.add_route(static_route.route,
+            static_route.filename));
+    if (!routes.routed_folder.is_empty()) {
+        auto start = System::monotonic_milliseconds();
+        TRY(file_router.add_folder(routes.routed_folder));
+        auto elapsed = System::monotonic_milliseconds() - start;
+        log.writeln("routed "sv, file_router.file_count(),
+               " files in "sv, elapsed, " ms"sv)
+            .ignore();
+    }
+    // NOTE: Without the page, a 404 is sent with a short text body.
+    file_router.set_not_found_page(routes.not_found_page)
+        .or_else([&](auto error) {
+            log.writeln("Could not load not found page: "sv, error)
+                .ignore();
+        });
+    return file_router;
+}
+
+// NOTE: Changes are picked up as they come in. Files are only
+//       mapped here, and while the compressor is too busy to take
+//       files it is asked again about once a second.
+static ErrorOr<void> start_watching_files(Web::FileRouter& router,
+    View<FilesLock> locks)
+{
+    auto thread = TRY(Core::Thread::spawn([&router, locks] {
+        auto& log = Core::File::stderr();
+        auto is_compression_deferred = true;
+        while (true) {
+            struct pollfd watch = {
+                .fd = router.watch_fd(),
+                .events = POLLIN,
+                .revents = 0,
+            };
+            auto result = System::poll(&watch, 1,
+                is_compression_deferred ? 1000 : -1);
+            if (result.is_error()) {
+                log.writeln("Stopped watching files: "sv,
+                       result.error())
+                    .ignore();
+                return;
+            }
+
+            for (auto& files_lock : locks)
+                files_lock.lock.lock();
+            router.reload_files_if_needed(log).or_else(
+                [&](auto error) {
+                    log.writeln("Could not reload files: "sv, error)
+                        .ignore();
+                });
+            is_compression_deferred
+                = router.compress_deferred_files();
+            for (auto& files_lock : locks)
+                files_lock.lock.unlock();
+        }
+    }));
+    TRY(thread.detach());
+    return {};
+}
+
+static ErrorOr<void> run_worker(Worker const& worker)
+{
+    auto arena = TRY(Arena::create(request_arena_size));
+    auto context = Context {
+        .log = Core::File::stderr(),
+        .file_router = worker.file_router,
+        .dynamic_router = worker.dynamic_router,
+        .arena = arena,
+    };
+
+    // NOTE: Responses do not point into the files once answered,
+    //       bodies are copied or sent from their own descriptor, so
+    //       files may be reloaded between requests.
+    auto event_loop = TRY(Net::EventLoop::create(worker.server,
+        context.log,
+        [&context, &worker](auto& client, auto const& request,
+            auto keep_alive) {
+            worker.files_lock.lock();
+            Defer unlock_files = [&] {
+                worker.files_lock.unlock();
+            };
+            return handle_request(context, client, request,
+                keep_alive);
+        },
+        worker.backend));
+    TRY(event_loop.run());
+    return {};
+}
+
+static ErrorOr<int> serve_forked(Net::TCPListener& server,
+    Web::FileRouter& file_router, Context const& args)
+{
     TRY(setup_zombie_reaper());
-    auto server = TRY(Net::TCPListener::create(port));
+
+    // NOTE: Children serve the files as they were when they were
+    //       forked, the file watch is taken care of here.
+    struct pollfd fds[] = {
+        { .fd = server.socket(), .events = POLLIN, .revents = 0 },
+        {
+            .fd = file_router.watch_fd(),
+            .events = POLLIN,
+            .revents = 0,
+        },
+    };
     while (true) {
+        TRY(System::poll(fds, 2));
+        if (fds[1].revents & POLLIN)
+            TRY(file_router.reload_files_if_needed(args.log));
+        if (!(fds[0].revents & POLLIN))
+            continue;
         auto client = TRY(server.accept());
 
         if (TRY(System::fork()) > 0)
             continue;
         server.destroy().ignore();
 
-        // clang-format off
-        handle_connection({
-            .client = client,
-            .log = log,
-            .file_router = file_router,
-            .dynamic_router = dynamic_router,
-            .static_folder_path = static_folder_path,
-        }).or_else([&](auto error) {
-            log.writeln("Error: "sv, error).ignore();
+        handle_connection(args, client).or_else([&](auto error) {
+            args.log.writeln("Error: "sv, error).ignore();
         });
-        // clang-format on
         return 0;
     }
-
-    return 0;
 }
 
-static ErrorOr<void> handle_connection(Connection const& args)
+static ErrorOr<void> handle_connection(Context const& args,
+    Net::TCPConnection& client)
 {
-    auto client_name = TRY(args.client.printable_address());
+    auto client_name = TRY(client.printable_address());
     args.log.writeln(client_name.view(), " connected"sv).ignore();
     Defer print_disconnect = [&] {
         args.log.writeln("dropped "sv, client_name.view()).ignore();
     };
 
+    auto limits = Net::ConnectionLimits();
+    TRY(set_socket_timeout(client.socket, SO_SNDTIMEO,
+        limits.write_timeout_seconds * 1000ull));
+
+    auto reader = Net::RequestReader();
+    u64 head_deadline = 0;
+    for (u32 served = 0; served < limits.max_requests;) {
+        auto request = TRY(reader.next_request());
+        if (!request.has_value()) {
+            auto timeout_ms = receive_timeout_ms(reader.phase(),
+                limits, head_deadline);
+            if (!timeout_ms.has_value())
+                return {};
+            TRY(set_socket_timeout(client.socket, SO_RCVTIMEO,
+                timeout_ms.value()));
+            auto progress = TRY(reader.receive(client));
+            // NOTE: Stop once the client closed or timed out.
+            if (progress != Net::Progress::Complete)
+                return {};
+            continue;
+        }
+        head_deadline = 0;
+
+        auto may_keep_alive = Net::KeepAlive::No;
+        if (served + 1 < limits.max_requests)
+            may_keep_alive = Net::KeepAlive::Yes;
+        auto keep_alive = TRY(handle_request(args, client,
+            request.value(), may_keep_alive));
+        TRY(client.flush_write());
+        served++;
+        if (keep_alive == Net::KeepAlive::No)
+            return {};
+    }
+    return {};
+}
+
+// NOTE: A blocking socket has a single receive timeout, so it is
+//       set before every receive to what is left. The head has to
+//       be in by its deadline, the rest start over on every read.
+//       Empty once the deadline has passed, zero for no timeout.
+static Optional<u64> receive_timeout_ms(Net::ReadPhase phase,
+    Net::ConnectionLimits const& limits, u64& head_deadline)
+{
+    switch (phase) {
+    case Net::ReadPhase::Idle:
+        head_deadline = 0;
+        return limits.idle_timeout_seconds * 1000ull;
+    case Net::ReadPhase::Head: {
+        if (limits.header_timeout_seconds == 0)
+            return 0ull;
+        auto now = System::monotonic_milliseconds();
+        if (head_deadline == 0) {
+            head_deadline
+                = now + limits.header_timeout_seconds * 1000ull;
+        }
+        if (now >= head_deadline)
+            return {};
+        return head_deadline - now;
+    }
+    case Net::ReadPhase::Body:
+        return limits.body_timeout_seconds * 1000ull;
+    }
+}
+
+static ErrorOr<void> set_socket_timeout(int socket, int option,
+    u64 timeout_ms)
+{
+    struct timeval timeout {
+        .tv_sec = (time_t)(timeout_ms / 1000),
+        .tv_usec = (suseconds_t)(timeout_ms % 1000 * 1000),
+    };
+    TRY(System::setsockopt(socket, SOL_SOCKET, option, &timeout,
+        sizeof(timeout)));
+    return {};
+}
+
+static ErrorOr<Net::KeepAlive> handle_request(Context const& args,
+    Net::TCPConnection& client, HTTP::Request const& request,
+    Net::KeepAlive may_keep_alive)
+{
+    Defer reset_arena = [&] {
+        args.arena.reset();
+    };
+
     // clang-format off
-    auto raw_request = TRY(args.client.read());
-    args.log.writeln("\nrequest:\n"sv, raw_request.view(), "request end\n"sv).ignore();
+    args.log.writeln("\nrequest:\n"sv, request.source, "request end\n"sv).ignore();
     // clang-format on
 
-    if (raw_request.view().is_empty()) {
-        TRY(args.client.write(HTTP::Response {
-            .extra_headers = "Accept: */*\r\n"sv,
-            .code = HTTP::ResponseCode::Continue,
+    auto keep_alive = Net::KeepAlive::No;
+    if (may_keep_alive == Net::KeepAlive::Yes
+        && request.wants_keep_alive())
+        keep_alive = Net::KeepAlive::Yes;
+    auto respond = [&](HTTP::Response response) -> ErrorOr<void> {
+        response.keep_alive = keep_alive == Net::KeepAlive::Yes;
+        response.omit_body
+            = request.method.type() == HTTP::Method::Head;
+        TRY(client.write(response));
+        return {};
+    };
+    auto respond_not_found = [&]() -> ErrorOr<void> {
+        auto id = args.file_router.not_found_page();
+        if (!id.has_value()) {
+            TRY(respond(HTTP::Response {
+                .body = "not found"sv,
+                .code = HTTP::ResponseCode::NotFound,
+            }));
+            return {};
+        }
+        auto const& page = args.file_router[id.value()];
+        TRY(respond(HTTP::Response {
+            .body = page.view(),
+            .code = HTTP::ResponseCode::NotFound,
+            .body_fd = page.fd(),
+            .head = page.headers(),
         }));
         return {};
+    };
+
+    auto allowed_methods = "Allow: GET, HEAD, POST, OPTIONS\r\n"sv;
+    switch (request.method.type()) {
+    case HTTP::Method::Get:
+    case HTTP::Method::Head:
+    case HTTP::Method::Post:
+        break;
+    case HTTP::Method::Options:
+        TRY(respond(HTTP::Response {
+            .extra_headers = allowed_methods,
+            .code = HTTP::ResponseCode::Ok,
+        }));
+        return keep_alive;
+    case HTTP::Method::Put:
+    case HTTP::Method::Delete:
+        TRY(respond(HTTP::Response {
+            .body = "method not allowed"sv,
+            .extra_headers = allowed_methods,
+            .code = HTTP::ResponseCode::MethodNotAllowed,
+        }));
+        return keep_alive;
     }
 
-    auto headers
-        = TRY(HTTP::Headers::create_from(raw_request.view()));
-    if (auto maybe_post = TRY(headers.post()); maybe_post) {
-        auto post = maybe_post.value();
-        if (auto id = args.dynamic_router.find(post.slug); id) {
+    if (request.method.type() == HTTP::Method::Post) {
+        if (auto id = args.dynamic_router.find(request.slug); id) {
             auto route = args.dynamic_router[id.value()];
-            auto error_buffer = TRY(StringBuffer::create());
+            auto error_buffer
+                = TRY(StringBuffer::create(args.arena));
             // clang-format off
-            TRY(args.client.write(TRY(route(headers).or_else([&](auto error) -> ErrorOr<HTTP::Response> {
+            TRY(respond(TRY(route(request).or_else([&](auto error) -> ErrorOr<HTTP::Response> {
                 error_buffer.clear();
                 TRY(error_buffer.write(error));
                 return HTTP::Response {
@@ -163,47 +633,61 @@ static ErrorOr<void> handle_connection(Connection const& args)
                 };
             }))));
             // clang-format on 
-            return {};
+            return keep_alive;
         }
 
-        auto not_found_path = TRY(StringBuffer::create_fill(args.static_folder_path, "/error/404.html"sv));
-        auto not_found_file = TRY(Web::File::open(not_found_path.view()));
-        TRY(args.client.write(HTTP::Response {
-            .body = not_found_file.view(),
-            .mime_type = not_found_file.mime_type(),
-            .code = HTTP::ResponseCode::NotFound,
-        }));
-        return {};
+        TRY(respond_not_found());
+        return keep_alive;
     }
 
-    auto maybe_get = TRY(headers.get());
-    if (!maybe_get.has_value()) {
-        TRY(args.client.write(HTTP::Response {
-            .body = "not found"sv,
-            .code = HTTP::ResponseCode::NotFound,
-        }));
-        return {};
-    }
-    auto get = maybe_get.release_value();
-    TRY(args.log.writeln("parsed get: "sv, get));
+    TRY(args.log.writeln("parsed request: "sv, request));
 
-    if (auto id = args.file_router.find(get.slug); id) {
-        TRY(args.file_router.reload_files_if_needed(args.log));
+    if (auto id = args.file_router.find(request.slug); id) {
         auto const& file = args.file_router[id.value()];
-        TRY(args.client.write(HTTP::Response {
+
+        auto const* encoded = file.encoded_for(request);
+        auto etag
+            = encoded != nullptr ? encoded->etag() : file.etag();
+        if (request.has_current_copy(etag, file.last_modified())) {
+            TRY(respond(HTTP::Response {
+                .code = HTTP::ResponseCode::NotModified,
+                .head = encoded != nullptr
+                    ? encoded->validator_headers()
+                    : file.validator_headers(),
+            }));
+            return keep_alive;
+        }
+        if (encoded != nullptr) {
+            TRY(respond(HTTP::Response {
+                .body = encoded->view(),
+                .body_fd = encoded->fd(),
+                .head = encoded->headers(),
+            }));
+            return keep_alive;
+        }
+        if (request.wants_range(etag, file.last_modified())) {
+            auto ranges = HTTP::ByteRanges::parse(
+                request.header(HTTP::Header::Range),
+                file.view().size);
+            if (ranges.status != HTTP::ByteRanges::Status::Whole) {
+                TRY(respond_ranges(args.arena, client, file, ranges,
+                    keep_alive == Net::KeepAlive::Yes));
+                return keep_alive;
+            }
+        }
+        TRY(respond(HTTP::Response {
             .body = file.view(),
-            .charset = file.charset(),
-            .mime_type = file.mime_type(),
-            .code = HTTP::ResponseCode::Ok,
+            .body_fd = file.fd(),
+            .head = file.headers(),
         }));
-        return {};
+        return keep_alive;
     }
 
-    if (auto id = args.dynamic_router.find(get.slug); id) {
+    if (auto id = args.dynamic_router.find(request.slug); id) {
         auto route = args.dynamic_router[id.value()];
-        auto error_buffer = TRY(StringBuffer::create());
+        auto error_buffer = TRY(StringBuffer::create(args.arena));
         // clang-format off
-        TRY(args.client.write(TRY(route(headers).or_else([&](auto error) -> ErrorOr<HTTP::Response> {
+        TRY(respond(TRY(route(request).or_else([&](auto error) -> ErrorOr<HTTP::Response> {
             error_buffer.clear();
             TRY(error_buffer.write(error));
             return HTTP::Response {
@@ -217,18 +701,107 @@ static ErrorOr<void> handle_connection(Connection const& args)
             };
         }))));
         // clang-format on 
+        return keep_alive;
+    }
+
+    TRY(respond_not_found());
+    return keep_alive;
+};
+
+static ErrorOr<void> respond_ranges(Arena& arena,
+    Net::TCPConnection& client, Web::File const& file,
+    HTTP::ByteRanges const& ranges, bool keep_alive)
+{
+    auto size = file.view().size;
+    auto head = TRY(StringBuffer::create(arena));
+    if (ranges.status == HTTP::ByteRanges::Status::Unsatisfiable) {
+        TRY(head.write("Content-Range: bytes */"sv, size,
+            "\r\n"sv));
+        TRY(client.write(HTTP::Response {
+            .body = "range not satisfiable"sv,
+            .extra_headers = head.view(),
+            .code = HTTP::ResponseCode::RangeNotSatisfiable,
+            .keep_alive = keep_alive,
+        }));
         return {};
     }
 
-    auto not_found_path = TRY(StringBuffer::create_fill(args.static_folder_path, "/error/404.html"sv));
-    auto not_found_file = TRY(Web::File::open(not_found_path.view()));
-    TRY(args.client.write(HTTP::Response {
-        .body = not_found_file.view(),
-        .mime_type = not_found_file.mime_type(),
-        .code = HTTP::ResponseCode::NotFound,
+    auto write_content_type
+        = [&](StringBuffer& to) -> ErrorOr<void> {
+        TRY(to.write("Content-Type: "sv, file.mime_type()));
+        if (!file.charset().is_empty())
+            TRY(to.write("; charset="sv, file.charset()));
+        TRY(to.write("\r\n"sv));
+        return {};
+    };
+    auto write_content_range = [&](StringBuffer& to,
+                                   HTTP::ByteRange range) {
+        return to.write("Content-Range: bytes "sv, range.start,
+            "-"sv, range.end - 1, "/"sv, size, "\r\n"sv);
+    };
+
+    // NOTE: Slices are sent straight out of the mapping, or from
+    //       the file with sendfile(2) when they are large.
+    if (ranges.count == 1) {
+        auto range = ranges.ranges[0];
+        TRY(write_content_type(head));
+        TRY(head.write("Content-Length: "sv, range.size(),
+            "\r\n"sv));
+        TRY(write_content_range(head, range));
+        TRY(head.write(file.validator_headers()));
+        TRY(client.write(HTTP::Response {
+            .body = file.view().part(range.start, range.end),
+            .code = HTTP::ResponseCode::PartialContent,
+            .keep_alive = keep_alive,
+            .body_fd = file.fd(),
+            .body_offset = range.start,
+            .head = head.view(),
+        }));
+        return {};
+    }
+
+    // NOTE: The boundary is the file's ETag, which the parts can
+    //       not contain, as they would have to contain their own
+    //       hash.
+    auto boundary = file.etag().shrink_from_start(1).shrink(1);
+    auto part_heads = TRY(StringBuffer::create(arena));
+    u32 part_head_ends[HTTP::ByteRanges::max_count];
+    // NOTE: Ranges may overlap, so a few of a large file add up to
+    //       more than it holds.
+    u64 content_length = 0;
+    for (u32 i = 0; i < ranges.count; i++) {
+        TRY(part_heads.write("\r\n--"sv, boundary, "\r\n"sv));
+        TRY(write_content_type(part_heads));
+        TRY(write_content_range(part_heads, ranges.ranges[i]));
+        TRY(part_heads.write("\r\n"sv));
+        part_head_ends[i] = part_heads.size();
+        content_length += ranges.ranges[i].size();
+    }
+    auto closing = TRY(StringBuffer::create(arena));
+    TRY(closing.write("\r\n--"sv, boundary, "--\r\n"sv));
+    content_length += part_heads.size() + closing.size();
+
+    TRY(head.write("Content-Type: multipart/byteranges; "sv,
+        "boundary="sv, boundary, "\r\nContent-Length: "sv,
+        content_length, "\r\n"sv, file.validator_headers()));
+    TRY(client.write(HTTP::Response {
+        .code = HTTP::ResponseCode::PartialContent,
+        .keep_alive = keep_alive,
+        .head = head.view(),
     }));
+    u32 part_head_start = 0;
+    for (u32 i = 0; i < ranges.count; i++) {
+        auto range = ranges.ranges[i];
+        TRY(client.write(part_heads.view().part(part_head_start,
+            part_head_ends[i])));
+        TRY(client.write_body(file.view().part(range.start,
+                                  range.end),
+            file.fd(), range.start));
+        part_head_start = part_head_ends[i];
+    }
+    TRY(client.write(closing.view()));
     return {};
-};
+}
 
 static ErrorOr<void> setup_zombie_reaper()
 {
@@ -247,3 +820,44 @@ static ErrorOr<void> setup_zombie_reaper()
     return {};
 }
 
+static ErrorOr<void> raise_open_file_limit()
+{
+    auto limit = TRY(System::getrlimit(RLIMIT_NOFILE));
+    limit.rlim_cur = limit.rlim_max;
+    TRY(System::setrlimit(RLIMIT_NOFILE, limit));
+    return {};
+}
+
+static void log_stats(Core::File& log)
+{
+    auto memory = memory_stats();
+    log.writeln("memory: "sv, memory.allocations - memory.frees,
+           " allocations, "sv, memory.small_bytes_in_use / 1024,
+           " KiB small, "sv, memory.large_bytes_in_use / 1024,
+           " KiB large, "sv, memory.cached_bytes / 1024,
+           " KiB cached, "sv, memory.heap_bytes / 1024,
+           " KiB heap"sv)
+        .ignore();
+
+    auto buffers = Net::BufferPool::stats();
+    log.writeln("buffers: "sv, buffers.taken - buffers.given_back,
+           " held, "sv, buffers.bytes_in_use / 1024,
+           " KiB in use, "sv, buffers.cached_bytes / 1024,
+           " KiB cached, "sv, buffers.mapped_bytes / 1024,
+           " KiB mapped, "sv, buffers.overflows, " overflows"sv)
+        .ignore();
+}
+
+// NOTE: From a thread of its own, so it keeps time however busy
+//       the workers are. The numbers are for the whole process.
+static ErrorOr<void> start_logging_stats(Core::File& log)
+{
+    auto thread = TRY(Core::Thread::spawn([&log] {
+        while (true) {
+            System::sleep(stats_interval_seconds);
+            log_stats(log);
+        }
+    }));
+    TRY(thread.detach());
+    return {};
+}